@@ -25,4 +25,7 @@ if(NOT ${Common_Proj} STREQUAL "_PRELOAD_")
         ImagineAppendProperty(${Common_Proj} COMPILE_FLAGS
                               -DSRCDIR=\"${CMAKE_CURRENT_SOURCE_DIR}\")
     endif()
+    # Parallel loops (Parallel.h)
+    find_package(Threads)
+    target_link_libraries(${Common_Proj} ${CMAKE_THREAD_LIBS_INIT})
 endif()
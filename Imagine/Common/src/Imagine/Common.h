@@ -16,14 +16,45 @@
 #include <iostream>
 #include <cstdio>
 #include <cstdlib>
+#include <cstdint>
 #include <fstream>
 #include <iterator>
 #include <algorithm>
 #include <list>
 #include <ctime>
+#include <new>
+#include <atomic>
+#include <utility>
+#include <type_traits>
+#include <cstddef>
+#include <vector>
+#include <complex>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <chrono>
+#include <iomanip>
+#include <typeinfo>
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+#if !defined(IMAGINE_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2))
+#define IMAGINE_SSE2
+#include <emmintrin.h>
+#endif
+#if !defined(IMAGINE_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define IMAGINE_DISPATCH        // kernels compiled for several instruction sets (see Cpu)
+#endif
 #if !_WIN32
 #include <sys/times.h>
 #include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
 #endif
 
 #ifdef _WIN32
@@ -43,14 +74,23 @@ namespace Imagine {
 
 #include "Common/Base.h"       // Common
 #include "Common/FArray.h"     // Fixed Arrays (static allocation)
+#include "Common/Simd.h"       // SIMD kernels of fixed vectors and matrices
+#include "Common/Cpu.h"        // Runtime CPU dispatch
 #include "Common/FVector.h"    // Fixed vectors (static allocation)
 #include "Common/FMatrix.h"    // Fixed matrices (static allocation)
 #include "Common/Color.h"      // Colors
+#include "Common/Parallel.h"   // Thread pool, parallel loops and reductions
+#include "Common/Binary.h"     // Binary file format
+#include "Common/Memory.h"     // Memory statistics
+#include "Common/Reduce.h"     // Reductions (sums, ranges)
 #include "Common/Array.h"      // Arrays (referenced counted)
 #include "Common/Coords.h"     // nD coordinates (for MultiArrays)
 #include "Common/MultiArray.h" // nD arrays (referenced counted)
+#include "Common/FFT.h"        // Fast Fourier transforms
+#include "Common/PointSet.h"   // Sets of points (structure of arrays)
 #include "Common/Random.h"     // Random
 #include "Common/Timer.h"      // Timer
+#include "Common/Text.h"       // Text format of arrays
 #include "Common/IO.h"         // IO
 
 # endif
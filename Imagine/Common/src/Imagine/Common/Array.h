@@ -4,10 +4,40 @@
 // For detailed information: http://imagine.enpc.fr/software
 // ===========================================================================
 
+/// \def IMAGINE_ARRAY_ALIGNMENT
+/// Alignment of Array memory.
+/// Memory allocated by Array (and thus MultiArray, Image, Matrix, Vector...) starts at an address multiple of this
+/// number of bytes (a power of 2, default=64, i.e. a cache line and any SIMD register size).
+/// Define it before including Imagine headers (e.g. with -DIMAGINE_ARRAY_ALIGNMENT=32) to change it.
+/// Pre-allocated memory given to constructors is used as is.
+#ifndef IMAGINE_ARRAY_ALIGNMENT
+#define IMAGINE_ARRAY_ALIGNMENT 64
+#endif
+
 namespace Imagine {
     /// \addtogroup Common
     /// @{
 
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    static_assert(IMAGINE_ARRAY_ALIGNMENT>0 && (IMAGINE_ARRAY_ALIGNMENT&(IMAGINE_ARRAY_ALIGNMENT-1))==0,
+                  "IMAGINE_ARRAY_ALIGNMENT must be a power of 2");
+
+    // Control block shared by all Arrays using the same memory.
+    // When Array allocates memory itself, block and elements come from a single allocation (block
+    // immediately before the aligned elements, mem being the start of the allocation). For pre-allocated
+    // memory handed over with handleDelete=true, the block is allocated alone. The counter is atomic so
+    // that Arrays sharing memory may live in different threads.
+    struct ArrayBlock {
+        std::atomic<int> count;             // reference counter
+        void* data;                         // first element
+        size_t size;                        // number of elements
+        void (*release)(ArrayBlock* b);     // frees elements and block once count drops to 0
+        void* mem;                          // start of the allocation (single allocation only)
+        MemoryRecord* record;               // MemoryStats record of the allocation (0 if not counted)
+
+        ArrayBlock(void* d, size_t s, void (*r)(ArrayBlock*), void* m=0, MemoryRecord* rec=0) : count(1), data(d), size(s), release(r), mem(m), record(rec) {}
+    };
+#endif
 
     /// \headerfile Imagine/Common.h "Imagine/Common.h"
     /// %Array of variable size.
@@ -16,12 +46,46 @@ namespace Imagine {
     /// - the last object using memory frees it when it dies
     /// - use clone() when this sharing is not desired
     ///
+    /// The reference counter is atomic and lives in the same allocation as the elements: arrays sharing
+    /// memory may be copied and destroyed from different threads (concurrent accesses to the elements
+    /// themselves still have to be synchronized by the user).
+    ///
+    /// Allocated memory is aligned on IMAGINE_ARRAY_ALIGNMENT bytes.
+    ///
     /// \param T value type 
     template <typename T> class Array {
     private:
-        int* _count;    // pointer to reference counter
-        T *_data;       // pointer to data
-        size_t _size;   // size of array
+        ArrayBlock* _block; // control block (0 if memory is not handled by Array)
+        T *_data;           // pointer to data
+        size_t _size;       // size of array
+        // Bytes of a single allocation of size elements
+        static size_t allocSize(size_t size)
+        {
+            return sizeof(ArrayBlock)+alignment()-1+size*sizeof(T);
+        }
+        // Frees a single allocation block+elements
+        static void releaseSingle(ArrayBlock* b)
+        {
+            T* p = static_cast<T*>(b->data);
+            for (size_t i=b->size; i>0; i--)
+                p[i-1].~T();
+            memoryFree(b->record,allocSize(b->size));
+            void* mem = b->mem;
+            b->~ArrayBlock();
+            ::operator delete(mem);
+        }
+        // Frees pre-allocated memory given with handleDelete=true
+        static void releaseExternal(ArrayBlock* b)
+        {
+            delete[] static_cast<T*>(b->data);
+            delete b;
+        }
+        // Unmaps a file mapping (b->mem) ending with the elements
+        static void releaseMapping(ArrayBlock* b)
+        {
+            unmapFile(b->mem,static_cast<char*>(b->data)-static_cast<char*>(b->mem)+b->size*sizeof(T));
+            delete b;
+        }
         // Allocates memory
         void alloc(size_t size,T* ptr=0,bool handleDelete=false) 
         {
@@ -29,43 +93,77 @@ namespace Imagine {
             if (!ptr) {
                 if (size > 0)
                 {
-                    _data= new T[size];
-                    _count=new int(1);
+                    const size_t a = alignment();
+                    MemoryRecord* record = memoryAlloc<T>(allocSize(size));
+                    char* raw;
+                    try {
+                        raw = static_cast<char*>(::operator new(allocSize(size)));
+                    } catch (...) {
+                        memoryFree(record,allocSize(size));
+                        throw;
+                    }
+                    char* d = raw+sizeof(ArrayBlock);
+                    d += (a-reinterpret_cast<uintptr_t>(d)%a)%a;
+                    _data = reinterpret_cast<T*>(d);
+                    size_t i=0;
+                    try {
+                        for ( ; i<size; i++)
+                            new (_data+i) T;
+                    } catch (...) {
+                        for ( ; i>0; i--)
+                            _data[i-1].~T();
+                        ::operator delete(raw);
+                        memoryFree(record,allocSize(size));
+                        throw;
+                    }
+                    _block = new (d-sizeof(ArrayBlock)) ArrayBlock(_data,size,&releaseSingle,raw,record);
                 }
                 else
                 {
                     _data = 0;
-                    _count = 0;
+                    _block = 0;
                 }
             }
             else {
                 _data=ptr;
-                _count= (handleDelete? new int(1): 0);
+                _block= (handleDelete? new ArrayBlock(ptr,size,&releaseExternal): 0);
             }
         }
         // Frees memory unless reference counter indicates other users
         void kill()
         {
-            if (!_count)
+            if (!_block)
                 return;
-            (*_count)--;
-            if (!(*_count)) {
-                delete _count;
-                delete[] _data;
-                _data = 0;
-                _count = 0;
-                _size = 0;
-            }
+            if (_block->count.fetch_sub(1,std::memory_order_acq_rel)==1)
+                _block->release(_block);
+            _block = 0;
+            _data = 0;
+            _size = 0;
         }
         // Declares myself as a new user
         void copy(const Array& A)
         {
-            _count=A._count;
+            _block=A._block;
             _data=A._data;
             _size=A._size;
-            if(_count)
-                (*_count)++;
+            if(_block)
+                _block->count.fetch_add(1,std::memory_order_relaxed);
         }
+    protected:
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+        // Constructs an array of size elements starting at A.data()+offset, sharing memory (and counter) of A
+        Array(const Array& A, size_t offset, size_t size) {
+            assert(offset+size<=A._size);
+            copy(A);
+            _data+=offset;
+            _size=size;
+        }
+        // Constructs an array of size elements stored at offset bytes of a mapping given by mapFile() and ending with
+        // them. The last user unmaps it.
+        Array(void* mem, size_t offset, size_t size) : _data(reinterpret_cast<T*>(static_cast<char*>(mem)+offset)), _size(size) {
+            _block = new ArrayBlock(_data,size,&releaseMapping,mem);
+        }
+#endif
     public:
         /// Iterator type
         typedef T* iterator;
@@ -77,7 +175,7 @@ namespace Imagine {
         ///
         /// \dontinclude Common/test/test.cpp \skip arrays()
         /// \skipline non allocated
-        Array(): _count(0), _data(0), _size(0) {}
+        Array(): _block(0), _data(0), _size(0) {}
         /// Constructor (known size).
         /// Constructs an allocated array of size variables of type T
         /// \param size array size
@@ -103,7 +201,14 @@ namespace Imagine {
         /// 
         /// \dontinclude Common/test/test.cpp \skip arrays()
         /// \skipline copy constructor
-        explicit Array(const Array& A) { copy(A); }
+        Array(const Array& A) { copy(A); }
+        /// Move constructor.
+        /// Constructs an array taking over memory of another one, which becomes empty. No reference counting involved.
+        /// \param A array to move from
+        /// 
+        /// \dontinclude Common/test/test.cpp \skip moves()
+        /// \skipline move constructor
+        Array(Array&& A) : _block(A._block), _data(A._data), _size(A._size) { A._block=0; A._data=0; A._size=0; }
         /// Constructor (different type).
         /// Constructs an array of type T from one of another type (thus without sharing memory!)
         /// \param A array to copy
@@ -151,7 +256,25 @@ namespace Imagine {
         /// 
         /// \dontinclude Common/test/test.cpp \skip arrays()
         /// \skipline assignment 
-        Array& operator = (const Array& A) { kill(); copy(A); return *this; }
+        Array& operator = (const Array& A) {
+            if (this!=&A) { kill(); copy(A); }
+            return *this;
+        }
+        /// Move assignment.
+        /// Takes over memory of another Array, which becomes empty. No reference counting involved.
+        /// \param A array to move from
+        /// \return self reference
+        /// 
+        /// \dontinclude Common/test/test.cpp \skip moves()
+        /// \skipline move assignment
+        Array& operator = (Array&& A) {
+            if (this!=&A) {
+                kill();
+                _block=A._block; _data=A._data; _size=A._size;
+                A._block=0; A._data=0; A._size=0;
+            }
+            return *this;
+        }
         /// Assignment (different type).
         /// Assign from an array of another type (thus without sharing memory!)
         /// \param A array to copy
@@ -192,6 +315,20 @@ namespace Imagine {
         /// \dontinclude Common/test/test.cpp \skip arrays()
         /// \skipline number of elements
         size_t size() const { return _size; }
+        /// Number of users.
+        /// Number of objects sharing the memory of this array (0 if memory is not handled by Array: empty array or pre-allocated memory without handleDelete)
+        /// \return reference count
+        ///
+        /// \dontinclude Common/test/test.cpp \skip moves()
+        /// \skipline number of users
+        int useCount() const { return _block ? _block->count.load(std::memory_order_relaxed) : 0; }
+        /// Alignment.
+        /// Alignment in bytes of memory allocated by Array<T> (IMAGINE_ARRAY_ALIGNMENT, or alignment of T if larger)
+        /// \return alignment
+        ///
+        /// \dontinclude Common/test/test.cpp \skip arrays()
+        /// \skipline alignment
+        static size_t alignment() { return std::max<size_t>(IMAGINE_ARRAY_ALIGNMENT,alignof(T)); }
         /// Read access.
         /// Reads i<sup>th</sup> element
         /// \param i element index (from 0 to size-1)
@@ -302,7 +439,8 @@ namespace Imagine {
             return !(*this == A);
         }
         /// Range.
-        /// Compute min and max of component values (provided comparisons are defined for type T)
+        /// Compute min and max of component values (provided comparisons are defined for type T). Large arrays are
+        /// processed in parallel.
         /// \param A input array
         /// \return pair of min,max values
         /// 
@@ -310,13 +448,8 @@ namespace Imagine {
         /// \skipline range
         /// \until ...
         friend std::pair<T,T> range(const Array& A) {   
-            const_iterator it = A.begin();
-            std::pair<T,T> r(*it,*it);
-            for ( ++it; it != A.end() ; ++it) {
-                r.first=std::min(r.first,*it);
-                r.second=std::max(r.second,*it);
-            }
-            return r;
+            return parallelReduce< std::pair<T,T> >(0,A.size(),
+                [&](size_t b, size_t e) { return reduceRange(A.data()+b,e-b); },combineRange<T>,REDUCE_GRAIN);
         }
         /// Pointwise range.
         /// Compute pointwise min and pointwise max of component values (provided pointwise comparisons are defined for type T, e.g. FVector)
@@ -327,13 +460,8 @@ namespace Imagine {
         /// \skipline pointwise range
         /// \until ...
         friend std::pair<T,T> prange(const Array& A) {  
-            const_iterator it = A.begin();
-            std::pair<T,T> r(*it,*it);
-            for ( ++it; it != A.end() ; ++it) {
-                r.first=pmin(r.first,*it);
-                r.second=pmax(r.second,*it);
-            }
-            return r;
+            return parallelReduce< std::pair<T,T> >(0,A.size(),
+                [&](size_t b, size_t e) { return reducePRange(A.data()+b,e-b); },combinePRange<T>,REDUCE_GRAIN);
         }
         /// Binary write.
         /// Writes Array to binary stream (size and values)
@@ -0,0 +1,406 @@
+// ===========================================================================
+// Imagine++ Libraries
+// Copyright (C) Imagine
+// For detailed information: http://imagine.enpc.fr/software
+// ===========================================================================
+
+namespace Imagine {
+    /// \addtogroup Common
+    /// @{
+
+    /// CRC32C.
+    /// CRC32C (Castagnoli) checksum of n bytes, as used by binary files (see saveBinary()). To checksum data given in
+    /// several parts, pass the checksum of previous parts as crc.
+    /// \param data bytes
+    /// \param n number of bytes
+    /// \param crc checksum of previous bytes (default=0)
+    /// \return checksum
+    ///
+    /// \dontinclude Common/test/test.cpp \skip io()
+    /// \skipline CRC32C
+    inline uint32_t crc32c(const void* data, size_t n, uint32_t crc=0) {
+        static const struct Table {
+            uint32_t t[256];
+            Table() {
+                for (uint32_t i=0;i<256;i++) {
+                    uint32_t c=i;
+                    for (int k=0;k<8;k++)
+                        c = (c&1) ? (c>>1)^0x82F63B78u : c>>1;
+                    t[i]=c;
+                }
+            }
+        } table;
+        const unsigned char* p=static_cast<const unsigned char*>(data);
+        crc=~crc;
+        for (size_t i=0;i<n;i++)
+            crc=table.t[(crc^p[i])&0xff]^(crc>>8);
+        return ~crc;
+    }
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    // Element type of binary files: kind of scalar (0: unknown, 1: signed integer, 2: unsigned integer, 3: floating
+    // point), its size and the number of scalars per element. Unknown types are only checked by their size.
+    template <typename T, bool=std::is_arithmetic<T>::value> struct BinaryType {
+        static const uint32_t kind=0, scalarSize=sizeof(T), components=1;
+    };
+    template <typename T> struct BinaryType<T,true> {
+        static const uint32_t kind = std::numeric_limits<T>::is_integer ? (std::numeric_limits<T>::is_signed ? 1 : 2) : 3;
+        static const uint32_t scalarSize=sizeof(T), components=1;
+    };
+    template <typename T, int S, typename B=BinaryType<T> > struct BinaryVectorType {
+        static const uint32_t kind=B::kind, scalarSize=B::scalarSize, components=S*B::components;
+    };
+    template <typename T, int S> struct BinaryType<FArray<T,S>,false> : public BinaryVectorType<T,S> {};
+    template <typename T, int S> struct BinaryType<FVector<T,S>,false> : public BinaryVectorType<T,S> {};
+    template <typename T> struct BinaryType<RGB<T>,false> : public BinaryVectorType<T,3> {};
+    template <typename T> struct BinaryType<RGBA<T>,false> : public BinaryVectorType<T,4> {};
+
+    // Header of binary files of nD arrays, followed by the values (possibly with row padding) at dataOffset.
+    // Fields are written with the byte order of the writing machine, given by byteOrder.
+    // If FLAG_COMPRESSED is set, values are stored as independent compressed chunks (see BinaryChunks).
+    struct BinaryHeader {
+        static const int MAX_DIM=16;
+        static const uint32_t VERSION=2, ORDER_MARK=0x01020304u, FLAG_CRC=1, FLAG_COMPRESSED=2;
+        static const size_t ALIGN=4096, CHUNK=1<<20;
+        char magic[8];              // "IMAGINE" followed by 0x1a
+        uint32_t version;           // format version (1, or 2 if compressed)
+        uint32_t byteOrder;         // ORDER_MARK
+        uint32_t kind;              // see BinaryType
+        uint32_t scalarSize;
+        uint32_t components;
+        uint32_t elementSize;       // bytes per element
+        uint32_t dim;               // dimension
+        uint32_t flags;             // FLAG_CRC: dataCrc is set, FLAG_COMPRESSED: values are compressed
+        uint64_t dataOffset;        // position of first value (multiple of ALIGN)
+        uint64_t dataSize;          // bytes of values (padding included, before compression)
+        int64_t sizes[MAX_DIM];     // sizes
+        uint64_t strides[MAX_DIM];  // strides, in elements (stride 0 being 1)
+        uint32_t dataCrc;           // CRC32C of values
+        uint32_t headerCrc;         // CRC32C of the previous bytes of the header
+
+        static const char* magicString() { return "IMAGINE\x1a"; }
+        // Header of an array of type T with given sizes and strides. dataCrc has to be set if needed.
+        template <typename T, int D> static BinaryHeader make(const FArray<int,D>& sz, const FArray<size_t,D>& stride, size_t dataSize, bool checksum, bool compressed=false) {
+            static_assert(D<=MAX_DIM,"Dimension too large for binary files");
+            BinaryHeader h;
+            std::memset(&h,0,sizeof(h));
+            std::memcpy(h.magic,magicString(),8);
+            h.version=compressed ? 2 : 1;
+            h.byteOrder=ORDER_MARK;
+            h.kind=BinaryType<T>::kind;
+            h.scalarSize=BinaryType<T>::scalarSize;
+            h.components=BinaryType<T>::components;
+            h.elementSize=sizeof(T);
+            h.dim=D;
+            h.flags=(checksum ? FLAG_CRC : 0)|(compressed ? FLAG_COMPRESSED : 0);
+            h.dataOffset=ALIGN;
+            h.dataSize=dataSize;
+            for (int i=0;i<D;i++) {
+                h.sizes[i]=sz[i];
+                h.strides[i]=stride[i];
+            }
+            return h;
+        }
+        void seal() { headerCrc=crc32c(this,offsetof(BinaryHeader,headerCrc)); }
+        bool hasMagic() const { return std::memcmp(magic,magicString(),8)==0; }
+        // Checks header for an array of type T and dimension D. Returns 0 if valid, an error message otherwise.
+        template <typename T, int D> const char* check() const {
+            if (!hasMagic())
+                return "not an Imagine++ binary file";
+            if (byteOrder!=ORDER_MARK)
+                return "written on a machine with another byte order";
+            if (version>VERSION)
+                return "written by a more recent version of Imagine++";
+            if (headerCrc!=crc32c(this,offsetof(BinaryHeader,headerCrc)))
+                return "corrupted header";
+            if (elementSize!=sizeof(T) || (kind!=0 && BinaryType<T>::kind!=0 &&
+                (kind!=BinaryType<T>::kind || scalarSize!=BinaryType<T>::scalarSize || components!=BinaryType<T>::components)))
+                return "wrong element type";
+            if (dim!=uint32_t(D))
+                return "wrong dimension";
+            uint64_t extent=1;
+            bool empty=false;
+            for (int i=0;i<D;i++) {
+                if (sizes[i]<0 || sizes[i]>std::numeric_limits<int>::max())
+                    return "bad sizes";
+                if ((i==0 && strides[0]!=1) || (i>0 && strides[i]<extent) ||
+                    (sizes[i]>0 && strides[i]>std::numeric_limits<uint64_t>::max()/uint64_t(sizes[i])))
+                    return "bad strides";
+                extent=strides[i]*uint64_t(sizes[i]);
+                empty=empty || sizes[i]==0;
+            }
+            if (empty)
+                extent=0;
+            // Values and file size must be addressable (no wrap around in extent*sizeof(T) or dataOffset+dataSize)
+            const uint64_t maxBytes=std::numeric_limits<size_t>::max();
+            if (extent>maxBytes/sizeof(T) || dataOffset<sizeof(BinaryHeader) || dataOffset%ALIGN!=0 ||
+                dataSize!=extent*sizeof(T) || dataOffset>maxBytes-dataSize)
+                return "bad data layout";
+            return 0;
+        }
+    };
+    static_assert(sizeof(BinaryHeader)==320,"Unexpected binary header layout");
+
+    // Byte-plane shuffle and delta coding: byte j of each element goes to plane j, planes being stored one after the
+    // other, and is replaced by its difference with byte j of the previous element. Smooth data thus gives long runs
+    // of small values (e.g. the exponent plane of floats). Trailing bytes of a partial element are kept as is.
+    template <size_t S> void shuffleDelta(const unsigned char* in, size_t m, size_t s, unsigned char* out) {
+        const size_t e = S ? S : s;     // element size, constant if S>0 for faster loops
+        unsigned char prev[256]={0};
+        for (size_t i=0;i<m;i++, in+=e)
+            for (size_t j=0;j<e;j++) {
+                out[j*m+i]=(unsigned char)(in[j]-prev[j]);
+                prev[j]=in[j];
+            }
+    }
+    template <size_t S> void unshuffleDelta(const unsigned char* in, size_t m, size_t s, unsigned char* out) {
+        const size_t e = S ? S : s;
+        unsigned char prev[256]={0};
+        for (size_t i=0;i<m;i++, out+=e)
+            for (size_t j=0;j<e;j++)
+                out[j]=prev[j]=(unsigned char)(prev[j]+in[j*m+i]);
+    }
+    inline void shuffleDelta(const unsigned char* in, size_t n, size_t elementSize, unsigned char* out) {
+        const size_t m = elementSize<=256 ? n/elementSize : 0;    // larger elements are not shuffled
+        switch (elementSize) {
+            case 1: shuffleDelta<1>(in,m,1,out); break;
+            case 2: shuffleDelta<2>(in,m,2,out); break;
+            case 4: shuffleDelta<4>(in,m,4,out); break;
+            case 8: shuffleDelta<8>(in,m,8,out); break;
+            default: shuffleDelta<0>(in,m,elementSize,out);
+        }
+        std::memcpy(out+m*elementSize,in+m*elementSize,n-m*elementSize);
+    }
+    // Inverse of shuffleDelta()
+    inline void unshuffleDelta(const unsigned char* in, size_t n, size_t elementSize, unsigned char* out) {
+        const size_t m = elementSize<=256 ? n/elementSize : 0;
+        switch (elementSize) {
+            case 1: unshuffleDelta<1>(in,m,1,out); break;
+            case 2: unshuffleDelta<2>(in,m,2,out); break;
+            case 4: unshuffleDelta<4>(in,m,4,out); break;
+            case 8: unshuffleDelta<8>(in,m,8,out); break;
+            default: unshuffleDelta<0>(in,m,elementSize,out);
+        }
+        std::memcpy(out+m*elementSize,in+m*elementSize,n-m*elementSize);
+    }
+
+    // LZ77 coding of n bytes into at most capacity bytes. Returns the coded size, or 0 if it does not fit.
+    // Sequences are a token (literal count in high 4 bits, match length-4 in low 4 bits, 15 meaning that 255-terminated
+    // extra bytes follow), the literals, and, except for the last sequence, a 2-byte match offset and the extra bytes of
+    // the match length. Matches may overlap their output, which codes runs.
+    inline size_t lzCompress(const unsigned char* in, size_t n, unsigned char* out, size_t capacity) {
+        const int HASH_BITS=14;
+        std::vector<uint32_t> table(size_t(1)<<HASH_BITS,0);
+        unsigned char* o=out;
+        unsigned char* const oend=out+capacity;
+        auto length=[&](size_t l) {  // extra bytes of a length
+            for (;l>=255;l-=255) {
+                if (o==oend)
+                    return false;
+                *o++=255;
+            }
+            if (o==oend)
+                return false;
+            *o++=(unsigned char)l;
+            return true;
+        };
+        auto sequence=[&](size_t anchor, size_t lit, size_t offset, size_t len) {
+            if (o==oend)
+                return false;
+            unsigned char& token=*o++;
+            token=(unsigned char)((std::min<size_t>(lit,15)<<4)|(offset ? std::min<size_t>(len-4,15) : 0));
+            if (lit>=15 && !length(lit-15))
+                return false;
+            if (size_t(oend-o)<lit)
+                return false;
+            std::memcpy(o,in+anchor,lit);
+            o+=lit;
+            if (!offset)
+                return true;
+            if (oend-o<2)
+                return false;
+            *o++=(unsigned char)(offset&0xff);
+            *o++=(unsigned char)(offset>>8);
+            return len-4<15 || length(len-4-15);
+        };
+        size_t i=0, anchor=0, misses=0;
+        while (i+4<=n) {
+            uint32_t v;
+            std::memcpy(&v,in+i,4);
+            uint32_t& slot=table[(v*2654435761u)>>(32-HASH_BITS)];
+            const size_t c=slot;
+            slot=uint32_t(i);
+            uint32_t w;
+            if (c<i && i-c<=0xffff && (std::memcpy(&w,in+c,4),w==v)) {
+                size_t len=4;
+                for (uint64_t x,y;i+len+8<=n && (std::memcpy(&x,in+c+len,8),std::memcpy(&y,in+i+len,8),x==y);)
+                    len+=8;
+                while (i+len<n && in[c+len]==in[i+len])
+                    len++;
+                if (!sequence(anchor,i-anchor,i-c,len))
+                    return 0;
+                i+=len;
+                anchor=i;
+                misses=0;
+            } else
+                i+=1+(misses++>>6);  // skip faster over incompressible data
+        }
+        if (!sequence(anchor,n-anchor,0,0))
+            return 0;
+        return size_t(o-out);
+    }
+    // Decoding of n bytes coded by lzCompress() into exactly m bytes. Returns false if data is corrupted.
+    inline bool lzDecompress(const unsigned char* in, size_t n, unsigned char* out, size_t m) {
+        const unsigned char* const iend=in+n;
+        unsigned char* o=out;
+        unsigned char* const oend=out+m;
+        auto length=[&](size_t& l) {
+            for (unsigned char b=255;b==255;l+=b) {
+                if (in==iend)
+                    return false;
+                b=*in++;
+            }
+            return true;
+        };
+        while (in<iend) {
+            const unsigned char token=*in++;
+            size_t lit=token>>4;
+            if ((lit==15 && !length(lit)) || size_t(iend-in)<lit || size_t(oend-o)<lit)
+                return false;
+            std::memcpy(o,in,lit);
+            in+=lit;
+            o+=lit;
+            if (in==iend)
+                break;
+            if (iend-in<2)
+                return false;
+            const size_t offset=size_t(in[0])|(size_t(in[1])<<8);
+            in+=2;
+            size_t len=(token&15)+4;
+            if (offset==0 || offset>size_t(o-out) || ((token&15)==15 && !length(len)) || size_t(oend-o)<len)
+                return false;
+            const unsigned char* s=o-offset;
+            if (offset>=len)
+                std::memcpy(o,s,len);
+            else if (offset==1)
+                std::memset(o,*s,len);
+            else
+                for (size_t k=0;k<len;k++)
+                    o[k]=s[k];
+            o+=len;
+        }
+        return o==oend;
+    }
+
+    // Compressed values of binary files, at dataOffset: chunk size (bytes of values per chunk, a multiple of the
+    // element size, the last chunk being possibly shorter), number of chunks, end of each coded chunk (from the end of
+    // this table), then the coded chunks. A chunk is coded by shuffleDelta() then lzCompress(), or stored as is if this
+    // does not make it shorter. Chunks are independent: they are coded in parallel and can be decoded one by one.
+    struct BinaryChunks {
+        uint64_t chunkSize;
+        std::vector<uint64_t> ends;
+
+        size_t count() const { return ends.size(); }
+        uint64_t tableSize() const { return 16+8*ends.size(); }
+        uint64_t begin(size_t k) const { return k ? ends[k-1] : 0; }
+        uint64_t rawSize(size_t k, uint64_t dataSize) const { return std::min(chunkSize,dataSize-k*chunkSize); }
+
+        // Codes chunk k of data (n bytes)
+        static void code(const unsigned char* data, size_t n, size_t elementSize, std::vector<unsigned char>& out) {
+            std::vector<unsigned char> tmp(n);
+            shuffleDelta(data,n,elementSize,tmp.data());
+            out.resize(n);
+            const size_t c=(n>1) ? lzCompress(tmp.data(),n,out.data(),n-1) : 0;
+            if (c)
+                out.resize(c);
+            else
+                out.assign(data,data+n);
+        }
+        // Decodes a chunk of n coded bytes into m bytes. Returns false if corrupted.
+        static bool decode(const unsigned char* in, size_t n, size_t elementSize, unsigned char* out, size_t m) {
+            if (n==m) {
+                std::memcpy(out,in,m);
+                return true;
+            }
+            std::vector<unsigned char> tmp(m);
+            if (!lzDecompress(in,n,tmp.data(),m))
+                return false;
+            unshuffleDelta(tmp.data(),m,elementSize,out);
+            return true;
+        }
+        // Codes n bytes of data, elements being of given size: table followed by chunks
+        static std::vector<unsigned char> compress(const void* data, size_t n, size_t elementSize) {
+            const unsigned char* p=static_cast<const unsigned char*>(data);
+            BinaryChunks c;
+            c.chunkSize=std::max<size_t>(1,BinaryHeader::CHUNK/elementSize)*elementSize;
+            const size_t count=size_t((n+c.chunkSize-1)/c.chunkSize);
+            std::vector<std::vector<unsigned char> > coded(count);
+            parallelFor(0,count,[&](size_t k) {
+                code(p+k*c.chunkSize,size_t(c.rawSize(k,n)),elementSize,coded[k]);
+            },1);
+            uint64_t e=0;
+            for (size_t k=0;k<count;k++)
+                c.ends.push_back(e+=coded[k].size());
+            std::vector<unsigned char> out(size_t(c.tableSize()+e));
+            uint64_t head[2]={c.chunkSize,count};
+            std::memcpy(out.data(),head,16);
+            if (count)
+                std::memcpy(out.data()+16,c.ends.data(),8*count);
+            for (size_t k=0;k<count;k++)
+                if (!coded[k].empty())
+                    std::memcpy(out.data()+size_t(c.tableSize()+c.begin(k)),coded[k].data(),coded[k].size());
+            return out;
+        }
+        // Reads table at current position of in (available bytes remaining in file). Returns false if invalid.
+        bool read(std::istream& in, const BinaryHeader& h, uint64_t available) {
+            uint64_t head[2];
+            in.read((char*)head,16);
+            chunkSize=head[0];
+            if (!in || chunkSize==0 || chunkSize%h.elementSize!=0 || head[1]!=(h.dataSize+chunkSize-1)/chunkSize ||
+                16+8*head[1]>available)
+                return false;
+            ends.resize(size_t(head[1]));
+            if (!ends.empty())
+                in.read((char*)ends.data(),std::streamsize(8*ends.size()));
+            if (!in)
+                return false;
+            for (size_t k=0;k<count();k++)
+                if (ends[k]<begin(k) || ends[k]-begin(k)>rawSize(k,h.dataSize))
+                    return false;
+            return ends.empty() || tableSize()+ends.back()<=available;
+        }
+    };
+
+    // Maps the first length bytes of a file in memory, read only: pages are copied on write, so that modifying them
+    // never modifies the file. Returns 0 if it failed (e.g. file shorter than length) or if mapping is not supported.
+    inline void* mapFile(const std::string& filename, size_t length) {
+#if !_WIN32
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd<0)
+            return 0;
+        struct stat st;
+        void* mem = 0;
+        if (::fstat(fd,&st)==0 && length>0 && uint64_t(st.st_size)>=length) {
+            mem = ::mmap(0,length,PROT_READ|PROT_WRITE,MAP_PRIVATE,fd,0);
+            if (mem==MAP_FAILED)
+                mem = 0;
+        }
+        ::close(fd);    // the mapping stays valid
+        return mem;
+#else
+        (void)filename; (void)length;
+        return 0;
+#endif
+    }
+    // Releases a mapping given by mapFile()
+    inline void unmapFile(void* mem, size_t length) {
+#if !_WIN32
+        ::munmap(mem,length);
+#else
+        (void)mem; (void)length;
+#endif
+    }
+#endif
+
+    ///@}
+}
@@ -0,0 +1,143 @@
+// ===========================================================================
+// Imagine++ Libraries
+// Copyright (C) Imagine
+// For detailed information: http://imagine.enpc.fr/software
+// ===========================================================================
+
+namespace Imagine {
+    /// \addtogroup Common
+    /// @{
+
+    /// Instruction set levels.
+    /// Levels of x86 vector instructions for which hot kernels are compiled (see Cpu)
+    enum CpuLevel {
+        CPU_BASELINE=0, ///< Instructions of the compilation target (e.g. SSE2 on x86-64)
+        CPU_AVX2=1,     ///< AVX2 (256 bits vectors)
+        CPU_AVX512=2    ///< AVX-512 F, BW, DQ and VL (512 bits vectors)
+    };
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    // Best level supported by the processor (and the OS), from CPUID
+    inline CpuLevel cpuSupported() {
+#ifdef IMAGINE_DISPATCH
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+            __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl"))
+            return CPU_AVX512;
+        if (__builtin_cpu_supports("avx2"))
+            return CPU_AVX2;
+#endif
+        return CPU_BASELINE;
+    }
+    // Current level: supported one, unless lowered by IMAGINE_CPU or Cpu::setLevel()
+    inline std::atomic<int>& cpuLevel() {
+        static std::atomic<int> level(-1);
+        return level;
+    }
+#endif
+
+    /// \headerfile Imagine/Common.h "Imagine/Common.h"
+    /// Runtime CPU dispatch.
+    /// Hot kernels of Imagine++ (reductions, blur, interpolation, color conversions) are compiled for several
+    /// instruction set levels (see CpuLevel), the best one supported by the processor being chosen at first use.
+    /// Binaries built for the baseline instruction set thus use AVX2 or AVX-512 where available. Results do not depend
+    /// on the level: kernels compute the same operations in the same order, only wider.
+    ///
+    /// Dispatch needs gcc or clang on x86 (other compilers only have CPU_BASELINE), and can be disabled by defining
+    /// IMAGINE_NO_SIMD. Environment variable IMAGINE_CPU (baseline, avx2 or avx512) or setLevel() lowers the level,
+    /// e.g. for testing or benchmarking.
+    ///
+    /// \dontinclude Common/test/test.cpp \skip cpus()
+    /// \skipline supported level
+    /// \until force a level
+    class Cpu {
+    public:
+        /// Supported level.
+        /// Best instruction set level supported by the processor
+        /// \return level
+        static CpuLevel supported() {
+            static const CpuLevel s=cpuSupported();
+            return s;
+        }
+        /// Current level.
+        /// Instruction set level used by kernels
+        /// \return level
+        static CpuLevel level() {
+            int l=cpuLevel();
+            if (l<0) {
+                l=supported();
+                if (const char* e=std::getenv("IMAGINE_CPU")) {
+                    for (int i=CPU_BASELINE;i<=CPU_AVX512;i++)
+                        if (std::strcmp(e,name(CpuLevel(i)))==0)
+                            l=std::min(l,i);
+                }
+                cpuLevel()=l;
+            }
+            return CpuLevel(l);
+        }
+        /// Force level.
+        /// Sets the instruction set level used by kernels, at most the supported one
+        /// \param l level
+        /// \return level actually set
+        static CpuLevel setLevel(CpuLevel l) {
+            const CpuLevel s=CpuLevel(std::min<int>(l,supported()));
+            cpuLevel()=s;
+            return s;
+        }
+        /// Level name.
+        /// Name of a level, as used by IMAGINE_CPU
+        /// \param l level
+        /// \return "baseline", "avx2" or "avx512"
+        static const char* name(CpuLevel l) {
+            static const char* const names[]={"baseline","avx2","avx512"};
+            return names[l];
+        }
+    };
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    // Calls f() from a function compiled for a given level. Everything f calls is inlined (flatten), thus compiled for
+    // the same level. Kernels must then only call small inline functions.
+    template <int level> struct CpuTarget {
+        template <typename F> static auto run(F& f) -> decltype(f()) { return f(); }
+    };
+#ifdef IMAGINE_DISPATCH
+    // AVX-512 implies FMA: contractions are turned off so that rounding does not depend on the level (clang ignores
+    // this attribute, -ffp-contract=off is then needed for identical results)
+#ifdef __clang__
+#define IMAGINE_NO_CONTRACT
+#else
+#define IMAGINE_NO_CONTRACT optimize("fp-contract=off"),
+#endif
+    template <> struct CpuTarget<CPU_BASELINE> {
+        template <typename F> __attribute__((flatten)) static auto run(F& f) -> decltype(f()) { return f(); }
+    };
+    template <> struct CpuTarget<CPU_AVX2> {
+        template <typename F> __attribute__((target("avx2"),flatten)) static auto run(F& f) -> decltype(f()) {
+            return f();
+        }
+    };
+    template <> struct CpuTarget<CPU_AVX512> {
+        template <typename F> __attribute__((target("avx2,avx512f,avx512bw,avx512dq,avx512vl"),IMAGINE_NO_CONTRACT flatten))
+        static auto run(F& f) -> decltype(f()) {
+            return f();
+        }
+    };
+#endif
+    // Runs kernel f() compiled for the current level (see Cpu)
+    template <typename F> auto cpuDispatch(F f) -> decltype(f()) {
+#ifdef IMAGINE_DISPATCH
+        switch (Cpu::level()) {
+        case CPU_AVX512:
+            return CpuTarget<CPU_AVX512>::run(f);
+        case CPU_AVX2:
+            return CpuTarget<CPU_AVX2>::run(f);
+        default:
+            break;
+        }
+#endif
+        return CpuTarget<CPU_BASELINE>::run(f);
+    }
+#endif
+
+    ///@}
+}
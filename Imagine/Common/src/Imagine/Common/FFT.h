@@ -0,0 +1,486 @@
+// ===========================================================================
+// Imagine++ Libraries
+// Copyright (C) Imagine
+// For detailed information: http://imagine.enpc.fr/software
+// ===========================================================================
+
+namespace Imagine {
+    /// \addtogroup Common
+    /// @{
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    // Complex product without the infinity and NaN checks of std::complex (a library call)
+    template <typename T> inline std::complex<T> fftMul(const std::complex<T>& a, const std::complex<T>& b) {
+        return std::complex<T>(a.real()*b.real()-a.imag()*b.imag(), a.real()*b.imag()+a.imag()*b.real());
+    }
+    // Plan P of size n, built at first use and kept for later ones (up to 64 sizes, the cache being then emptied, plans
+    // in use staying alive). Plans are immutable, thus shared by threads.
+    template <typename P> std::shared_ptr<const P> fftCachedPlan(size_t n) {
+        static std::mutex mutex;
+        static std::map<size_t,std::shared_ptr<const P> > plans;
+        std::lock_guard<std::mutex> l(mutex);
+        typename std::map<size_t,std::shared_ptr<const P> >::const_iterator it=plans.find(n);
+        if (it!=plans.end())
+            return it->second;
+        if (plans.size()>=64)
+            plans.clear();
+        const std::shared_ptr<const P> p(new P(n));
+        plans[n]=p;
+        return p;
+    }
+#endif
+
+    /// Size for FFT.
+    /// Smallest size at least n whose prime factors are 2, 3 and 5, for which FFTs are fastest (see FFTPlan)
+    /// \param n size
+    /// \return FFT size
+    ///
+    /// \dontinclude Common/test/test.cpp \skip ffts()
+    /// \skipline size for FFT
+    inline size_t fftSize(size_t n) {
+        for (size_t m=std::max<size_t>(n,1);;m++) {
+            size_t r=m;
+            for (size_t p=2;p<=5;p++)
+                while (r%p==0)
+                    r/=p;
+            if (r==1)
+                return m;
+        }
+    }
+
+    /// \headerfile Imagine/Common.h "Imagine/Common.h"
+    /// Complex FFT plan.
+    /// Fast Fourier transform of complex sequences of a given size n: y[k] is the sum of x[j]*exp(-2i*pi*j*k/n) (or
+    /// exp(+2i*pi*j*k/n) for the inverse transform, which is not divided by n). Mixed radix (decimation in time,
+    /// radices 4, 2, 3, 5 and others), in O(n log n) for sizes with small prime factors (see fftSize()). Plans hold
+    /// twiddle factors and are cached by get(): repeated sizes are only prepared once.
+    /// \param T scalar type (float or double)
+    ///
+    /// \dontinclude Common/test/test.cpp \skip ffts()
+    /// \skipline complex FFT plan
+    /// \until ...
+    template <typename T> class FFTPlan {
+        typedef std::complex<T> C;
+        size_t _n;
+        std::vector<size_t> _f;     // pairs (p,m): radix p and length m of sub-transforms, outermost first
+        std::vector<C> _w[2];       // twiddle factors exp(-2i*pi*k/n) (forward), exp(2i*pi*k/n) (inverse)
+        std::vector<C> _t[2];       // by stage, twiddle factors of butterfly k: w^(q*k*s), q=1..p-1 (contiguous)
+        std::vector<size_t> _o;     // offsets of stages in _t
+
+        // Combines p transforms of length m (at y, y+m...) into one, t being the twiddle factors of the stage and w
+        // all of them (taken every s)
+        void butterflies(C* y, size_t s, size_t p, size_t m, const C* t, const C* w, bool inverse) const {
+            switch (p) {
+            case 2:
+                for (size_t k=0;k<m;k++) {
+                    const C a=fftMul(y[m+k],t[k]);
+                    y[m+k]=y[k]-a;
+                    y[k]+=a;
+                }
+                return;
+            case 3: {
+                const T e=w[s*m].imag();
+                for (size_t k=0;k<m;k++) {
+                    const C s1=fftMul(y[k+m],t[2*k]), s2=fftMul(y[k+2*m],t[2*k+1]), s3=s1+s2, s0=(s1-s2)*e,
+                        a=y[k]-s3*T(.5);
+                    y[k]+=s3;
+                    y[k+m]=C(a.real()-s0.imag(),a.imag()+s0.real());
+                    y[k+2*m]=C(a.real()+s0.imag(),a.imag()-s0.real());
+                }
+                return;
+            }
+            case 4:
+                for (size_t k=0;k<m;k++) {
+                    const C s0=fftMul(y[k+m],t[3*k]), s1=fftMul(y[k+2*m],t[3*k+1]), s2=fftMul(y[k+3*m],t[3*k+2]),
+                        s3=s0+s2, s4 = inverse ? s0-s2 : s2-s0, s5=y[k]-s1, a=y[k]+s1;
+                    y[k]=a+s3;
+                    y[k+2*m]=a-s3;
+                    y[k+m]=C(s5.real()-s4.imag(),s5.imag()+s4.real());
+                    y[k+3*m]=C(s5.real()+s4.imag(),s5.imag()-s4.real());
+                }
+                return;
+            case 5: {
+                const C a=w[s*m], b=w[2*s*m];
+                for (size_t k=0;k<m;k++) {
+                    const C s0=y[k], s1=fftMul(y[k+m],t[4*k]), s2=fftMul(y[k+2*m],t[4*k+1]),
+                        s3=fftMul(y[k+3*m],t[4*k+2]), s4=fftMul(y[k+4*m],t[4*k+3]),
+                        s7=s1+s4, s10=s1-s4, s8=s2+s3, s9=s2-s3,
+                        s5=s0+s7*a.real()+s8*b.real(),
+                        s6(s10.imag()*a.imag()+s9.imag()*b.imag(),-s10.real()*a.imag()-s9.real()*b.imag()),
+                        s11=s0+s7*b.real()+s8*a.real(),
+                        s12(s9.imag()*a.imag()-s10.imag()*b.imag(),s10.real()*b.imag()-s9.real()*a.imag());
+                    y[k]=s0+s7+s8;
+                    y[k+m]=s5-s6;
+                    y[k+4*m]=s5+s6;
+                    y[k+2*m]=s11+s12;
+                    y[k+3*m]=s11-s12;
+                }
+                return;
+            }
+            default: {
+                C local[16];
+                std::vector<C> heap(p>16 ? p : 0);
+                C* x = p>16 ? &heap[0] : local;
+                for (size_t u=0;u<m;u++) {
+                    for (size_t q=0;q<p;q++)
+                        x[q]=y[u+q*m];
+                    for (size_t q=0;q<p;q++) {
+                        const size_t k=u+q*m;
+                        C a=x[0];
+                        for (size_t j=1,i=0;j<p;j++) {
+                            i+=s*k;
+                            if (i>=_n)
+                                i-=_n;
+                            a+=fftMul(x[j],w[i]);
+                        }
+                        y[k]=a;
+                    }
+                }
+            }
+            }
+        }
+        // Transform of x (every s*stride values) to y, stage g onwards
+        void work(C* y, const C* x, size_t s, size_t stride, size_t g, bool inverse) const {
+            const size_t p=_f[2*g], m=_f[2*g+1];
+            if (m==1) {
+                for (size_t k=0;k<p;k++)
+                    y[k]=x[k*s*stride];
+            } else {
+                for (size_t k=0;k<p;k++)
+                    work(y+k*m,x+k*s*stride,s*p,stride,g+1,inverse);
+            }
+            if (p>1)
+                butterflies(y,s,p,m,&_t[inverse][0]+_o[g],&_w[inverse][0],inverse);
+        }
+    public:
+        /// Constructor.
+        /// Plan of size n (prefer get(), which caches plans)
+        /// \param n size
+        explicit FFTPlan(size_t n) : _n(n) {
+            assert(n>0);
+            size_t m=n, p=4;
+            do {
+                while (m%p) {
+                    p = p==4 ? 2 : p==2 ? 3 : p+2;
+                    if (p*p>m)
+                        p=m;
+                }
+                m/=p;
+                _f.push_back(p);
+                _f.push_back(m);
+            } while (m>1);
+            const double pi=3.14159265358979323846;
+            _w[0].resize(n);
+            _w[1].resize(n);
+            for (size_t k=0;k<n;k++) {
+                const double a=-2*pi*double(k)/double(n);
+                _w[0][k]=C(T(std::cos(a)),T(std::sin(a)));
+                _w[1][k]=std::conj(_w[0][k]);
+            }
+            for (size_t g=0,s=1;g<_f.size()/2;s*=_f[2*g],g++) {
+                const size_t p=_f[2*g], m=_f[2*g+1];
+                _o.push_back(_t[0].size());
+                for (int i=0;i<2;i++)
+                    for (size_t k=0;k<m;k++)
+                        for (size_t q=1;q<p;q++)
+                            _t[i].push_back(_w[i][q*k*s]);
+            }
+            _t[0].push_back(C(0));  // non empty
+            _t[1].push_back(C(0));
+        }
+        /// Cached plan.
+        /// Plan of size n, prepared at first request of this size
+        /// \param n size
+        /// \return shared plan
+        static std::shared_ptr<const FFTPlan> get(size_t n) { return fftCachedPlan<FFTPlan>(n); }
+        /// Size.
+        /// \return size
+        size_t size() const { return _n; }
+        /// Transform.
+        /// Transform of n values x[0], x[stride]... to y[0..n-1] (y must not overlap x)
+        /// \param x input
+        /// \param y output
+        /// \param inverse inverse transform (not divided by n)
+        /// \param stride distance between input values
+        void transform(const C* x, C* y, bool inverse=false, size_t stride=1) const {
+            work(y,x,1,stride,0,inverse);
+        }
+    };
+
+    /// \headerfile Imagine/Common.h "Imagine/Common.h"
+    /// Real FFT plan.
+    /// Fast Fourier transform of real sequences of a given size n, whose transforms are Hermitian: only the n/2+1 first
+    /// values are computed. For even n, the n real values are transformed as n/2 complex ones, for about half the cost
+    /// of a complex FFT (see FFTPlan). Cached by get() as FFTPlan.
+    /// \param T scalar type (float or double)
+    ///
+    /// \dontinclude Common/test/test.cpp \skip ffts()
+    /// \skipline real FFT plan
+    /// \until ...
+    template <typename T> class RealFFTPlan {
+        typedef std::complex<T> C;
+        size_t _n;
+        std::shared_ptr<const FFTPlan<T> > _c;  // complex plan of size n/2 (even n) or n
+        std::vector<C> _w;                      // exp(-2i*pi*k/n), k<=n/4 (even n)
+    public:
+        /// Constructor.
+        /// Plan of size n (prefer get(), which caches plans)
+        /// \param n size
+        explicit RealFFTPlan(size_t n) : _n(n), _c(FFTPlan<T>::get(n%2 ? n : n/2)) {
+            const double pi=3.14159265358979323846;
+            if (n%2==0)
+                for (size_t k=0;k<=n/4;k++)
+                    _w.push_back(C(T(std::cos(2*pi*double(k)/double(n))),T(-std::sin(2*pi*double(k)/double(n)))));
+        }
+        /// Cached plan.
+        /// Plan of size n, prepared at first request of this size
+        /// \param n size
+        /// \return shared plan
+        static std::shared_ptr<const RealFFTPlan> get(size_t n) { return fftCachedPlan<RealFFTPlan>(n); }
+        /// Size.
+        /// \return size
+        size_t size() const { return _n; }
+        /// Forward transform.
+        /// Transform y[0..n/2] of x[0..n-1]
+        /// \param x input
+        /// \param y output
+        /// \param work buffer of 2n values
+        void forward(const T* x, C* y, C* work) const {
+            if (_n%2) {
+                for (size_t k=0;k<_n;k++)
+                    work[k]=C(x[k]);
+                _c->transform(work,work+_n);
+                std::copy(work+_n,work+_n+_n/2+1,y);
+                return;
+            }
+            // Even values as real parts, odd ones as imaginary ones: Z=FFT(z), then X[k]=E[k]+w^k*O[k], E and O being
+            // the transforms of even and odd values (E[k]=(Z[k]+conj(Z[N-k]))/2, O[k]=-i*(Z[k]-conj(Z[N-k]))/2)
+            const size_t N=_n/2;
+            for (size_t k=0;k<N;k++)
+                work[k]=C(x[2*k],x[2*k+1]);
+            _c->transform(work,y);
+            const C z=y[0];
+            y[0]=C(z.real()+z.imag());
+            y[N]=C(z.real()-z.imag());
+            for (size_t k=1;2*k<=N;k++) {
+                const C a=y[k], b=std::conj(y[N-k]), e=(a+b)*T(.5), d=(a-b)*T(.5), o(d.imag(),-d.real()),
+                    wo=fftMul(_w[k],o);
+                y[k]=e+wo;
+                y[N-k]=std::conj(e-wo);
+            }
+        }
+        /// Inverse transform.
+        /// Real sequence x[0..n-1] whose transform is X[0..n/2], times n
+        /// \param X input
+        /// \param x output
+        /// \param work buffer of 2n values
+        void inverse(const C* X, T* x, C* work) const {
+            if (_n%2) {
+                for (size_t k=0;k<_n;k++)
+                    work[k] = 2*k<=_n ? X[k] : std::conj(X[_n-k]);
+                _c->transform(work,work+_n,true);
+                for (size_t k=0;k<_n;k++)
+                    x[k]=work[_n+k].real();
+                return;
+            }
+            // Z[k]=E[k]+i*O[k], E[k]=X[k]+conj(X[N-k]), O[k]=conj(w^k)*(X[k]-conj(X[N-k])) (twice the values)
+            const size_t N=_n/2;
+            for (size_t k=0;2*k<=N;k++) {
+                const C a=X[k], b=std::conj(X[N-k]), e=a+b, o=fftMul(std::conj(_w[k]),a-b);
+                work[k]=C(e.real()-o.imag(),e.imag()+o.real());
+                if (k>0 && 2*k<N) {
+                    // Same with k'=N-k: X[k']=conj(b), conj(X[N-k'])=conj(a), w^k'=-conj(w^k)
+                    const C e2=std::conj(e), o2=fftMul(_w[k],std::conj(a-b));
+                    work[N-k]=C(e2.real()-o2.imag(),e2.imag()+o2.real());
+                }
+            }
+            _c->transform(work,work+N,true);
+            for (size_t k=0;k<N;k++) {
+                x[2*k]=work[N+k].real();
+                x[2*k+1]=work[N+k].imag();
+            }
+        }
+    };
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    // Lines gathered together by fftLines()
+    const size_t FFT_BAND=8;
+    // Transforms S in place along dimensions 1 to dim-1, lines being shared among threads. Lines are reached through
+    // the strides of S, which may be padded (see MultiArray).
+    template <typename T, int dim> void fftLines(MultiArray<std::complex<T>,dim>& S, bool inverse) {
+        typedef std::complex<T> C;
+        for (int d=1;d<dim;d++) {
+            const size_t n=size_t(S.size(d)), st=S.stride(d), lines=S.totalSize()/n;
+            // Line l starts at coordinates l%inner along dimensions 0 to d-1 and l/inner along the following ones,
+            // runs of adjacent lines being contiguous in memory
+            size_t inner=1, run=size_t(S.size(0));
+            for (int i=0;i<d;i++)
+                inner*=size_t(S.size(i));
+            for (int i=1;i<d && S.stride(i)==run;i++)
+                run*=size_t(S.size(i));
+            const std::shared_ptr<const FFTPlan<T> > plan=FFTPlan<T>::get(n);
+            C* s=S.data();
+            // Adjacent lines are gathered by bands of FFT_BAND, so that strided reads stay in cache
+            parallelForRanges(0,lines,[&](size_t b, size_t e) {
+                std::vector<C> x(n*FFT_BAND), y(n);
+                for (size_t l=b;l<e;) {
+                    const size_t w=std::min(std::min(e-l,run-l%run),FFT_BAND);
+                    Coords<dim> c(0);
+                    size_t u=l%inner, o=l/inner;
+                    for (int i=0;i<dim;i++) {
+                        if (i==d)
+                            continue;
+                        size_t& r = i<d ? u : o;
+                        c[i]=int(r%size_t(S.size(i)));
+                        r/=size_t(S.size(i));
+                    }
+                    C* z=s+S.offset(c);
+                    for (size_t k=0;k<n;k++)
+                        std::copy(z+k*st,z+k*st+w,&x[k*w]);
+                    for (size_t j=0;j<w;j++) {
+                        plan->transform(&x[j],&y[0],inverse,w);
+                        for (size_t k=0;k<n;k++)
+                            z[k*st+j]=y[k];
+                    }
+                    l+=w;
+                }
+            });
+        }
+    }
+    // Transform of a, zero padded to sizes m (m[0]/2+1 values along x)
+    template <typename T, int dim> MultiArray<std::complex<T>,dim> fftForward(const MultiArray<T,dim>& a, const Coords<dim>& m) {
+        typedef std::complex<T> C;
+        Coords<dim> sz=m;
+        sz[0]=m[0]/2+1;
+        MultiArray<C,dim> S(sz);
+        const std::shared_ptr<const RealFFTPlan<T> > plan=RealFFTPlan<T>::get(size_t(m[0]));
+        const Coords<dim> as=a.sizes();
+        S.parallelForEachRow([&](C* y, size_t, const Coords<dim>& c) {
+            bool inside=true;
+            for (int i=1;i<dim;i++)
+                inside = inside && c[i]<as[i];
+            if (!inside) {
+                std::fill(y,y+sz[0],C(0));
+                return;
+            }
+            thread_local std::vector<T> x;
+            thread_local std::vector<C> work;
+            x.assign(size_t(m[0]),T(0));
+            work.resize(2*size_t(m[0]));
+            std::copy(&a(c),&a(c)+as[0],x.begin());
+            plan->forward(&x[0],y,&work[0]);
+        });
+        fftLines(S,false);
+        return S;
+    }
+    // Real array of sizes m whose transform is S, times m.prod() (S is modified)
+    template <typename T, int dim> MultiArray<T,dim> fftBackward(MultiArray<std::complex<T>,dim>& S, const Coords<dim>& m) {
+        typedef std::complex<T> C;
+        fftLines(S,true);
+        MultiArray<T,dim> a(m);
+        const std::shared_ptr<const RealFFTPlan<T> > plan=RealFFTPlan<T>::get(size_t(m[0]));
+        a.parallelForEachRow([&](T* x, size_t, const Coords<dim>& c) {
+            thread_local std::vector<C> work;
+            work.resize(2*size_t(m[0]));
+            plan->inverse(&S(c),x,&work[0]);
+        });
+        return a;
+    }
+    // Circular convolution of a and b zero padded to sizes m
+    template <typename T, int dim> MultiArray<T,dim> fftConvolution(const MultiArray<T,dim>& a, const MultiArray<T,dim>& b, const Coords<dim>& m) {
+        typedef std::complex<T> C;
+        MultiArray<C,dim> A=fftForward(a,m);
+        const MultiArray<C,dim> B=fftForward(b,m);
+        const T s=T(1)/T(m.prod());
+        C* p=A.data();
+        const C* q=B.data();
+        parallelForRanges(0,A.totalSize(),[&](size_t b, size_t e) {
+            for (size_t i=b;i<e;i++)
+                p[i]=fftMul(p[i],q[i])*s;
+        });
+        return fftBackward(A,m);
+    }
+    // Smallest FFT sizes at least s, even along x (see RealFFTPlan)
+    template <int dim> Coords<dim> fftSizes(const Coords<dim>& s) {
+        Coords<dim> m;
+        for (int i=0;i<dim;i++)
+            m[i]=int(i==0 ? 2*fftSize((size_t(s[i])+1)/2) : fftSize(size_t(s[i])));
+        return m;
+    }
+    // Sizes for convolving arrays of sizes sa and sb by FFT (without overlap of circular convolution)
+    template <int dim> Coords<dim> fftSizes(const Coords<dim>& sa, const Coords<dim>& sb) {
+        return fftSizes<dim>(sa+sb-Coords<dim>(1));
+    }
+    // Relative cost of FFT convolutions (per element and log2 of size), compared to one product of a direct one
+    const double FFT_COST=4.5;
+    // Whether convolving by FFT at sizes m is faster than n direct sums of k products
+    template <int dim> bool fftFaster(double n, double k, const Coords<dim>& m) {
+        const double s=double(m.prod());
+        return n*k > FFT_COST*s*std::log2(s);
+    }
+    // Part [offset,offset+nc) of the full convolution of 1D arrays a and b, by FFT if faster (otherwise returns false,
+    // as for types other than float and double)
+    template <typename T> inline bool fftConvolve(const T*, size_t, const T*, size_t, T*, size_t, size_t) { return false; }
+    template <typename T> bool fftConvolveReal(const T* a, size_t na, const T* b, size_t nb, T* c, size_t offset, size_t nc) {
+        const Coords<1> sa=Coords<1>(int(na)), sb=Coords<1>(int(nb)), m=fftSizes(sa,sb);
+        if (!fftFaster(double(nc),double(std::min(na,nb)),m))
+            return false;
+        const MultiArray<T,1> A(const_cast<T*>(a),sa), B(const_cast<T*>(b),sb), R=fftConvolution(A,B,m);
+        std::copy(R.data()+offset,R.data()+offset+nc,c);
+        return true;
+    }
+    inline bool fftConvolve(const float* a, size_t na, const float* b, size_t nb, float* c, size_t offset, size_t nc) {
+        return fftConvolveReal(a,na,b,nb,c,offset,nc);
+    }
+    inline bool fftConvolve(const double* a, size_t na, const double* b, size_t nb, double* c, size_t offset, size_t nc) {
+        return fftConvolveReal(a,na,b,nb,c,offset,nc);
+    }
+#endif
+
+    /// FFT of a real array.
+    /// Discrete Fourier transform of real nD array a, by FFTs along each dimension (rows with RealFFTPlan, other
+    /// lines with FFTPlan, in parallel, see Parallel). The transform being Hermitian, only a.size(0)/2+1 values are
+    /// computed along x.
+    /// \param a real array (float or double)
+    /// \return transform, of sizes (a.size(0)/2+1, a.size(1),...)
+    ///
+    /// \dontinclude Common/test/test.cpp \skip ffts()
+    /// \skipline FFT of a real array
+    template <typename T, int dim> MultiArray<std::complex<T>,dim> fft(const MultiArray<T,dim>& a) {
+        return fftForward(a,a.sizes());
+    }
+    /// Inverse FFT of a real array.
+    /// Real array of size n along x (and the sizes of A along other dimensions) whose transform is A (see fft())
+    /// \param A transform
+    /// \param n size along x (A.size(0) must be n/2+1)
+    /// \return real array
+    ///
+    /// \dontinclude Common/test/test.cpp \skip ffts()
+    /// \skipline inverse FFT
+    template <typename T, int dim> MultiArray<T,dim> inverseFFT(const MultiArray<std::complex<T>,dim>& A, int n) {
+        assert(A.size(0)==n/2+1);
+        Coords<dim> m=A.sizes();
+        m[0]=n;
+        MultiArray<std::complex<T>,dim> S=A.clone();
+        MultiArray<T,dim> a=fftBackward(S,m);
+        const T s=T(1)/T(m.prod());
+        T* p=a.data();
+        for (size_t i=0;i<a.totalSize();i++)
+            p[i]*=s;
+        return a;
+    }
+    /// Convolution by FFT.
+    /// Full convolution of real nD arrays a and b (float or double), computed by FFTs of the arrays zero padded to
+    /// sizes with small prime factors (see fftSize()), in O(N log N) instead of O(a.totalSize()*b.totalSize()).
+    /// \param a,b arrays
+    /// \return convolution, of sizes a.sizes()+b.sizes()-1
+    ///
+    /// \dontinclude Common/test/test.cpp \skip ffts()
+    /// \skipline convolution by FFT
+    template <typename T, int dim> MultiArray<T,dim> fftConvolve(const MultiArray<T,dim>& a, const MultiArray<T,dim>& b) {
+        const Coords<dim> sz=a.sizes()+b.sizes()-Coords<dim>(1);
+        return fftConvolution(a,b,fftSizes(a.sizes(),b.sizes())).getSubArray(Coords<dim>(0),sz);
+    }
+
+    ///@}
+}
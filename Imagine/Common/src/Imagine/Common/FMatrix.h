@@ -400,10 +400,9 @@ namespace Imagine {
         /// \skipline matrix * matrix
         template <int O>
         FMatrix<T,M,O> operator * (const FMatrix<T,N,O>& B) const {
-            FMatrix<T,M,O> C(T(0));
-            for (int j=0;j<O;j++) for (int i=0;i<M;i++) {
-                for (int k=0;k<N;k++) C(i,j) += (*this)(i,k) * B(k,j);
-            }
+            FMatrix<T,M,O> C;
+            for (int j=0;j<O;j++)
+                FMatrixOps<T,M,N>::mulVec(C.data()+M*j,this->data(),B.data()+N*j);
             return C;
         }
         /// Product with vector.
@@ -414,9 +413,8 @@ namespace Imagine {
         /// \dontinclude Common/test/test.cpp \skip fMatrices()
         /// \skipline matrix * vector
         FVector<T,M> operator * (const FVector<T,N>& v) const {
-            FVector<T,M> w(T(0));
-            for (int j=0;j<N;j++)
-                for (int i=0;i<M;i++) w[i] += (*this)(i,j) * v[j];
+            FVector<T,M> w;
+            FMatrixOps<T,M,N>::mulVec(w.data(),this->data(),v.data());
             return w;
         }
         /// Get column.
@@ -146,8 +146,7 @@ namespace Imagine {
         /// \skipline +
         FVector operator + (const FVector& v) const {
             FVector w;
-            for (int i=0;i<dim;i++)
-                w[i]=(*this)[i]+v[i];
+            FVectorOps<T,dim>::add(w.data(),this->data(),v.data());
             return w;
         }
         /// Substraction.
@@ -159,8 +158,7 @@ namespace Imagine {
         /// \skipline -
         FVector operator - (const FVector& v) const {
             FVector w;
-            for (int i=0;i<dim;i++)
-                w[i]=(*this)[i]-v[i];
+            FVectorOps<T,dim>::sub(w.data(),this->data(),v.data());
             return w;
         }
         /// In place Addition.
@@ -171,8 +169,7 @@ namespace Imagine {
         /// \dontinclude Common/test/test.cpp \skip fVectors()
         /// \skipline +=
         FVector& operator += (const FVector& v) {
-            for (int i=0;i<dim;i++)
-                (*this)[i] += v[i];
+            FVectorOps<T,dim>::add(this->data(),this->data(),v.data());
             return *this;
         }
         /// In place Substraction.
@@ -183,8 +180,7 @@ namespace Imagine {
         /// \dontinclude Common/test/test.cpp \skip fVectors()
         /// \skipline -=
         FVector& operator -= (const FVector& v) {
-            for (int i=0;i<dim;i++)
-                (*this)[i] -= v[i];
+            FVectorOps<T,dim>::sub(this->data(),this->data(),v.data());
             return *this;
         }
         /// Scalar Addition.
@@ -257,10 +253,7 @@ namespace Imagine {
         /// \dontinclude Common/test/test.cpp \skip fVectors()
         /// \skipline scalar product
         T operator * (const FVector& v) const {
-            T s=0;
-            for (int i=0;i<dim;i++)
-                s+=(*this)[i]*v[i];
-            return s;
+            return FVectorOps<T,dim>::dot(this->data(),v.data());
         }
         /// 2D cross product.
         /// Scalar Cross product of 2D FVector (dim must be 2)
@@ -283,9 +276,7 @@ namespace Imagine {
         FVector<T,3> operator ^ (const FVector<T,3>& v) const {
             assert(dim==3);
             FVector<T,3> w;
-            w[0]=(*this)[1]*v[2]-(*this)[2]*v[1];
-            w[1]=(*this)[2]*v[0]-(*this)[0]*v[2];
-            w[2]=(*this)[0]*v[1]-(*this)[1]*v[0];
+            FVectorOps<T,3>::cross(w.data(),this->data(),v.data());
             return w;
         }
         /// Scalar multiplication.
@@ -297,8 +288,7 @@ namespace Imagine {
         /// \skipline * scalar
         FVector operator*(T s) const {
             FVector v;
-            for (int i=0;i<dim;i++)
-                v[i]=(*this)[i]*s;
+            FVectorOps<T,dim>::scale(v.data(),this->data(),s);
             return v;
         }
         /// Scalar division.
@@ -322,8 +312,7 @@ namespace Imagine {
         /// \dontinclude Common/test/test.cpp \skip fVectors()
         /// \skipline *= scalar
         FVector& operator*=(T s) {
-            for (int i=0;i<dim;i++)
-                (*this)[i] *= s;
+            FVectorOps<T,dim>::scale(this->data(),this->data(),s);
             return *this;
         }
         /// Scalar in place division.
@@ -379,10 +368,7 @@ namespace Imagine {
         /// \dontinclude Common/test/test.cpp \skip fVectors()
         /// \skipline squared Euclidean norm
         friend inline T norm2(const FVector& v) {
-            T n=0;
-            for (int i=0;i<dim;i++)
-                n+=v[i]*v[i];
-            return n;
+            return FVectorOps<T,dim>::dot(v.data(),v.data());
         }
         /// Euclidean norm.
         /// Euclidean norm (NB: assuming T type is OK)
@@ -15,8 +15,100 @@ namespace Imagine {
         std::getchar();
     }
 
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    // Objects in general: operator>>() and operator<<()
+    template <typename T>
+    bool loadTextFile(T& obj, void*, const std::string& filename) {
+        std::ifstream in(filename.c_str(), std::ios::in);
+        if (!in.is_open())  {
+            std::cerr << "Error: failed to open file '" << filename << "' for reading" << std::endl;
+            return false;
+        }
+        in >> obj;
+        return (!in.fail());
+    }
+    template <typename T>
+    bool saveTextFile(const T& obj, const void*, const std::string& filename, int precision) {
+        std::ofstream out(filename.c_str(), std::ios::out);
+        if (!out.is_open()) {
+            std::cerr << "Error: failed to open file '" << filename << "' for writing" << std::endl;
+            return false;
+        }
+        if (precision>=0)
+            out.precision(precision);
+        out << obj;
+        return (!out.fail());
+    }
+    // Arrays: size and values (see textWrite() and textRead())
+    template <typename T, typename U>
+    bool loadTextFile(T& obj, Array<U>* A, const std::string& filename) {
+        if (!TextElement<U>::fast)
+            return loadTextFile(obj,(void*)A,filename);
+        TextBuffer b(filename);
+        if (!b.isOpen())
+            return false;
+        const char* p=b.begin();
+        size_t n;
+        if (!textParse(p,b.end(),n))
+            return false;
+        A->setSize(n);
+        U* d=A->data();
+        return textRead<U>(p,b.end(),n,[d](size_t i, const U& v) { d[i]=v; });
+    }
+    template <typename T, typename U>
+    bool saveTextFile(const T& obj, const Array<U>* A, const std::string& filename, int precision) {
+        if (!TextElement<U>::fast)
+            return saveTextFile(obj,(const void*)A,filename,precision);
+        std::ofstream out(filename.c_str(), std::ios::out);
+        if (!out.is_open()) {
+            std::cerr << "Error: failed to open file '" << filename << "' for writing" << std::endl;
+            return false;
+        }
+        const U* d=A->data();
+        out << A->size();
+        return textWrite<U>(out,A->size(),0,true,[d](size_t i) -> const U& { return d[i]; },precision);
+    }
+    // nD arrays: sizes and values, one row (along dimension 0) per line
+    template <typename T, typename U, int dim>
+    bool loadTextFile(T& obj, MultiArray<U,dim>* A, const std::string& filename) {
+        if (!TextElement<U>::fast)
+            return loadTextFile(obj,(void*)A,filename);
+        TextBuffer b(filename);
+        if (!b.isOpen())
+            return false;
+        const char* p=b.begin();
+        Coords<dim> sz;
+        if (!textParse(p,b.end(),sz) || sz.prod()<0)
+            return false;
+        A->setSize(sz);
+        std::vector<U*> rows;
+        A->forEachRow([&](U* r, size_t, const Coords<dim>&) { rows.push_back(r); });
+        const size_t w=size_t(sz[0]);
+        return textRead<U>(p,b.end(),sz.prod(),[&](size_t i, const U& v) { rows[i/w][i%w]=v; });
+    }
+    template <typename T, typename U, int dim>
+    bool saveTextFile(const T& obj, const MultiArray<U,dim>* A, const std::string& filename, int precision) {
+        if (!TextElement<U>::fast)
+            return saveTextFile(obj,(const void*)A,filename,precision);
+        std::ofstream out(filename.c_str(), std::ios::out);
+        if (!out.is_open()) {
+            std::cerr << "Error: failed to open file '" << filename << "' for writing" << std::endl;
+            return false;
+        }
+        std::vector<const U*> rows;
+        A->forEachRow([&](const U* r, size_t, const Coords<dim>&) { rows.push_back(r); });
+        const size_t w=size_t(A->size(0));
+        out << A->sizes();
+        return textWrite<U>(out,A->totalSize(),w,true,[&](size_t i) -> const U& { return rows[i/w][i%w]; },precision);
+    }
+#endif
+
     /// Object loading.
     /// Loads an object from a given file in ASCII format (operator>>() must be implemented)
+    ///
+    /// Arrays (Array, MultiArray, Image, Vector, Matrix, SymMatrix...) of numbers or of fixed size vectors of numbers
+    /// are parsed directly from the file mapped in memory, in parallel for large files. Their format is the one of
+    /// operator<<() (files written by it are read).
     /// \param obj object to load
     /// \param filename file name
     /// \return false if failed
@@ -26,38 +118,74 @@ namespace Imagine {
     /// \until load object (binary)
     template <typename T>
     bool loadText(T& obj, std::string filename) {
-        std::ifstream in(filename.c_str(), std::ios::in);
+        return loadTextFile(obj,&obj,filename);
+    }
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    // Objects in general: read()/write()
+    template <typename T>
+    bool loadBinaryFile(T& obj, void*, const std::string& filename, bool) {
+        std::ifstream in(filename.c_str(), std::ios::in|std::ios::binary);
         if (!in.is_open())  {
             std::cerr << "Error: failed to open file '" << filename << "' for reading" << std::endl;
             return false;
         }
-        in >> obj;
+        read(in,obj);
         return (!in.fail());
     }
+    template <typename T>
+    bool saveBinaryFile(const T& obj, const void*, const std::string& filename, bool, bool) {
+        std::ofstream out(filename.c_str(), std::ios::out|std::ios::binary);
+        if (!out.is_open()) {
+            std::cerr << "Error: failed to open file '" << filename << "' for writing" << std::endl;
+            return false;
+        }
+        write(out,obj);
+        return (!out.fail());
+    }
+    // nD arrays (MultiArray, Image, Matrix...): header and values (see BinaryHeader)
+    template <typename T, typename U, int dim>
+    bool loadBinaryFile(T&, MultiArray<U,dim>* A, const std::string& filename, bool mapped) {
+        return loadArrayFile(*A,filename,mapped);
+    }
+    template <typename T, typename U, int dim>
+    bool saveBinaryFile(const T&, const MultiArray<U,dim>* A, const std::string& filename, bool checksum, bool compressed) {
+        return saveArrayFile(*A,filename,checksum,compressed);
+    }
+#endif
+
     /// Object loading.
     /// Loads an object from a given file in binary format (read() must be implemented)
+    ///
+    /// nD arrays (MultiArray, Image, Matrix...) use a self-describing format (see saveBinary()): files are checked
+    /// (element type, dimension, sizes...) before reading values and rejected with an error message if they do not
+    /// match. If mapped is true, such a file is mapped in memory instead of being read: no memory is allocated and
+    /// values are only read from disk when accessed, the mapping being released with the last array using it. The
+    /// mapping is private: modifying values does not modify the file. <b>The file must not be modified or truncated
+    /// while mapped</b>. Loading falls back to reading when mapping is not possible (platform without mmap). The
+    /// checksum, if any, is verified when reading, not when mapping. Compressed files are never mapped: their chunks are
+    /// decompressed in parallel (see MultiArrayReader to decompress only some of them).
     /// \param obj object to load
     /// \param filename file name
+    /// \param mapped map nD arrays instead of reading them (default=false)
     /// \return false if failed
     ///
     /// \dontinclude Common/test/test.cpp \skip io()
     /// \skipline object to save
     /// \until load object (binary)
     template <typename T>
-    bool loadBinary(T& obj, std::string filename) {
-        std::ifstream in(filename.c_str(), std::ios::in|std::ios::binary);
-        if (!in.is_open())  {
-            std::cerr << "Error: failed to open file '" << filename << "' for reading" << std::endl;
-            return false;
-        }
-        read(in,obj);
-        return (!in.fail());
+    bool loadBinary(T& obj, std::string filename, bool mapped=false) {
+        return loadBinaryFile(obj,&obj,filename,mapped);
     }
     /// Object saving.
     /// Saves an object from a given file in ASCII format (operator<<() must be implemented)
+    ///
+    /// Arrays (Array, MultiArray, Image, Vector, Matrix, SymMatrix...) of numbers or of fixed size vectors of numbers
+    /// are formatted in memory, in parallel for large arrays, in the format of operator<<(). Unless a precision is
+    /// given, floating point values are written with the shortest representation that reads back to the same value.
+    /// Fixed size vectors of characters (e.g. Color) are written as integers.
     /// \param obj object to save
     /// \param filename file name
-    /// \param precision for ASCII output
+    /// \param precision for ASCII output (number of significant digits, default: exact)
     /// \return false if failed
     ///
     /// \dontinclude Common/test/test.cpp \skip io()
@@ -65,35 +193,235 @@ namespace Imagine {
     /// \until load object (binary)
     template <typename T>
     bool saveText(const T& obj, std::string filename, int precision=-1) {
-        std::ofstream out(filename.c_str(), std::ios::out);
-        if (!out.is_open()) {
-            std::cerr << "Error: failed to open file '" << filename << "' for writing" << std::endl;
-            return false;
-        }
-        if (precision>=0)
-            out.precision(precision);
-        out << obj;
-        return (!out.fail());
+        return saveTextFile(obj,&obj,filename,precision);
     }
     /// Object saving.
     /// Saves an object from a given file in binary format (write must be implemented)
+    ///
+    /// nD arrays (MultiArray, Image, Matrix...) are written in a self-describing format: a header (magic, version,
+    /// byte order, element type, dimension, sizes, strides, optional CRC32C checksum of values) followed by values
+    /// starting at a 4 KiB aligned offset, so that loadBinary() can check files and map them directly. Padded rows
+    /// are written as is.
+    ///
+    /// nD array values can be compressed, losslessly and without external library: values are cut in chunks of 1 MiB
+    /// which are compressed independently, in parallel. Each chunk is reordered by byte planes (first byte of all
+    /// values, then second byte...), delta coded and LZ77 coded, which suits smooth images, label maps or matrices
+    /// with repeated values. Chunks that would not get smaller are stored as is.
     /// \param obj object to save
     /// \param filename file name
+    /// \param checksum store a CRC32C checksum of nD array values (default=false)
+    /// \param compressed compress nD array values (default=false)
     /// \return false if failed
     ///
     /// \dontinclude Common/test/test.cpp \skip io()
     /// \skipline object to save
     /// \until load object (binary)
     template <typename T>
-    bool saveBinary(const T& obj, std::string filename) {
-        std::ofstream out(filename.c_str(), std::ios::out|std::ios::binary);
-        if (!out.is_open()) {
-            std::cerr << "Error: failed to open file '" << filename << "' for writing" << std::endl;
-            return false;
-        }
-        write(out,obj);
-        return (!out.fail());
+    bool saveBinary(const T& obj, std::string filename, bool checksum=false, bool compressed=false) {
+        return saveBinaryFile(obj,&obj,filename,checksum,compressed);
     }
 
+    /// \headerfile Imagine/Common.h "Imagine/Common.h"
+    /// Streaming binary writer.
+    /// Writes an nD array to a file, in the format of saveBinary(), from successive parts given by the user: the whole
+    /// array never needs to be in memory. Values are given in storage order (dimension 0 first), e.g. slice by slice
+    /// for a 3D volume.
+    ///
+    /// \dontinclude Common/test/test.cpp \skip io()
+    /// \skipline streaming write
+    /// \until ...
+    /// \param T value type
+    /// \param dim dimension
+    template <typename T, int dim> class MultiArrayWriter {
+        std::ofstream _out;
+        Coords<dim> _sz;
+        size_t _left;       // number of values still to be written
+        BinaryHeader _h;    // header, written again at closing with the checksum
+        uint32_t _crc;      // checksum of values written so far
+    public:
+        /// Constructor.
+        /// Opens file and writes header
+        /// \param filename file name
+        /// \param sz sizes of the array to be written
+        /// \param checksum store a CRC32C checksum of values (default=false)
+        MultiArrayWriter(std::string filename, const Coords<dim>& sz, bool checksum=false)
+            : _out(filename.c_str(), std::ios::out|std::ios::binary), _sz(sz), _left(sz.prod()), _crc(0) {
+            FArray<size_t,dim> stride;
+            stride[0]=1;
+            for (int i=0;i<dim-1;i++)
+                stride[i+1]=stride[i]*sz[i];
+            _h=BinaryHeader::make<T>(sz,stride,_left*sizeof(T),checksum);
+            if (!_out.is_open()) {
+                std::cerr << "Error: failed to open file '" << filename << "' for writing" << std::endl;
+                return;
+            }
+            _out.write((const char*)&_h,sizeof(_h));
+            const std::string zeros(size_t(_h.dataOffset)-sizeof(_h),'\0');
+            _out.write(zeros.data(),(std::streamsize)zeros.size());
+        }
+        /// Destructor.
+        /// Closes file
+        ~MultiArrayWriter() { close(); }
+        /// Is open.
+        /// True if file is open and no error occured
+        /// \return status
+        bool isOpen() const { return _out.is_open() && !_out.fail(); }
+        /// Appending values.
+        /// Writes the next n values
+        /// \param p values
+        /// \param n number of values
+        /// \return false if failed (including when more values than expected are given)
+        bool append(const T* p, size_t n) {
+            if (!isOpen() || n>_left)
+                return false;
+            _out.write((const char*)p,(std::streamsize)(n*sizeof(T)));
+            if (_h.flags&BinaryHeader::FLAG_CRC)
+                _crc=crc32c(p,n*sizeof(T),_crc);
+            _left-=n;
+            return !_out.fail();
+        }
+        /// Appending an nD array.
+        /// Writes values of A, which holds the next A.size(dim-1) slices along the last dimension (other sizes being
+        /// those of the whole array). A may be padded or a view.
+        /// \param A next slices
+        /// \return false if failed
+        bool append(const MultiArray<T,dim>& A) {
+            for (int i=0;i<dim-1;i++)
+                if (A.size(i)!=_sz[i])
+                    return false;
+            bool ok=true;
+            A.forEachRow([&](const T* p, size_t n, const Coords<dim>&) { ok = ok && append(p,n); });
+            return ok;
+        }
+        /// Closing.
+        /// Closes file (done by destructor if not called). The header is only completed if all values were written, so
+        /// that an incomplete file is rejected by loadBinary().
+        /// \return false if some values were not written or if writing failed
+        bool close() {
+            if (!_out.is_open())
+                return false;
+            bool ok=isOpen() && _left==0;
+            if (ok) {
+                _h.dataCrc=_crc;
+                _h.seal();
+                _out.seekp(0);
+                _out.write((const char*)&_h,sizeof(_h));
+            }
+            _out.close();
+            return ok && !_out.fail();
+        }
+    };
+
+    /// \headerfile Imagine/Common.h "Imagine/Common.h"
+    /// Binary reader.
+    /// Reads parts of an nD array from a file written by saveBinary() or MultiArrayWriter: only the needed values are
+    /// read and, for compressed files, only the chunks holding them are decompressed (the last one being kept for the
+    /// next read). Checksums are not verified.
+    ///
+    /// \dontinclude Common/test/test.cpp \skip io()
+    /// \skipline partial read
+    /// \until ...
+    /// \param T value type
+    /// \param dim dimension
+    template <typename T, int dim> class MultiArrayReader {
+        std::ifstream _in;
+        BinaryHeader _h;
+        Coords<dim> _sz;
+        FArray<size_t,dim> _stride;
+        bool _ok;
+        BinaryChunks _chunks;               // table of compressed files
+        size_t _cached;                     // chunk held by _chunk (count() if none)
+        std::vector<unsigned char> _chunk, _coded;
+
+        // Reads n bytes of values starting at byte pos
+        bool readBytes(unsigned char* p, uint64_t pos, size_t n) {
+            if (!(_h.flags&BinaryHeader::FLAG_COMPRESSED)) {
+                _in.seekg(std::streamoff(_h.dataOffset+pos));
+                _in.read((char*)p,(std::streamsize)n);
+                return !_in.fail();
+            }
+            while (n>0) {
+                const size_t k=size_t(pos/_chunks.chunkSize);
+                if (k!=_cached) {
+                    _coded.resize(size_t(_chunks.ends[k]-_chunks.begin(k)));
+                    _chunk.resize(size_t(_chunks.rawSize(k,_h.dataSize)));
+                    _in.seekg(std::streamoff(_h.dataOffset+_chunks.tableSize()+_chunks.begin(k)));
+                    _in.read((char*)_coded.data(),(std::streamsize)_coded.size());
+                    _cached=_chunks.count();
+                    if (_in.fail() || !BinaryChunks::decode(_coded.data(),_coded.size(),sizeof(T),_chunk.data(),_chunk.size()))
+                        return false;
+                    _cached=k;
+                }
+                const size_t o=size_t(pos-k*_chunks.chunkSize), m=std::min(n,_chunk.size()-o);
+                std::memcpy(p,_chunk.data()+o,m);
+                p+=m;
+                pos+=m;
+                n-=m;
+            }
+            return true;
+        }
+    public:
+        /// Constructor.
+        /// Opens file and checks its header
+        /// \param filename file name
+        MultiArrayReader(std::string filename) : _in(filename.c_str(), std::ios::in|std::ios::binary), _ok(false), _cached(0) {
+            if (!_in.is_open()) {
+                std::cerr << "Error: failed to open file '" << filename << "' for reading" << std::endl;
+                return;
+            }
+            _in.read((char*)&_h,sizeof(_h));
+            const char* error = _in ? _h.check<T,dim>() : "not an Imagine++ binary file";
+            _in.clear();
+            _in.seekg(0,std::ios::end);
+            const uint64_t fileSize=uint64_t(_in.tellg());
+            if (!error && (_h.flags&BinaryHeader::FLAG_COMPRESSED)) {
+                _in.seekg(std::streamoff(_h.dataOffset));
+                if (fileSize<_h.dataOffset || !_chunks.read(_in,_h,fileSize-_h.dataOffset))
+                    error="corrupted compressed data";
+                _cached=_chunks.count();
+            } else if (!error && fileSize<_h.dataOffset+_h.dataSize)
+                error="truncated file";
+            if (error) {
+                std::cerr << "Error: bad binary file '" << filename << "' (" << error << ")" << std::endl;
+                return;
+            }
+            for (int i=0;i<dim;i++) {
+                _sz[i]=int(_h.sizes[i]);
+                _stride[i]=size_t(_h.strides[i]);
+            }
+            _ok=true;
+        }
+        /// Is open.
+        /// True if file is open, valid and no error occured
+        /// \return status
+        bool isOpen() const { return _ok && !_in.fail(); }
+        /// Sizes.
+        /// Sizes of the whole array
+        /// \return sizes
+        const Coords<dim>& sizes() const { return _sz; }
+        /// Reading slices.
+        /// Reads count slices along the last dimension, starting at slice first (e.g. some slices of a 3D volume, or
+        /// some rows of an image): A is allocated with the sizes of the whole array except for the last one, count.
+        /// \param A slices
+        /// \param first first slice
+        /// \param count number of slices
+        /// \return false if failed (including slices out of range)
+        bool read(MultiArray<T,dim>& A, int first, int count) {
+            if (!isOpen() || first<0 || count<0 || first+count>_sz[dim-1])
+                return false;
+            Coords<dim> sz=_sz;
+            sz[dim-1]=count;
+            A.setSize(sz);
+            bool ok=true;
+            A.forEachRow([&](T* p, size_t n, const Coords<dim>& c) {
+                uint64_t o=uint64_t(first)*_stride[dim-1];
+                for (int i=0;i<dim;i++)
+                    o+=uint64_t(c[i])*_stride[i];
+                ok = ok && readBytes((unsigned char*)p,o*sizeof(T),n*sizeof(T));
+            });
+            return ok;
+        }
+    };
+
     ///@}
 }
@@ -0,0 +1,255 @@
+// ===========================================================================
+// Imagine++ Libraries
+// Copyright (C) Imagine
+// For detailed information: http://imagine.enpc.fr/software
+// ===========================================================================
+
+namespace Imagine {
+    /// \addtogroup Common
+    /// @{
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    // Memory allocated by Arrays for a given element type and site
+    struct MemoryRecord {
+        std::string type, site;
+        std::atomic<size_t> live, peak, count, total;   // bytes alive, max bytes alive, allocations, bytes allocated
+        MemoryRecord(const std::string& t, const std::string& s) : type(t), site(s), live(0), peak(0), count(0), total(0) {}
+    };
+
+    inline void memoryPeak(std::atomic<size_t>& peak, size_t v) {
+        for (size_t p=peak.load(std::memory_order_relaxed); v>p && !peak.compare_exchange_weak(p,v););
+    }
+
+    // Sizes in environment variables: bytes with optional suffix k, M or G
+    inline size_t memorySize(const char* s) {
+        if (!s)
+            return 0;
+        char* e;
+        double v=std::strtod(s,&e);
+        switch (*e) {
+            case 'k': case 'K': v*=1024.; break;
+            case 'm': case 'M': v*=1024.*1024; break;
+            case 'g': case 'G': v*=1024.*1024*1024; break;
+        }
+        return v>0 ? size_t(v) : 0;
+    }
+
+    // Human readable type name
+    template <typename T> std::string memoryTypeName() {
+        const char* n=typeid(T).name();
+#ifdef __GNUG__
+        int status;
+        char* d=abi::__cxa_demangle(n,0,0,&status);
+        if (status==0 && d) {
+            std::string r(d);
+            std::free(d);
+            return r;
+        }
+#endif
+        return n;
+    }
+
+    // Global state of memory instrumentation
+    struct MemoryState {
+        static const int BUCKETS=64;        // allocation sizes histogram: [2^i,2^(i+1)[ bytes
+        std::atomic<bool> enabled;
+        std::atomic<size_t> budget, live, peak, count, total;
+        std::atomic<size_t> histogram[BUCKETS];
+        std::mutex mutex;                   // protects records
+        std::vector<std::unique_ptr<MemoryRecord> > records;
+        bool reportAtExit;
+
+        MemoryState() : live(0), peak(0), count(0), total(0) {
+            const char* e=std::getenv("IMAGINE_MEMORY");
+            reportAtExit = e && std::strcmp(e,"0")!=0;
+            budget = memorySize(std::getenv("IMAGINE_MEMORY_BUDGET"));
+            enabled = reportAtExit || budget>0;
+            for (int i=0;i<BUCKETS;i++)
+                histogram[i]=0;
+        }
+        static MemoryState& instance();
+        MemoryRecord* record(const std::string& type, const char* site) {
+            const std::string s = site ? site : "";
+            std::lock_guard<std::mutex> l(mutex);
+            for (size_t i=0;i<records.size();i++)
+                if (records[i]->type==type && records[i]->site==s)
+                    return records[i].get();
+            records.emplace_back(new MemoryRecord(type,s));
+            return records.back().get();
+        }
+    };
+
+    // Innermost allocation site of calling thread (see MemorySite)
+    inline const char*& memorySite() {
+        thread_local const char* site=0;
+        return site;
+    }
+#endif
+
+    /// \headerfile Imagine/Common.h "Imagine/Common.h"
+    /// Memory statistics.
+    /// Optional instrumentation of memory allocated by Arrays (and thus MultiArray, Image, Matrix, Vector...): bytes
+    /// alive, peak, number of allocations, histogram of allocation sizes, and the same per element type and
+    /// allocation site (see MemorySite, ScopedTimer also marking sites). Only allocations made while enabled are
+    /// counted. When disabled, the only cost is a test per allocation.
+    ///
+    /// A memory budget makes allocations that would exceed it fail fast: a diagnostic with the report of live memory
+    /// is printed on std::cerr and std::bad_alloc is thrown, instead of letting the system swap.
+    ///
+    /// Both can be set without recompiling with environment variables: IMAGINE_MEMORY=1 enables statistics and
+    /// prints report() on std::cerr at exit, IMAGINE_MEMORY_BUDGET sets the budget (bytes, possibly followed by k, M
+    /// or G, e.g. 12G).
+    ///
+    /// \dontinclude Common/test/test.cpp \skip arrays()
+    /// \skipline enable memory statistics
+    /// \until report
+    class MemoryStats {
+    public:
+        /// Enabling.
+        /// Enables or disables statistics (initially enabled if IMAGINE_MEMORY or IMAGINE_MEMORY_BUDGET is set)
+        /// \param e true to enable
+        static void enable(bool e=true) { MemoryState::instance().enabled=e; }
+        /// Enabled.
+        /// Whether statistics are enabled
+        /// \return status
+        static bool enabled() { return MemoryState::instance().enabled.load(std::memory_order_relaxed); }
+        /// Budget.
+        /// Sets the maximum number of bytes alive (0 for no budget). Enables statistics.
+        /// \param bytes budget
+        static void setBudget(size_t bytes) {
+            MemoryState::instance().budget=bytes;
+            if (bytes)
+                enable();
+        }
+        /// Budget.
+        /// Maximum number of bytes alive (0 if no budget)
+        /// \return budget
+        static size_t budget() { return MemoryState::instance().budget; }
+        /// Live bytes.
+        /// Bytes alive (allocated while enabled and not freed yet)
+        /// \return bytes
+        static size_t liveBytes() { return MemoryState::instance().live; }
+        /// Peak bytes.
+        /// Maximum of liveBytes() since start or resetPeak()
+        /// \return bytes
+        static size_t peakBytes() { return MemoryState::instance().peak; }
+        /// Allocations.
+        /// Number of allocations counted
+        /// \return number
+        static size_t allocations() { return MemoryState::instance().count; }
+        /// Peak reset.
+        /// Resets peaks (global and per site) to current live bytes
+        static void resetPeak() {
+            MemoryState& s=MemoryState::instance();
+            s.peak=s.live.load();
+            std::lock_guard<std::mutex> l(s.mutex);
+            for (size_t i=0;i<s.records.size();i++)
+                s.records[i]->peak=s.records[i]->live.load();
+        }
+        /// Report.
+        /// Writes totals, the histogram of allocation sizes and, for each element type and site, bytes alive, peak,
+        /// allocations and bytes allocated (sorted by decreasing peak)
+        /// \param out output stream
+        static void report(std::ostream& out) {
+            MemoryState& s=MemoryState::instance();
+            out << "Memory: " << s.live << " bytes alive, peak " << s.peak << ", " << s.count << " allocations of "
+                << s.total << " bytes";
+            if (s.budget)
+                out << ", budget " << s.budget;
+            out << std::endl << "Allocation sizes:";
+            for (int i=0;i<MemoryState::BUCKETS;i++)
+                if (s.histogram[i])
+                    out << " [2^" << i << ",2^" << i+1 << "[:" << s.histogram[i];
+            out << std::endl;
+            std::vector<const MemoryRecord*> r;
+            {
+                std::lock_guard<std::mutex> l(s.mutex);
+                for (size_t i=0;i<s.records.size();i++)
+                    r.push_back(s.records[i].get());
+            }
+            std::sort(r.begin(),r.end(),[](const MemoryRecord* a, const MemoryRecord* b) { return a->peak>b->peak; });
+            const std::ios::fmtflags f=out.flags();
+            out << std::left << std::setw(28) << "type" << std::setw(24) << "site" << std::right << std::setw(14)
+                << "live" << std::setw(14) << "peak" << std::setw(10) << "allocs" << std::setw(16) << "allocated" << std::endl;
+            for (size_t i=0;i<r.size();i++)
+                out << std::left << std::setw(28) << r[i]->type << std::setw(24) << (r[i]->site.empty() ? "-" : r[i]->site)
+                    << std::right << std::setw(14) << r[i]->live << std::setw(14) << r[i]->peak << std::setw(10)
+                    << r[i]->count << std::setw(16) << r[i]->total << std::endl;
+            out.flags(f);
+        }
+    };
+
+    /// \headerfile Imagine/Common.h "Imagine/Common.h"
+    /// Memory site.
+    /// Names the allocation site of Arrays allocated by the calling thread during its life, for MemoryStats
+    /// (innermost one if nested).
+    ///
+    /// \dontinclude Common/test/test.cpp \skip arrays()
+    /// \skipline allocation site
+    class MemorySite {
+        const char* _previous;
+        MemorySite(const MemorySite&);
+        void operator=(const MemorySite&);
+    public:
+        /// Constructor.
+        /// Opens a site
+        /// \param name name (usually a literal string)
+        explicit MemorySite(const char* name) : _previous(memorySite()) { memorySite()=name; }
+        /// Destructor.
+        /// Closes the site
+        ~MemorySite() { memorySite()=_previous; }
+    };
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    inline MemoryState& MemoryState::instance() {
+        static MemoryState* s=new MemoryState;    // never destroyed: static Arrays may be freed after it
+        static struct AtExit {
+            ~AtExit() {
+                if (s->reportAtExit)
+                    MemoryStats::report(std::cerr);
+            }
+        } atExit;
+        return *s;
+    }
+
+    // Counts an allocation of given bytes of type T. Returns its record, or 0 if not counted. Throws std::bad_alloc
+    // if the budget would be exceeded.
+    template <typename T> MemoryRecord* memoryAlloc(size_t bytes) {
+        MemoryState& s=MemoryState::instance();
+        if (!s.enabled.load(std::memory_order_relaxed))
+            return 0;
+        static const std::string type=memoryTypeName<T>();
+        const size_t budget=s.budget, live=s.live.fetch_add(bytes)+bytes;
+        if (budget && live>budget) {
+            s.live-=bytes;
+            const char* site=memorySite();
+            std::cerr << "Error: memory budget exceeded: allocating " << bytes << " bytes of " << type
+                      << (site ? std::string(" in ")+site : std::string()) << " with " << live-bytes << " bytes alive (budget "
+                      << budget << ")" << std::endl;
+            MemoryStats::report(std::cerr);
+            throw std::bad_alloc();
+        }
+        memoryPeak(s.peak,live);
+        s.count++;
+        s.total+=bytes;
+        int b=0;
+        while (b<MemoryState::BUCKETS-1 && (bytes>>(b+1))!=0)
+            b++;
+        s.histogram[b]++;
+        MemoryRecord* r=s.record(type,memorySite());
+        memoryPeak(r->peak,r->live.fetch_add(bytes)+bytes);
+        r->count++;
+        r->total+=bytes;
+        return r;
+    }
+    // Counts release of bytes allocated with memoryAlloc()
+    inline void memoryFree(MemoryRecord* r, size_t bytes) {
+        if (!r)
+            return;
+        MemoryState::instance().live-=bytes;
+        r->live-=bytes;
+    }
+#endif
+
+    ///@}
+}
@@ -16,6 +16,16 @@ namespace Imagine {
     /// - the last object using memory frees it when it dies
     /// - use clone() when this sharing is not desired
     ///
+    /// Elements are stored along dimension 0 first. Rows (runs of elements along dimension 0) may be
+    /// padded so that each one starts on an aligned address (see MultiArray(const Coords<dim>&,size_t)):
+    /// stride() then gives the padded distances and isContiguous() is false. Functions of MultiArray take
+    /// care of padding, but <b>linear accesses to the underlying Array (operator[], begin(), end(), data())
+    /// also reach padding elements</b>.
+    ///
+    /// Similarly, getSubArrayView() gives a MultiArray sharing a region of another one, without copy: it keeps
+    /// the strides of its parent, data() being its first element. Linear accesses to such a view also reach elements
+    /// of the parent that are outside the region.
+    ///
     /// \param T value type
     /// \param dim dimension    
     template <typename T, int dim> class MultiArray : public Array<T> {
@@ -39,6 +49,119 @@ namespace Imagine {
         {
             _sz=A.sizes();  _stride=A.stride();
         }
+        // Strides with rows padded to a multiple of rowAlign bytes (and of sizeof(T))
+        static FArray<size_t,dim> paddedStride(const Coords<dim>& sz, size_t rowAlign)
+        {
+            FArray<size_t,dim> stride;
+            stride[0] = 1;
+            for (int i=0;i<dim-1;i++)
+                stride[i+1] = stride[i]*sz[i];
+            if (dim>1 && rowAlign>0) {
+                size_t g=rowAlign, b=sizeof(T);     // row length must be a multiple of rowAlign/gcd(rowAlign,sizeof(T))
+                while (b) { size_t r=g%b; g=b; b=r; }
+                const size_t m=rowAlign/g;
+                stride[1] = (size_t(sz[0])+m-1)/m*m;
+                for (int i=1;i<dim-1;i++)
+                    stride[i+1] = stride[i]*sz[i];
+            }
+            return stride;
+        }
+        // Number of elements needed to store given sizes with given (nested) strides, padding included
+        static size_t storageSize(const Coords<dim>& sz, const FArray<size_t,dim>& stride)
+        {
+            return sz.prod()==0 ? 0 : stride[dim-1]*sz[dim-1];
+        }
+
+    protected:
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+        // Constructs an allocated array with given sizes and (nested) strides
+        MultiArray(const Coords<dim>& sz, const FArray<size_t,dim>& stride) : Base(storageSize(sz,stride)) { _sz=sz; _stride=stride; }
+        // Constructs a view of the region of A starting at offset, with sizes sz (non empty)
+        MultiArray(const MultiArray& A, const Coords<dim>& offset, const Coords<dim>& sz)
+            : Base(A, A.offset(offset), A.offset(sz-Coords<dim>(1))+1) { _sz=sz; _stride=A._stride; }
+        // Constructs an array of sizes sz and (nested) strides stored at offset bytes of a mapping given by mapFile() and ending with it
+        MultiArray(void* mem, size_t offset, const Coords<dim>& sz, const FArray<size_t,dim>& stride)
+            : Base(mem,offset,storageSize(sz,stride)) { _sz=sz; _stride=stride; }
+        // True if the underlying Array holds exactly the (possibly padded) rows, so that it can be processed linearly,
+        // padding included, and copied with the same layout.
+        bool isDense() const
+        {
+            if (_stride[0]!=1) return false;
+            for (int i=0;i<dim-1;i++)
+                if (_stride[i+1]<_stride[i]*_sz[i]) return false;
+            return Base::size()==storageSize(_sz,_stride);
+        }
+        // Calls f(o,n,c) for consecutive runs of elements covering the whole domain, o being the offset of the first
+        // element of the run, n its length and c its coordinates. A contiguous array is a single run unless byRow is true,
+        // otherwise runs are rows (along dimension 0).
+        template <typename F> void forEachRun(F f, bool byRow=false) const
+        {
+            if (totalSize()==0) return;
+            Coords<dim> c(0);
+            if (!byRow && isContiguous()) {
+                f(size_t(0),totalSize(),c);
+                return;
+            }
+            size_t o=0;
+            const size_t n=_sz[0];
+            for (;;) {
+                f(o,n,c);
+                int d=1;
+                for ( ; d<dim; d++) {
+                    if (++c[d]<_sz[d]) {
+                        o+=_stride[d];
+                        break;
+                    }
+                    o-=(c[d]-1)*_stride[d];
+                    c[d]=0;
+                }
+                if (d==dim)
+                    break;
+            }
+        }
+        // Number of rows (0 if empty)
+        size_t rowCount() const { return _sz[0]>0 ? totalSize()/size_t(_sz[0]) : 0; }
+        // Calls f(o,n,c) for rows b to e-1 (rows being numbered in storage order), as forEachRun(f,true)
+        template <typename F> void forRows(size_t b, size_t e, F f) const
+        {
+            Coords<dim> c(0);
+            size_t o=0, r=b;
+            for (int d=1;d<dim;d++) {
+                c[d]=int(r%size_t(_sz[d]));
+                o+=c[d]*_stride[d];
+                r/=size_t(_sz[d]);
+            }
+            const size_t n=_sz[0];
+            for (r=b;r<e;r++) {
+                f(o,n,c);
+                for (int d=1;d<dim;d++) {
+                    if (++c[d]<_sz[d]) {
+                        o+=_stride[d];
+                        break;
+                    }
+                    o-=(c[d]-1)*_stride[d];
+                    c[d]=0;
+                }
+            }
+        }
+        // Reduction of the whole domain: f(p,n) reduces the n contiguous elements at p, combine(r1,r2) merges partial
+        // results (in order). Large arrays are split in parallel (see parallelReduce()). Domain must not be empty.
+        template <typename R, typename F, typename C> R reduce(F f, C combine) const
+        {
+            const T* d=this->data();
+            if (isContiguous())
+                return parallelReduce<R>(0,totalSize(),[&](size_t b, size_t e) { return f(d+b,e-b); },combine,REDUCE_GRAIN);
+            std::vector<size_t> runs;
+            forEachRun([&](size_t o, size_t, const Coords<dim>&) { runs.push_back(o); }, true);
+            const size_t n=_sz[0];
+            return parallelReduce<R>(0,runs.size(),[&](size_t b, size_t e) {
+                R r=f(d+runs[b],n);
+                for (size_t i=b+1;i<e;i++)
+                    r=combine(r,f(d+runs[i],n));
+                return r;
+            },combine,REDUCE_GRAIN/n+1);
+        }
+#endif
 
     public:
         /// Iterator type
@@ -52,7 +175,7 @@ namespace Imagine {
         ///
         /// \dontinclude Common/test/test.cpp \skip multiArrays()
         /// \skipline non allocated
-        MultiArray() : Base() { _sz = 0; }
+        MultiArray() : Base() { setSizes(Coords<dim>(0)); }
         /// Constructor (known size).
         /// Constructs an allocated array of variables of type T and dimension dim. sz[i] specifies size for dimension i.
         /// \param sz array sizes
@@ -77,6 +200,16 @@ namespace Imagine {
         /// \dontinclude Common/test/test.cpp \skip multiArrays()
         /// \skipline constructor, 3D alias
         MultiArray(int s0,int s1, int s2) : Base(size_t(s0)*s1*s2) { assert(dim==3); setSizes(Coords<3>(s0,s1,s2)); }
+        /// Constructor (padded rows).
+        /// Constructs an allocated array whose rows (elements along dimension 0) are padded so that each one starts on a
+        /// multiple of rowAlign bytes (from the beginning of memory, itself aligned on IMAGINE_ARRAY_ALIGNMENT). 
+        /// The padded distances are given by stride(). rowAlign=0 gives a contiguous array.
+        /// \param sz array sizes
+        /// \param rowAlign row alignment in bytes (e.g. 64 for cache lines)
+        ///
+        /// \dontinclude Common/test/test.cpp \skip multiArrays()
+        /// \skipline padded rows
+        MultiArray(const Coords<dim>& sz, size_t rowAlign) : Base(storageSize(sz,paddedStride(sz,rowAlign))) { _sz=sz; _stride=paddedStride(sz,rowAlign); }
         /// Constructor (pre-allocated).
         /// Constructs an array of variables of type T and dimension dim, stored at an already allocated memory. ptr contains elements (0,0,...), (1,0,...), ...
         /// Does not allocate fresh memory. Does not free given memory at object destruction unless handleDelete=true. This memory must indeed stay available 
@@ -120,7 +253,14 @@ namespace Imagine {
         /// 
         /// \dontinclude Common/test/test.cpp \skip multiArrays()
         /// \skipline copy constructor
-        explicit MultiArray(const MultiArray& A) : Base(A) { setSizes(A); }
+        MultiArray(const MultiArray& A) : Base(A) { setSizes(A); }
+        /// Move constructor.
+        /// Constructs an nD array taking over memory of another one, which becomes empty
+        /// \param A nD array to move from
+        /// 
+        /// \dontinclude Common/test/test.cpp \skip moves()
+        /// \skipline nD move constructor
+        MultiArray(MultiArray&& A) : Base(std::move(static_cast<Base&>(A))) { setSizes(A); A.setSizes(Coords<dim>(0)); }
         /// Constructor (different type).
         /// Constructs an nD array of type T from one of another type (thus without sharing memory!)
         /// \param A nD array to copy
@@ -129,7 +269,7 @@ namespace Imagine {
         /// \dontinclude Common/test/test.cpp \skip multiArrays()
         /// \skipline from different type
         template <typename T2> 
-        MultiArray(const MultiArray<T2,dim>& A) : Base(A) { setSizes(A); }
+        MultiArray(const MultiArray<T2,dim>& A) { *this=A; }
         /// Destructor.
         /// Reference counted desctructor: frees memory if the object is the last one to use it.
         virtual ~MultiArray() {}
@@ -145,7 +285,10 @@ namespace Imagine {
         /// \skipline setSize
         void setSize(const Coords<dim>& sz) {
             if (sz==_sz) return;
-            Base::setSize(sz.prod());
+            if (isDense())
+                Base::setSize(sz.prod());
+            else
+                Base::operator=(Base(sz.prod()));   // views: do not write into parent memory
             setSizes(sz);
         }
         /// Change size 2D alias.
@@ -173,6 +316,21 @@ namespace Imagine {
         /// \dontinclude Common/test/test.cpp \skip multiArrays()
         /// \skipline assignment 
         MultiArray& operator=(const MultiArray& A) { Base::operator =(A); setSizes(A); return *this; }
+        /// Move assignment.
+        /// Takes over memory of another nD array, which becomes empty
+        /// \param A nD array to move from
+        /// \return self reference
+        /// 
+        /// \dontinclude Common/test/test.cpp \skip moves()
+        /// \skipline nD move assignment
+        MultiArray& operator=(MultiArray&& A) {
+            if (this!=&A) {
+                Base::operator =(std::move(static_cast<Base&>(A)));
+                setSizes(A);
+                A.setSizes(Coords<dim>(0));
+            }
+            return *this;
+        }
         /// Assignment (different type).
         /// Assign from an array of another type (thus without sharing memory!)
         /// \param A array to copy
@@ -181,9 +339,24 @@ namespace Imagine {
         /// 
         /// \dontinclude Common/test/test.cpp \skip multiArrays()
         /// \skipline different type assignment
-        template <typename T2> MultiArray& operator= (const MultiArray<T2,dim>& A) { Base::operator = (A); setSizes(A); return *this; }
+        template <typename T2> MultiArray& operator= (const MultiArray<T2,dim>& A) {
+            if (A.isContiguous()) {
+                Base::operator = (A);
+                setSizes(A);
+                return *this;
+            }
+            Base::operator = (Base(A.totalSize()));
+            setSizes(A.sizes());
+            forEachRun([&](size_t o, size_t n, const Coords<dim>& c) {
+                const T2* a=A.data()+A.offset(c);
+                T* b=this->data()+o;
+                for (size_t i=0;i<n;i++)
+                    b[i]=T(a[i]);
+            },true);
+            return *this;
+        }
         /// Cloning.
-        /// Clones: creates a new nD array, with fresh memory, copying values to it
+        /// Clones: creates a new nD array, with fresh (contiguous) memory, copying values to it
         /// \return cloned array
         /// 
         /// \dontinclude Common/test/test.cpp \skip multiArrays()
@@ -191,7 +364,12 @@ namespace Imagine {
         MultiArray clone() const {
             if (this->empty()) return MultiArray();
             MultiArray A(_sz);
-            std::copy( this->begin(), this->end(), A.begin() );
+            if (isContiguous())
+                std::copy( this->begin(), this->begin()+totalSize(), A.begin() );
+            else
+                forEachRun([&](size_t o, size_t n, const Coords<dim>& c) {
+                    std::copy(this->data()+o,this->data()+o+n,A.data()+A.offset(c));
+                },true);
             return A;
         }
         /// Filling.
@@ -201,7 +379,28 @@ namespace Imagine {
         /// 
         /// \dontinclude Common/test/test.cpp \skip multiArrays()
         /// \skipline filling with constant value
-        MultiArray& fill(T x) { Base::fill(x); return *this; }
+        MultiArray& fill(T x) {
+            if (isDense())
+                Base::fill(x);
+            else
+                forEachRun([&](size_t o, size_t n, const Coords<dim>&) { std::fill(this->data()+o,this->data()+o+n,x); });
+            return *this;
+        }
+        /// Contiguity.
+        /// True if elements are stored without gaps (no row padding), i.e. element of coordinates c is at index offset(c)
+        /// of a contiguous block of totalSize() elements.
+        /// \return contiguity
+        ///
+        /// \dontinclude Common/test/test.cpp \skip multiArrays()
+        /// \skipline contiguous?
+        bool isContiguous() const {
+            size_t s=1;
+            for (int i=0;i<dim;i++) {
+                if (_stride[i]!=s && _sz[i]>1) return false;
+                s*=_sz[i];
+            }
+            return true;
+        }
         /// Sizes.
         /// Sizes of nD Array. 
         /// \return sizes
@@ -215,7 +414,7 @@ namespace Imagine {
         ///
         /// \dontinclude Common/test/test.cpp \skip multiArrays()
         /// \skipline number of elements
-        size_t totalSize() const { return Array<T>::size(); }
+        size_t totalSize() const { return _sz.prod(); }
         /// i<sup>th</sup> size.
         /// Size of nD Array along dimension i. 
         /// \return i<sup>th</sup> size
@@ -267,11 +466,24 @@ namespace Imagine {
         /// \dontinclude Common/test/test.cpp \skip multiArrays()
         /// \skipline sub array
         MultiArray getSubArray(const Coords<dim>& offset, const Coords<dim>& sz) const {
-            MultiArray A(sz);
-            for (CoordsIterator<dim> p = A.coordsBegin() ; p != A.coordsEnd() ; ++p) {
-                A(*p)=operator()(*p+offset);
-            }
-            return A;
+            return getSubArrayView(offset,sz).clone();
+        }
+        /// Sub array view.
+        /// Construct a view of a part of *this, i.e. a MultiArray <b>sharing memory</b> with *this (without any copy): 
+        /// modifying its values modifies *this. Its strides are those of *this (it is thus usually not contiguous).
+        /// Use clone() to get a contiguous copy.
+        /// \param offset coordinates of first element of sub array
+        /// \param sz sizes of sub array
+        /// \return view
+        /// 
+        /// \dontinclude Common/test/test.cpp \skip multiArrays()
+        /// \skipline sub array view
+        MultiArray getSubArrayView(const Coords<dim>& offset, const Coords<dim>& sz) const {
+            for (int i=0;i<dim;i++)
+                assert(offset[i]>=0 && sz[i]>=0 && offset[i]+sz[i]<=_sz[i]);
+            if (sz.prod()==0)
+                return MultiArray();
+            return MultiArray(*this,offset,sz);
         }
         /// Offset.
         /// Offset (i.e. index of coordinates in the underlying Array) given coordinates
@@ -281,11 +493,10 @@ namespace Imagine {
         /// \dontinclude Common/test/test.cpp \skip multiArrays()
         /// \skipline offset
         size_t offset(const Coords<dim>& c) const {
-            size_t o = c[dim-1];
-            assert(o<size_t(_sz[dim-1]));
-            for (int d=dim-2;d>=0;d--) {
+            size_t o = 0;
+            for (int d=0;d<dim;d++) {
                 assert(c[d]>=0 && c[d]<_sz[d]);
-                o=o*_sz[d]+c[d];
+                o+=c[d]*_stride[d];
             }
             return o;
         }
@@ -298,7 +509,7 @@ namespace Imagine {
         /// \skipline offset 2D alias
         size_t offset(int x, int y) const {
             assert(dim==2);
-            return x+(size_t)_sz[0]*y;
+            return x+_stride[1]*y;
         }
         /// Offset (3D alias).
         /// Offset (3D alias)
@@ -309,7 +520,7 @@ namespace Imagine {
         /// \skipline offset 3D alias
         size_t offset(int x, int y, int z) const {
             assert(dim==3);
-            return x+_sz[0]*(y+(size_t)_sz[1]*z);
+            return x+_stride[1]*y+_stride[2]*z;
         }
         /// Read access.
         /// Reads element at coordinates c
@@ -377,6 +588,134 @@ namespace Imagine {
         /// \skipline coords iterator
         /// \until ...
         CoordsIterator<dim> coordsEnd() const { return CoordsIterator<dim>(); }
+        /// Row traversal.
+        /// Calls f(p,n,c) for each row (elements along dimension 0): p points to its n contiguous elements and c is the
+        /// coordinates of its first element (c[0]=0). Faster than a CoordsIterator when coordinates are needed: the
+        /// carry over the outer dimensions and the offset computation happen once per row instead of once per element.
+        /// \param f function (e.g. lambda) taking (T* p, size_t n, const Coords<dim>& c)
+        /// 
+        /// \dontinclude Common/test/test.cpp \skip multiArrays()
+        /// \skipline row traversal
+        /// \until ...
+        template <typename F> void forEachRow(F f) {
+            forEachRun([&](size_t o, size_t n, const Coords<dim>& c) { f(this->data()+o,n,c); },true);
+        }
+        /// Row traversal (read only).
+        /// Calls f(p,n,c) for each row, p pointing to its n contiguous elements and c being the coordinates of its first element.
+        /// \param f function (e.g. lambda) taking (const T* p, size_t n, const Coords<dim>& c)
+        template <typename F> void forEachRow(F f) const {
+            forEachRun([&](size_t o, size_t n, const Coords<dim>& c) { f(this->data()+o,n,c); },true);
+        }
+        /// Parallel row traversal.
+        /// Same as forEachRow(), rows being processed in parallel (see Parallel) by groups of consecutive ones. f must
+        /// thus be safe to call concurrently on different rows.
+        /// \param f function (e.g. lambda) taking (T* p, size_t n, const Coords<dim>& c)
+        /// \param grain maximum number of consecutive rows processed by a thread at once (0 for automatic)
+        ///
+        /// \dontinclude Common/test/test.cpp \skip parallel()
+        /// \skipline parallel row traversal
+        /// \until ...
+        template <typename F> void parallelForEachRow(F f, size_t grain=0) {
+            T* d=this->data();
+            parallelForRanges(0,rowCount(),[&](size_t b, size_t e) {
+                forRows(b,e,[&](size_t o, size_t n, const Coords<dim>& c) { f(d+o,n,c); });
+            },grain);
+        }
+        /// Parallel row traversal (read only).
+        /// Same as forEachRow() const, rows being processed in parallel.
+        /// \param f function (e.g. lambda) taking (const T* p, size_t n, const Coords<dim>& c)
+        /// \param grain maximum number of consecutive rows processed by a thread at once (0 for automatic)
+        template <typename F> void parallelForEachRow(F f, size_t grain=0) const {
+            const T* d=this->data();
+            parallelForRanges(0,rowCount(),[&](size_t b, size_t e) {
+                forRows(b,e,[&](size_t o, size_t n, const Coords<dim>& c) { f(d+o,n,c); });
+            },grain);
+        }
+        /// Parallel slab traversal.
+        /// Splits the array along its last dimension in slabs processed in parallel (see Parallel): calls f(b,e) for
+        /// consecutive ranges [b,e) of indices along dimension dim-1 (e.g. bands of lines of an image, or of slices
+        /// of a volume), covering [0,size(dim-1)).
+        /// \param f function (e.g. lambda) taking (int b, int e)
+        /// \param grain maximum thickness of slabs (0 for automatic)
+        ///
+        /// \dontinclude Common/test/test.cpp \skip parallel()
+        /// \skipline parallel slab traversal
+        /// \until ...
+        template <typename F> void parallelForEachSlab(F f, size_t grain=0) const {
+            if (totalSize()==0)
+                return;
+            parallelForRanges(0,size_t(_sz[dim-1]),[&](size_t b, size_t e) { f(int(b),int(e)); },grain);
+        }
+        /// Element traversal.
+        /// Calls f(x) for each element x, in storage order (padding excluded). A single loop when the array is contiguous.
+        /// \param f function (e.g. lambda) taking (T& x)
+        /// 
+        /// \dontinclude Common/test/test.cpp \skip multiArrays()
+        /// \skipline element traversal
+        template <typename F> void forEachElement(F f) {
+            forEachRun([&](size_t o, size_t n, const Coords<dim>&) {
+                T* p=this->data()+o;
+                for (size_t i=0;i<n;i++)
+                    f(p[i]);
+            });
+        }
+        /// Element traversal (read only).
+        /// Calls f(x) for each element x, in storage order (padding excluded).
+        /// \param f function (e.g. lambda) taking (const T& x)
+        template <typename F> void forEachElement(F f) const {
+            forEachRun([&](size_t o, size_t n, const Coords<dim>&) {
+                const T* p=this->data()+o;
+                for (size_t i=0;i<n;i++)
+                    f(p[i]);
+            });
+        }
+        /// Equality test.
+        /// Equality test, component wise, i.e. if arrays have the same sizes and the same values
+        /// \param A array for comparison
+        /// \return true if *this equals A
+        /// 
+        /// \dontinclude Common/test/test.cpp \skip multiArrays()
+        /// \skipline ==
+        bool operator == (const MultiArray& A) const {
+            if (A._sz != _sz) return false;
+            bool eq=true;
+            forEachRun([&](size_t o, size_t n, const Coords<dim>& c) {
+                if (eq)
+                    eq=std::equal(this->data()+o,this->data()+o+n,A.data()+A.offset(c));
+            },!A.isContiguous());
+            return eq;
+        }
+        /// Inequality test.
+        /// Inequality test (component wise)
+        /// \param A array for comparison
+        /// \return true if *this is different from A
+        /// 
+        /// \dontinclude Common/test/test.cpp \skip multiArrays()
+        /// \skipline !=
+        bool operator != (const MultiArray& A) const {
+            return !(*this == A);
+        }
+        /// Range.
+        /// Compute min and max of component values (provided comparisons are defined for type T). Large arrays are
+        /// processed in parallel.
+        /// \param A input array
+        /// \return pair of min,max values
+        /// 
+        /// \dontinclude Common/test/test.cpp \skip multiArrays()
+        /// \skipline range
+        friend std::pair<T,T> range(const MultiArray& A) {
+            return A.template reduce< std::pair<T,T> >([](const T* p, size_t n) { return reduceRange(p,n); },combineRange<T>);
+        }
+        /// Pointwise range.
+        /// Compute pointwise min and pointwise max of component values (provided pointwise comparisons are defined for type T, e.g. FVector)
+        /// \param A input array
+        /// \return pair of pmin, pmax values
+        /// 
+        /// \dontinclude Common/test/test.cpp \skip multiArrays()
+        /// \skipline pointwise range
+        friend std::pair<T,T> prange(const MultiArray& A) {
+            return A.template reduce< std::pair<T,T> >([](const T* p, size_t n) { return reducePRange(p,n); },combinePRange<T>);
+        }
         /// Binary write.
         /// Writes Array to binary stream (size and values)
         /// \param out output stream
@@ -387,7 +726,9 @@ namespace Imagine {
         /// \until ...
         friend void write(std::ostream& out,const MultiArray& A) {
             write(out,A._sz);
-            out.write((const char*)A.data(),A.totalSize()*sizeof(T));
+            A.forEachRun([&](size_t o, size_t n, const Coords<dim>&) {
+                out.write((const char*)(A.data()+o),n*sizeof(T));
+            });
         }
         /// Binary read.
         /// Reads and allocates Array from binary stream (providing size and values)
@@ -402,8 +743,131 @@ namespace Imagine {
             Coords<dim> sz;
             read(in,sz);
             A.setSize(sz);
-            in.read((char*)A.data(),A.totalSize()*sizeof(T));
+            A.forEachRun([&](size_t o, size_t n, const Coords<dim>&) {
+                in.read((char*)(A.data()+o),n*sizeof(T));
+            });
         }
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+        // Saves A to a binary file (see BinaryHeader). Padded rows are kept, so that loading gives the same layout.
+        friend bool saveArrayFile(const MultiArray& A, const std::string& filename, bool checksum, bool compressed) {
+            std::ofstream out(filename.c_str(), std::ios::out|std::ios::binary);
+            if (!out.is_open()) {
+                std::cerr << "Error: failed to open file '" << filename << "' for writing" << std::endl;
+                return false;
+            }
+            const bool dense=A.isDense() && A.totalSize()>0;
+            if (!dense && compressed && A.totalSize()>0) {
+                MultiArray B(A._sz);    // compression needs contiguous values
+                A.forEachRow([&](const T* p, size_t n, const Coords<dim>& c) { std::copy(p,p+n,&B(c)); });
+                return saveArrayFile(B,filename,checksum,compressed);
+            }
+            FArray<size_t,dim> stride=A._stride;
+            if (!dense) {
+                stride[0]=1;
+                for (int i=0;i<dim-1;i++)
+                    stride[i+1]=stride[i]*A._sz[i];
+            }
+            BinaryHeader h=BinaryHeader::make<T>(A._sz,stride,(dense ? A.Base::size() : A.totalSize())*sizeof(T),checksum,compressed);
+            out.write((const char*)&h,sizeof(h));
+            const std::string zeros(size_t(h.dataOffset)-sizeof(h),'\0');
+            out.write(zeros.data(),(std::streamsize)zeros.size());
+            uint32_t crc=0;
+            if (compressed) {
+                const std::vector<unsigned char> c=BinaryChunks::compress(A.data(),size_t(h.dataSize),sizeof(T));
+                out.write((const char*)c.data(),(std::streamsize)c.size());
+                if (checksum)
+                    crc=crc32c(A.data(),size_t(h.dataSize));
+            } else if (dense) {
+                out.write((const char*)A.data(),(std::streamsize)h.dataSize);
+                if (checksum)
+                    crc=crc32c(A.data(),h.dataSize);
+            } else
+                A.forEachRun([&](size_t o, size_t n, const Coords<dim>&) {
+                    out.write((const char*)(A.data()+o),(std::streamsize)(n*sizeof(T)));
+                    if (checksum)
+                        crc=crc32c(A.data()+o,n*sizeof(T),crc);
+                });
+            h.dataCrc=crc;
+            h.seal();
+            out.seekp(0);
+            out.write((const char*)&h,sizeof(h));
+            return !out.fail();
+        }
+        // Loads A from a binary file written by saveArrayFile(), or in the former format (sizes followed by values)
+        friend bool loadArrayFile(MultiArray& A, const std::string& filename, bool mapped) {
+            std::ifstream in(filename.c_str(), std::ios::in|std::ios::binary);
+            if (!in.is_open())  {
+                std::cerr << "Error: failed to open file '" << filename << "' for reading" << std::endl;
+                return false;
+            }
+            BinaryHeader h;
+            in.read((char*)&h,sizeof(h));
+            if (!in || !h.hasMagic()) {
+                in.clear();
+                in.seekg(0);
+                read(in,A);
+                return !in.fail();
+            }
+            const char* error=h.check<T,dim>();
+            in.seekg(0,std::ios::end);
+            const uint64_t fileSize=uint64_t(in.tellg());
+            const bool compressed=(h.flags&BinaryHeader::FLAG_COMPRESSED)!=0;
+            if (!error && fileSize<h.dataOffset+(compressed ? 0 : h.dataSize))
+                error="truncated file";
+            if (error) {
+                std::cerr << "Error: bad binary file '" << filename << "' (" << error << ")" << std::endl;
+                return false;
+            }
+            Coords<dim> sz;
+            FArray<size_t,dim> stride;
+            for (int i=0;i<dim;i++) {
+                sz[i]=int(h.sizes[i]);
+                stride[i]=size_t(h.strides[i]);
+            }
+            if (sz.prod()==0) {
+                A=MultiArray(sz);
+                return true;
+            }
+            void* mem=(mapped && !compressed && h.dataOffset%alignof(T)==0) ? mapFile(filename,size_t(h.dataOffset+h.dataSize)) : 0;
+            if (mem) {
+                A=MultiArray(mem,size_t(h.dataOffset),sz,stride);
+                return true;
+            }
+            MultiArray B(sz,stride);
+            in.seekg(std::streamoff(h.dataOffset));
+            if (compressed) {
+                BinaryChunks c;
+                std::vector<unsigned char> coded;
+                bool ok=c.read(in,h,fileSize-h.dataOffset);
+                if (ok) {
+                    coded.resize(size_t(c.ends.back()));
+                    in.read((char*)coded.data(),(std::streamsize)coded.size());
+                    ok=!in.fail();
+                }
+                unsigned char* const p=(unsigned char*)B.data();
+                std::atomic<bool> valid(ok);
+                if (ok)
+                    parallelFor(0,c.count(),[&](size_t k) {
+                        if (!BinaryChunks::decode(coded.data()+c.begin(k),size_t(c.ends[k]-c.begin(k)),sizeof(T),
+                                                  p+k*c.chunkSize,size_t(c.rawSize(k,h.dataSize))))
+                            valid=false;
+                    },1);
+                if (!valid) {
+                    std::cerr << "Error: bad binary file '" << filename << "' (corrupted compressed data)" << std::endl;
+                    return false;
+                }
+            } else
+                in.read((char*)B.data(),(std::streamsize)h.dataSize);
+            if (in.fail())
+                return false;
+            if ((h.flags&BinaryHeader::FLAG_CRC) && crc32c(B.data(),h.dataSize)!=h.dataCrc) {
+                std::cerr << "Error: bad binary file '" << filename << "' (wrong checksum)" << std::endl;
+                return false;
+            }
+            A=std::move(B);
+            return true;
+        }
+#endif
         /// ASCII write.
         /// Writes Array to stream (size and values)
         /// \param out output stream
@@ -414,11 +878,11 @@ namespace Imagine {
         /// \skipline ASCII write
         /// \until ...
         friend inline std::ostream& operator<<(std::ostream& out,const MultiArray& A) {
-            out<<A.sizes()<<" ";
-            for (size_t i=0;i<A.totalSize();i++) {
-                out<<A[i];
-                if (i<A.totalSize()-1) out<<" ";
-            }
+            out<<A.sizes();
+            A.forEachRun([&](size_t o, size_t n, const Coords<dim>&) {
+                for (size_t i=0;i<n;i++)
+                    out<<" "<<A[o+i];
+            });
             return out;
         }
         /// ASCII read.
@@ -434,8 +898,10 @@ namespace Imagine {
             Coords<dim> sz;
             in>>sz;
             A.setSize(sz);
-            for (size_t i=0;i<A.totalSize();i++) 
-                in>>A[i];
+            A.forEachRun([&](size_t o, size_t n, const Coords<dim>&) {
+                for (size_t i=0;i<n;i++)
+                    in>>A[o+i];
+            });
             return in;
         }
     };
@@ -0,0 +1,318 @@
+// ===========================================================================
+// Imagine++ Libraries
+// Copyright (C) Imagine
+// For detailed information: http://imagine.enpc.fr/software
+// ===========================================================================
+
+namespace Imagine {
+    /// \addtogroup Common
+    /// @{
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    class TaskPool;
+    // Task: run(t) executes and deletes it, then signals its group
+    struct Task {
+        void (*run)(Task*);
+        struct TaskGroup* group;
+    };
+    // Tasks forked by a parallel loop: number of unfinished ones and first exception thrown
+    struct TaskGroup {
+        std::atomic<size_t> left;
+        std::mutex mutex;
+        std::exception_ptr error;
+        TaskGroup() : left(0) {}
+        void fail() {
+            std::lock_guard<std::mutex> l(mutex);
+            if (!error)
+                error=std::current_exception();
+        }
+    };
+    // Worker identity of calling thread: pool and index of its queue (none for other threads)
+    struct TaskWorker {
+        TaskPool* pool;
+        size_t index;
+    };
+    inline TaskWorker& taskWorker() {
+        thread_local TaskWorker w={0,0};
+        return w;
+    }
+
+    // Work stealing pool: each worker pushes and pops tasks at the back of its own queue, and steals at the front of
+    // the others' (oldest, thus largest, tasks) when it is empty. Other threads push to an extra shared queue. Threads
+    // waiting for their tasks execute pending ones, and sleep when there are none until their group is done or tasks
+    // are pushed. Idle workers sleep.
+    class TaskPool {
+        struct Queue {
+            std::mutex mutex;
+            std::deque<Task*> tasks;
+        };
+        std::vector<std::unique_ptr<Queue> > _queues;  // one per worker, then the shared one
+        std::vector<std::thread> _workers;
+        std::atomic<size_t> _pending;                   // tasks in queues
+        std::atomic<bool> _stop;
+        std::mutex _sleep;
+        std::condition_variable _wake;                  // idle workers
+        std::condition_variable _waiters;               // threads waiting for a group (see wait())
+
+        Task* pop(size_t q, bool back) {
+            Queue& Q=*_queues[q];
+            std::lock_guard<std::mutex> l(Q.mutex);
+            if (Q.tasks.empty())
+                return 0;
+            Task* t;
+            if (back) {
+                t=Q.tasks.back();
+                Q.tasks.pop_back();
+            } else {
+                t=Q.tasks.front();
+                Q.tasks.pop_front();
+            }
+            _pending--;
+            return t;
+        }
+        void work(size_t i) {
+            taskWorker().pool=this;
+            taskWorker().index=i;
+            while (!_stop) {
+                if (Task* t=take())
+                    execute(t);
+                else {
+                    std::unique_lock<std::mutex> l(_sleep);
+                    _wake.wait(l,[this]() { return _pending>0 || _stop; });
+                }
+            }
+        }
+    public:
+        // Pool of n worker threads (the calling thread being the n+1^th one when it waits)
+        explicit TaskPool(size_t n) : _pending(0), _stop(false) {
+            for (size_t i=0;i<=n;i++)
+                _queues.emplace_back(new Queue);
+            for (size_t i=0;i<n;i++)
+                _workers.emplace_back([this,i]() { work(i); });
+        }
+        ~TaskPool() {
+            {
+                std::lock_guard<std::mutex> l(_sleep);
+                _stop=true;
+            }
+            _wake.notify_all();
+            for (size_t i=0;i<_workers.size();i++)
+                _workers[i].join();
+        }
+        size_t workers() const { return _workers.size(); }
+        void push(Task* t) {
+            const TaskWorker& w=taskWorker();
+            Queue& Q=*_queues[w.pool==this ? w.index : _workers.size()];
+            {
+                std::lock_guard<std::mutex> l(Q.mutex);
+                Q.tasks.push_back(t);
+                _pending++;
+            }
+            { std::lock_guard<std::mutex> l(_sleep); }  // a worker checking _pending is either before or waiting
+            _wake.notify_one();
+            _waiters.notify_all();
+        }
+        // A pending task: own queue first (most recent), then others (oldest)
+        Task* take() {
+            if (_pending==0)
+                return 0;
+            const TaskWorker& w=taskWorker();
+            const size_t n=_queues.size(), self = w.pool==this ? w.index : n-1;
+            if (Task* t=pop(self,true))
+                return t;
+            for (size_t k=1;k<n;k++)
+                if (Task* t=pop((self+k)%n,false))
+                    return t;
+            return 0;
+        }
+        void execute(Task* t) {
+            TaskGroup* g=t->group;
+            try {
+                t->run(t);
+            } catch (...) {
+                g->fail();
+            }
+            if (--g->left==0) {     // g may be destroyed from now on by its waiting thread
+                { std::lock_guard<std::mutex> l(_sleep); }
+                _waiters.notify_all();
+            }
+        }
+        // Waits for tasks of g, executing pending tasks meanwhile (sleeping when there are none), and rethrows the
+        // first exception of g
+        void wait(TaskGroup& g) {
+            while (g.left>0) {
+                if (Task* t=take())
+                    execute(t);
+                else {
+                    std::unique_lock<std::mutex> l(_sleep);
+                    _waiters.wait(l,[this,&g]() { return g.left==0 || _pending>0; });
+                }
+            }
+            if (g.error)
+                std::rethrow_exception(g.error);
+        }
+    };
+
+    // Pool and thread count (see Parallel). The pool, created at first use, is read without locking.
+    struct ParallelState {
+        std::mutex mutex;
+        std::unique_ptr<TaskPool> pool;
+        std::atomic<TaskPool*> current;     // pool.get()
+        std::atomic<size_t> threads;
+        ParallelState() : current(0) {
+            const char* e=std::getenv("IMAGINE_THREADS");
+            const int n = e ? std::atoi(e) : 0;
+            threads = n>0 ? size_t(n) : std::max(1u,std::thread::hardware_concurrency());
+        }
+        static ParallelState& instance() {
+            static ParallelState* s=new ParallelState;    // never destroyed: workers may outlive static objects
+            return *s;
+        }
+        TaskPool* get() {
+            if (TaskPool* p=current.load(std::memory_order_acquire))
+                return p;
+            std::lock_guard<std::mutex> l(mutex);
+            if (!pool && threads>1) {
+                pool.reset(new TaskPool(threads-1));
+                current.store(pool.get(),std::memory_order_release);
+            }
+            return pool.get();
+        }
+    };
+#endif
+
+    /// \headerfile Imagine/Common.h "Imagine/Common.h"
+    /// Parallelism settings.
+    /// Number of threads used by parallel functions (parallelFor(), parallelReduce(), and those of Imagine++ using
+    /// them: reductions, compression, text files...). Work is shared by a pool of threads created at first use, with
+    /// work stealing: each thread runs pieces of work it split itself, and takes pieces of the others when idle. The
+    /// thread calling a parallel function takes part in it.
+    ///
+    /// Defaults to the number of cores, which can be overridden without recompiling with environment variable
+    /// IMAGINE_THREADS.
+    ///
+    /// \dontinclude Common/test/test.cpp \skip parallel()
+    /// \skipline number of threads
+    class Parallel {
+    public:
+        /// Thread count.
+        /// Number of threads used by parallel functions
+        /// \return count
+        static int threads() { return int(ParallelState::instance().threads); }
+        /// Thread count.
+        /// Sets the number of threads used by parallel functions (1 for sequential execution, 0 for the number of
+        /// cores). Must not be called while parallel functions are running.
+        /// \param n count
+        static void setThreads(int n) {
+            ParallelState& s=ParallelState::instance();
+            std::lock_guard<std::mutex> l(s.mutex);
+            s.current=0;
+            s.pool.reset();
+            s.threads = n>0 ? size_t(n) : std::max(1u,std::thread::hardware_concurrency());
+        }
+    };
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    // Range [b,e) of a parallel loop, split in halves pushed to the pool until at most grain long
+    template <typename F> struct RangeTask : public Task {
+        F* f;
+        size_t b, e, grain;
+        TaskPool* pool;
+        RangeTask(F* f_, size_t b_, size_t e_, size_t grain_, TaskGroup* g, TaskPool* p) : f(f_), b(b_), e(e_), grain(grain_), pool(p) {
+            run=&RangeTask::execute;
+            group=g;
+        }
+        void split() {
+            while (e-b>grain) {
+                const size_t m=b+(e-b)/2;
+                group->left++;
+                pool->push(new RangeTask(f,m,e,grain,group,pool));
+                e=m;
+            }
+            (*f)(b,e);
+        }
+        static void execute(Task* t) {
+            std::unique_ptr<RangeTask> r(static_cast<RangeTask*>(t));
+            r->split();
+        }
+    };
+#endif
+
+    /// Parallel loop over ranges.
+    /// Calls f(b,e) on consecutive ranges [b,e) covering [begin,end), of at most grain indices, in parallel (see
+    /// Parallel). Returns when all are done, rethrowing the first exception thrown by f, if any. Nested calls are
+    /// allowed.
+    /// \param begin first index
+    /// \param end last index + 1
+    /// \param f function of a range
+    /// \param grain maximum length of ranges (0 for ranges of about (end-begin)/(8*threads))
+    ///
+    /// \dontinclude Common/test/test.cpp \skip parallel()
+    /// \skipline parallel loop over ranges
+    /// \until ...
+    template <typename F> void parallelForRanges(size_t begin, size_t end, F f, size_t grain=0) {
+        if (end<=begin)
+            return;
+        const size_t n=end-begin, threads=size_t(Parallel::threads());
+        if (grain==0)
+            grain=std::max<size_t>(1,n/(8*threads));
+        TaskPool* pool = threads>1 && n>grain ? ParallelState::instance().get() : 0;
+        if (!pool) {
+            for (size_t b=begin;b<end;b+=std::min(grain,end-b))
+                f(b,std::min(end,b+grain));
+            return;
+        }
+        TaskGroup g;
+        RangeTask<F> root(&f,begin,end,grain,&g,pool);
+        try {
+            root.split();
+        } catch (...) {
+            g.fail();
+        }
+        pool->wait(g);
+    }
+    /// Parallel loop.
+    /// Calls f(i) for i in [begin,end), in parallel (see Parallel), by ranges of at most grain indices. Returns when
+    /// all are done, rethrowing the first exception thrown by f, if any. Nested calls are allowed.
+    /// \param begin first index
+    /// \param end last index + 1
+    /// \param f function of an index
+    /// \param grain maximum number of consecutive indices done by a thread at once (0 for about (end-begin)/(8*threads))
+    ///
+    /// \dontinclude Common/test/test.cpp \skip parallel()
+    /// \skipline parallel loop
+    template <typename F> void parallelFor(size_t begin, size_t end, F f, size_t grain=0) {
+        parallelForRanges(begin,end,[&f](size_t b, size_t e) {
+            for (size_t i=b;i<e;i++)
+                f(i);
+        },grain);
+    }
+    /// Parallel reduction.
+    /// Reduces [begin,end) in parallel (see Parallel): f(b,e) reduces a range [b,e) to a value of type R, and
+    /// combine(r1,r2) merges values of consecutive ranges. Ranges and the order of combinations only depend on the
+    /// number of indices and grain, not on the number of threads, so that results are reproducible (e.g. rounding
+    /// errors of floating point sums).
+    /// \param begin first index
+    /// \param end last index + 1 (must be greater than begin)
+    /// \param f function of a range
+    /// \param combine function of two results
+    /// \param grain minimum length of ranges
+    /// \return result
+    ///
+    /// \dontinclude Common/test/test.cpp \skip parallel()
+    /// \skipline parallel reduction
+    /// \until ...
+    template <typename R, typename F, typename C> R parallelReduce(size_t begin, size_t end, F f, C combine, size_t grain) {
+        const size_t n=end-begin, k=std::max<size_t>(1,n/std::max<size_t>(grain,1));
+        if (k==1)
+            return f(begin,end);
+        std::vector<R> r(k);
+        parallelFor(0,k,[&](size_t i) { r[i]=f(begin+n*i/k,begin+n*(i+1)/k); },1);
+        R x=r[0];
+        for (size_t i=1;i<k;i++)
+            x=combine(x,r[i]);
+        return x;
+    }
+
+    ///@}
+}
@@ -0,0 +1,364 @@
+// ===========================================================================
+// Imagine++ Libraries
+// Copyright (C) Imagine
+// For detailed information: http://imagine.enpc.fr/software
+// ===========================================================================
+
+namespace Imagine {
+    /// \addtogroup Common
+    /// @{
+
+    /// \headerfile Imagine/Common.h "Imagine/Common.h"
+    /// Set of points, stored coordinate by coordinate.
+    /// Set of points of dimension dim stored as a structure of arrays: first coordinates of all points, then second
+    /// ones... each lane being contiguous and aligned. Kernels on whole sets (transformation, distances, nearest
+    /// points, centroid, bounding box) thus loop on lanes and are vectorized by the compiler, on the contrary to the
+    /// same loops on an array of FVector. Memory is reference counted, as for Array: use clone() when sharing is not
+    /// desired.
+    ///
+    /// Converts from and to arrays of FVector (std::vector, Array, C arrays), e.g. vertices of a Mesh:
+    /// PointSet<float,3>(mesh.vertices()) and mesh.setVertices(P.toVector().data()).
+    ///
+    /// \dontinclude Common/test/test.cpp \skip pointSets()
+    /// \skipline from FVector
+    /// \until to FVector
+    /// \param T coordinate type
+    /// \param dim dimension
+    template <typename T,int dim> class PointSet {
+        Array<T> _data;     // lanes
+        size_t _size;       // number of points
+        size_t _stride;     // distance between lanes: size rounded up so that lanes stay aligned
+        // Kernels loop on chunks of W points, with constant trip count so that the compiler vectorizes them: lanes
+        // are padded to a multiple of W (padding is zeroed at allocation, then holds meaningless values)
+        static const int W=16;
+        static const int BLOCK=256;     // points per block of kernels needing temporaries (multiple of W)
+        static size_t padded(size_t n) { return (n+W-1)/W*W; }
+        void alloc(size_t n) {
+            const size_t a=std::max<size_t>(W,Array<T>::alignment()/sizeof(T));
+            _size=n;
+            _stride=(n+a-1)/a*a;
+            _data=Array<T>(_stride*dim);
+            for (int k=0;k<dim;k++)
+                std::fill(lane(k)+n,lane(k)+_stride,T(0));
+        }
+        // Squared distances to q of points i0..i0+n-1, written to d[0..padded(n)-1]
+        void squaredDists(const FVector<T,dim>& q, size_t i0, size_t n, T* d) const {
+            const size_t m=padded(n);
+            std::fill(d,d+m,T(0));
+            for (int k=0;k<dim;k++) {
+                const T* x=lane(k)+i0;
+                const T c=q[k];
+                for (size_t j0=0;j0<m;j0+=W)
+                    for (int j=0;j<W;j++) {
+                        const T e=x[j0+j]-c;
+                        d[j0+j]+=e*e;
+                    }
+            }
+        }
+    public:
+        /// Empty constructor.
+        /// Constructs an empty set
+        PointSet() : _size(0), _stride(0) {}
+        /// Constructor (known size).
+        /// Constructs a set of n uninitialized points
+        /// \param n number of points
+        explicit PointSet(size_t n) { alloc(n); }
+        /// Constructor from C array.
+        /// Constructs from an array of points (possibly of another type)
+        /// \param p points
+        /// \param n number of points
+        /// \tparam T2 coordinate type of p
+        template <typename T2> PointSet(const FVector<T2,dim>* p, size_t n) {
+            alloc(n);
+            for (int k=0;k<dim;k++) {
+                T* x=lane(k);
+                for (size_t i=0;i<n;i++)
+                    x[i]=T(p[i][k]);
+            }
+        }
+        /// Constructor from vector.
+        /// Constructs from a std::vector of points (possibly of another type)
+        /// \param p points
+        /// \tparam T2 coordinate type of p
+        ///
+        /// \dontinclude Common/test/test.cpp \skip pointSets()
+        /// \skipline from FVector
+        template <typename T2> explicit PointSet(const std::vector<FVector<T2,dim> >& p) {
+            *this=PointSet(p.empty() ? 0 : &p[0],p.size());
+        }
+        /// Constructor from Array.
+        /// Constructs from an Array of points (possibly of another type)
+        /// \param p points
+        /// \tparam T2 coordinate type of p
+        template <typename T2> explicit PointSet(const Array<FVector<T2,dim> >& p) {
+            *this=PointSet(p.data(),p.size());
+        }
+        /// Cloning.
+        /// Creates a copy with its own memory
+        /// \return copy
+        PointSet clone() const {
+            PointSet P;
+            P._data=_data.clone();
+            P._size=_size;
+            P._stride=_stride;
+            return P;
+        }
+        /// Size.
+        /// Number of points
+        /// \return size
+        size_t size() const { return _size; }
+        /// Lane.
+        /// Coordinate k of all points (contiguous, aligned)
+        /// \param k coordinate index
+        /// \return pointer to coordinate k of first point
+        const T* lane(int k) const { assert(k>=0 && k<dim); return _data.data()+_stride*k; }
+        /// Lane.
+        /// Coordinate k of all points (contiguous, aligned)
+        /// \param k coordinate index
+        /// \return pointer to coordinate k of first point
+        T* lane(int k) { assert(k>=0 && k<dim); return _data.data()+_stride*k; }
+        /// Point access.
+        /// Gathers point i
+        /// \param i point index
+        /// \return point
+        ///
+        /// \dontinclude Common/test/test.cpp \skip pointSets()
+        /// \skipline point access
+        FVector<T,dim> operator[](size_t i) const {
+            assert(i<_size);
+            FVector<T,dim> p;
+            for (int k=0;k<dim;k++)
+                p[k]=lane(k)[i];
+            return p;
+        }
+        /// Point write.
+        /// Scatters point i
+        /// \param i point index
+        /// \param p value
+        void set(size_t i, const FVector<T,dim>& p) {
+            assert(i<_size);
+            for (int k=0;k<dim;k++)
+                lane(k)[i]=p[k];
+        }
+        /// Conversion to C array.
+        /// Writes points to an array (possibly of another type) of size() elements
+        /// \param p destination
+        /// \tparam T2 coordinate type of p
+        template <typename T2> void get(FVector<T2,dim>* p) const {
+            for (int k=0;k<dim;k++) {
+                const T* x=lane(k);
+                for (size_t i=0;i<_size;i++)
+                    p[i][k]=T2(x[i]);
+            }
+        }
+        /// Conversion to vector.
+        /// Points as a std::vector of FVector
+        /// \return points
+        ///
+        /// \dontinclude Common/test/test.cpp \skip pointSets()
+        /// \skipline to FVector
+        std::vector<FVector<T,dim> > toVector() const {
+            std::vector<FVector<T,dim> > p(_size);
+            if (_size)
+                get(&p[0]);
+            return p;
+        }
+        /// Conversion to Array.
+        /// Points as an Array of FVector
+        /// \return points
+        Array<FVector<T,dim> > toArray() const {
+            Array<FVector<T,dim> > p(_size);
+            get(p.data());
+            return p;
+        }
+        /// Affine transformation.
+        /// Transforms all points in place: p <- R*p+t
+        /// \param R linear part
+        /// \param t translation
+        /// \return self reference
+        ///
+        /// \dontinclude Common/test/test.cpp \skip pointSets()
+        /// \skipline affine transform
+        PointSet& transform(const FMatrix<T,dim,dim>& R, const FVector<T,dim>& t=FVector<T,dim>(T(0))) {
+            T out[dim][BLOCK];
+            for (size_t i0=0;i0<_size;i0+=BLOCK) {
+                const size_t n=padded(std::min<size_t>(BLOCK,_size-i0));
+                for (int r=0;r<dim;r++) {
+                    T* o=out[r];
+                    std::fill(o,o+n,t[r]);
+                    for (int c=0;c<dim;c++) {
+                        const T* x=lane(c)+i0;
+                        const T a=R(r,c);
+                        for (size_t j0=0;j0<n;j0+=W)
+                            for (int j=0;j<W;j++)
+                                o[j0+j]+=a*x[j0+j];
+                    }
+                }
+                for (int r=0;r<dim;r++)
+                    std::copy(out[r],out[r]+n,lane(r)+i0);
+            }
+            return *this;
+        }
+        /// Projective transformation.
+        /// Transforms all points in place by a matrix acting on homogeneous coordinates (p,1)
+        /// \param H (dim+1)x(dim+1) matrix
+        /// \return self reference
+        ///
+        /// \dontinclude Common/test/test.cpp \skip pointSets()
+        /// \skipline homogeneous transform
+        PointSet& transform(const FMatrix<T,dim+1,dim+1>& H) {
+            T out[dim+1][BLOCK];
+            for (size_t i0=0;i0<_size;i0+=BLOCK) {
+                const size_t m=std::min<size_t>(BLOCK,_size-i0), n=padded(m);
+                for (int r=0;r<=dim;r++) {
+                    T* o=out[r];
+                    std::fill(o,o+n,H(r,dim));
+                    for (int c=0;c<dim;c++) {
+                        const T* x=lane(c)+i0;
+                        const T a=H(r,c);
+                        for (size_t j0=0;j0<n;j0+=W)
+                            for (int j=0;j<W;j++)
+                                o[j0+j]+=a*x[j0+j];
+                    }
+                }
+                std::fill(out[dim]+m,out[dim]+n,T(1));     // padding: no division by 0
+                for (int r=0;r<dim;r++) {
+                    T* x=lane(r)+i0;
+                    for (size_t j0=0;j0<n;j0+=W)
+                        for (int j=0;j<W;j++)
+                            x[j0+j]=out[r][j0+j]/out[dim][j0+j];
+                }
+            }
+            return *this;
+        }
+        /// Squared distances to a point.
+        /// Squared distances of all points to q
+        /// \param P points
+        /// \param q point
+        /// \return Array of size P.size()
+        ///
+        /// \dontinclude Common/test/test.cpp \skip pointSets()
+        /// \skipline squared distances to a point
+        friend Array<T> squaredDist(const PointSet& P, const FVector<T,dim>& q) {
+            Array<T> d(P._size);
+            T b[BLOCK];
+            for (size_t i0=0;i0<P._size;i0+=BLOCK) {
+                const size_t n=std::min<size_t>(BLOCK,P._size-i0);
+                P.squaredDists(q,i0,n,b);
+                std::copy(b,b+n,d.data()+i0);
+            }
+            return d;
+        }
+        /// Pairwise squared distances.
+        /// Squared distances between all points of P and all points of Q
+        /// \param P,Q points
+        /// \return D with D(i,j) squared distance between P[i] and Q[j]
+        ///
+        /// \dontinclude Common/test/test.cpp \skip pointSets()
+        /// \skipline pairwise
+        friend MultiArray<T,2> squaredDist(const PointSet& P, const PointSet& Q) {
+            MultiArray<T,2> D(int(P._size),int(Q._size));
+            T b[BLOCK];
+            for (size_t j=0;j<Q._size;j++)
+                for (size_t i0=0;i0<P._size;i0+=BLOCK) {
+                    const size_t n=std::min<size_t>(BLOCK,P._size-i0);
+                    P.squaredDists(Q[j],i0,n,b);
+                    std::copy(b,b+n,&D(int(i0),int(j)));
+                }
+            return D;
+        }
+        /// Nearest point.
+        /// Nearest point of P to q (brute force)
+        /// \param P points
+        /// \param q point
+        /// \param d2 squared distance to nearest point
+        /// \return index in P of nearest point, -1 if P is empty
+        ///
+        /// \dontinclude Common/test/test.cpp \skip pointSets()
+        /// \skipline nearest point
+        friend long nearest(const PointSet& P, const FVector<T,dim>& q, T& d2) {
+            T d[BLOCK];
+            long best=-1;
+            for (size_t i0=0;i0<P._size;i0+=BLOCK) {
+                const size_t n=std::min<size_t>(BLOCK,P._size-i0);
+                P.squaredDists(q,i0,n,d);
+                for (size_t j=0;j<n;j++)
+                    if (best<0 || d[j]<d2) {
+                        d2=d[j];
+                        best=long(i0+j);
+                    }
+            }
+            return best;
+        }
+        /// Nearest points.
+        /// For each point of Q, nearest point of P (brute force)
+        /// \param P points
+        /// \param Q query points
+        /// \param d2 squared distances of points of Q to their nearest point
+        /// \return indices in P of nearest points
+        ///
+        /// \dontinclude Common/test/test.cpp \skip pointSets()
+        /// \skipline nearest points
+        friend Array<long> nearest(const PointSet& P, const PointSet& Q, Array<T>& d2) {
+            Array<long> idx(Q._size);
+            d2=Array<T>(Q._size);
+            for (size_t j=0;j<Q._size;j++)
+                idx[j]=nearest(P,Q[j],d2[j]);
+            return idx;
+        }
+        /// Centroid.
+        /// Mean of points (accumulated in double)
+        /// \param P points
+        /// \return centroid (0 if P is empty)
+        ///
+        /// \dontinclude Common/test/test.cpp \skip pointSets()
+        /// \skipline centroid
+        friend FVector<T,dim> centroid(const PointSet& P) {
+            FVector<T,dim> c(T(0));
+            if (P._size==0)
+                return c;
+            for (int k=0;k<dim;k++) {
+                const T* x=P.lane(k);
+                double s[8]={0,0,0,0,0,0,0,0};      // independent partial sums: vectorizable
+                size_t i=0;
+                for (;i+8<=P._size;i+=8)
+                    for (int j=0;j<8;j++)
+                        s[j]+=double(x[i+j]);
+                for (;i<P._size;i++)
+                    s[0]+=double(x[i]);
+                c[k]=T((((s[0]+s[1])+(s[2]+s[3]))+((s[4]+s[5])+(s[6]+s[7])))/double(P._size));
+            }
+            return c;
+        }
+        /// Bounding box.
+        /// Smallest box containing all points
+        /// \param P points (not empty)
+        /// \param pmin,pmax box corners
+        ///
+        /// \dontinclude Common/test/test.cpp \skip pointSets()
+        /// \skipline bounding box
+        friend void boundingBox(const PointSet& P, FVector<T,dim>& pmin, FVector<T,dim>& pmax) {
+            assert(P._size>0);
+            for (int k=0;k<dim;k++) {
+                const T* x=P.lane(k);
+                T mn[8],mx[8];
+                for (int j=0;j<8;j++)
+                    mn[j]=mx[j]=x[0];
+                size_t i=0;
+                for (;i+8<=P._size;i+=8)
+                    for (int j=0;j<8;j++) {
+                        mn[j]=std::min(mn[j],x[i+j]);
+                        mx[j]=std::max(mx[j],x[i+j]);
+                    }
+                for (;i<P._size;i++) {
+                    mn[0]=std::min(mn[0],x[i]);
+                    mx[0]=std::max(mx[0],x[i]);
+                }
+                pmin[k]=*std::min_element(mn,mn+8);
+                pmax[k]=*std::max_element(mx,mx+8);
+            }
+        }
+    };
+
+    ///@}
+}
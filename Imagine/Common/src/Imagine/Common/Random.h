@@ -8,21 +8,252 @@ namespace Imagine {
     /// \addtogroup Common
     /// @{
 
+    /// \headerfile Imagine/Common.h "Imagine/Common.h"
+    /// Random generator.
+    /// Counter based generator (Philox4x32-10): the n-th value of a generator is a function of its seed, its stream
+    /// and n only. Generators are independent objects: give each thread its own generator, e.g. with the same seed and
+    /// different streams, to obtain reproducible results whatever the scheduling. Values are drawn 4 by 4 and fill
+    /// functions produce many values at once, both outputs of Box-Muller transforms being used for Gaussian values.
+    ///
+    /// The global functions (doubleRandom(), gaussianRandom()...) use a generator per thread.
+    ///
+    /// \dontinclude Common/test/test.cpp \skip rands()
+    /// \skipline generator
+    /// \until ...
+    class Random {
+        uint32_t _key[2];   // seed
+        uint32_t _ctr[4];   // next block: position (_ctr[0],_ctr[1]) in stream (_ctr[2],_ctr[3])
+        uint32_t _buf[4];   // current block
+        int _next;          // first unused value of _buf
+        double _spare;      // second value of last Box-Muller transform
+        bool _hasSpare;
+
+        static const int BATCH=256;
+        static double pi() { return 3.1415926535897932384626433832795; }
+        // Philox4x32-10 block of counter c with key k
+        static void block(const uint32_t c[4], const uint32_t k[2], uint32_t* out) {
+            uint32_t x0=c[0], x1=c[1], x2=c[2], x3=c[3], k0=k[0], k1=k[1];
+            for (int r=0;r<10;r++) {
+                const uint64_t p0=uint64_t(0xD2511F53u)*x0, p1=uint64_t(0xCD9E8D57u)*x2;
+                x0=uint32_t(p1>>32)^x1^k0;
+                x1=uint32_t(p1);
+                x2=uint32_t(p0>>32)^x3^k1;
+                x3=uint32_t(p0);
+                k0+=0x9E3779B9u;
+                k1+=0xBB67AE85u;
+            }
+            out[0]=x0; out[1]=x1; out[2]=x2; out[3]=x3;
+        }
+        // Blocks of counters c,c+1,...c+B-1, interleaved so that loops vectorize
+        template <int B> static void blocks(const uint32_t c[4], const uint32_t k[2], uint32_t* out) {
+            uint32_t x0[B], x1[B], x2[B], x3[B];
+            for (int j=0;j<B;j++) {
+                x0[j]=c[0]+uint32_t(j);
+                x1[j]=c[1]+(x0[j]<c[0] ? 1u : 0u);
+                x2[j]=c[2];
+                x3[j]=c[3];
+            }
+            uint32_t k0=k[0], k1=k[1];
+            for (int r=0;r<10;r++) {
+                for (int j=0;j<B;j++) {
+                    const uint64_t p0=uint64_t(0xD2511F53u)*x0[j], p1=uint64_t(0xCD9E8D57u)*x2[j];
+                    x0[j]=uint32_t(p1>>32)^x1[j]^k0;
+                    x1[j]=uint32_t(p1);
+                    x2[j]=uint32_t(p0>>32)^x3[j]^k1;
+                    x3[j]=uint32_t(p0);
+                }
+                k0+=0x9E3779B9u;
+                k1+=0xBB67AE85u;
+            }
+            for (int j=0;j<B;j++) {
+                out[4*j]=x0[j]; out[4*j+1]=x1[j]; out[4*j+2]=x2[j]; out[4*j+3]=x3[j];
+            }
+        }
+        void increment(uint32_t n=1) {
+            if ((_ctr[0]+=n)<n)
+                ++_ctr[1];
+        }
+        static double toDouble(uint32_t a, uint32_t b) {   // 53 bits in [0,1[
+            return ((a>>5)*67108864.0+(b>>6))*(1.0/9007199254740992.0);
+        }
+        template <typename T> static T toUniform(const uint32_t* u, int i) {  // i-th value in [0,1[
+            return std::is_same<T,float>::value ? T((u[i]>>8)*(1.f/16777216.f)) : T(toDouble(u[2*i],u[2*i+1]));
+        }
+    public:
+        /// Constructor.
+        /// Generator of given seed and stream
+        /// \param seed seed
+        /// \param stream stream (independent sequences for the same seed)
+        explicit Random(uint64_t seed=0, uint64_t stream=0) {
+            _key[0]=uint32_t(seed); _key[1]=uint32_t(seed>>32);
+            _ctr[0]=_ctr[1]=0;
+            _ctr[2]=uint32_t(stream); _ctr[3]=uint32_t(stream>>32);
+            _next=4;
+            _hasSpare=false;
+        }
+        /// Stream.
+        /// Generator of same seed and given stream
+        /// \param s stream
+        /// \return generator
+        Random stream(uint64_t s) const {
+            return Random(_key[0]|(uint64_t(_key[1])<<32),s);
+        }
+        /// 32 bits.
+        /// Uniform 32 bits value
+        /// \return random value
+        uint32_t next() {
+            if (_next==4) {
+                block(_ctr,_key,_buf);
+                increment();
+                _next=0;
+            }
+            return _buf[_next++];
+        }
+        /// Many 32 bits.
+        /// Uniform 32 bits values (same as n calls to next())
+        /// \param p values
+        /// \param n number of values
+        void generate(uint32_t* p, size_t n) {
+            for (;n>0 && _next<4;n--)
+                *p++=_buf[_next++];
+            for (;n>=64;n-=64,p+=64) {
+                blocks<16>(_ctr,_key,p);
+                increment(16);
+            }
+            for (;n>=4;n-=4,p+=4) {
+                block(_ctr,_key,p);
+                increment();
+            }
+            for (;n>0;n--)
+                *p++=next();
+        }
+        /// Uniform double.
+        /// Uniform double in [0;1[ (53 random bits)
+        /// \return random value
+        double doubleRandom() {
+            const uint32_t a=next();
+            return toDouble(a,next());
+        }
+        /// Uniform int.
+        /// Uniform int between two numbers a and b (included)
+        /// \param a,b bounds
+        /// \return random value
+        int intRandom(int a, int b) {
+            return int(int64_t(a)+int64_t((uint64_t(next())*uint64_t(int64_t(b)-a+1))>>32));
+        }
+        /// Uniform unsigned int.
+        /// Uniform unsigned int between 0 and a (included)
+        /// \param a bound
+        /// \return random value
+        unsigned int uintRandom(unsigned int a) {
+            return (unsigned int)((uint64_t(next())*(uint64_t(a)+1))>>32);
+        }
+        /// Uniform size_t.
+        /// Uniform size_t between 0 and a (included)
+        /// \param a bound
+        /// \return random value
+        size_t size_tRandom(size_t a) {
+            return std::min(a,size_t((double(a)+1)*doubleRandom()));
+        }
+        /// Normal law.
+        /// Normal Gaussian (Box-Muller transform, the second value being returned by the next call)
+        /// \return random value
+        double gaussianRandom() {
+            if (_hasSpare) {
+                _hasSpare=false;
+                return _spare;
+            }
+            const double r=std::sqrt(-2*std::log(1-doubleRandom())), t=2*pi()*doubleRandom();
+            _spare=r*std::sin(t);
+            _hasSpare=true;
+            return r*std::cos(t);
+        }
+        /// Uniform fill.
+        /// Fills with uniform values in [a;b[ (up to rounding)
+        /// \param p values
+        /// \param n number of values
+        /// \param a,b bounds (default=[0;1[)
+        template <typename T> void fillUniform(T* p, size_t n, T a=T(0), T b=T(1)) {
+            static_assert(std::is_floating_point<T>::value,"Uniform fill needs floating point values");
+            const int w = std::is_same<T,float>::value ? 1 : 2;   // 32 bits per value
+            uint32_t u[2*BATCH];
+            const T s=b-a;
+            for (size_t k=0;k<n;k+=BATCH) {
+                const int m=int(std::min<size_t>(BATCH,n-k));
+                generate(u,size_t(w*m));
+                for (int i=0;i<m;i++)
+                    p[k+i]=a+s*toUniform<T>(u,i);
+            }
+        }
+        /// Gaussian fill.
+        /// Fills with values following a Gaussian law, using both values of each Box-Muller transform
+        /// \param p values
+        /// \param n number of values
+        /// \param mean mean (default=0)
+        /// \param sigma standard deviation (default=1)
+        template <typename T> void fillGaussian(T* p, size_t n, T mean=T(0), T sigma=T(1)) {
+            static_assert(std::is_floating_point<T>::value,"Gaussian fill needs floating point values");
+            const int w = std::is_same<T,float>::value ? 1 : 2;
+            uint32_t u[2*BATCH];
+            for (size_t k=0;k<n;k+=BATCH) {
+                const int m=int(std::min<size_t>(BATCH,n-k)), h=(m+1)/2;
+                generate(u,size_t(2*w*h));
+                for (int i=0;i<h;i++) {
+                    const T r=sigma*std::sqrt(-2*std::log(1-toUniform<T>(u,2*i))), t=T(2*pi())*toUniform<T>(u,2*i+1);
+                    p[k+2*i]=mean+r*std::cos(t);
+                    if (2*i+1<m)
+                        p[k+2*i+1]=mean+r*std::sin(t);
+                }
+            }
+        }
+        /// Uniform fill of an nD array.
+        /// Fills A (e.g. an Image<float>) with uniform values in [a;b[
+        /// \param A nD array
+        /// \param a,b bounds (default=[0;1[)
+        ///
+        /// \dontinclude Common/test/test.cpp \skip rands()
+        /// \skipline uniform fill
+        template <typename T, int dim> void fillUniform(MultiArray<T,dim>& A, T a=T(0), T b=T(1)) {
+            A.forEachRow([&](T* p, size_t n, const Coords<dim>&) { fillUniform(p,n,a,b); });
+        }
+        /// Gaussian fill of an nD array.
+        /// Fills A (e.g. an Image<float>) with values following a Gaussian law
+        /// \param A nD array
+        /// \param mean mean (default=0)
+        /// \param sigma standard deviation (default=1)
+        ///
+        /// \dontinclude Common/test/test.cpp \skip rands()
+        /// \skipline Gaussian fill
+        template <typename T, int dim> void fillGaussian(MultiArray<T,dim>& A, T mean=T(0), T sigma=T(1)) {
+            A.forEachRow([&](T* p, size_t n, const Coords<dim>&) { fillGaussian(p,n,mean,sigma); });
+        }
+    };
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    // Generator of the calling thread: stream i for the i-th thread using one, seed given by initRandom()
+    inline Random& threadRandom(bool reseed=false, uint64_t seed=0) {
+        static std::atomic<uint64_t> threads(0);
+        thread_local uint64_t stream=threads++;
+        thread_local Random r(0,stream);
+        if (reseed)
+            r=Random(seed,stream);
+        return r;
+    }
+#endif
 
     /// Init with seed.
-    /// Init with given seed (to obtain the same sequence)
+    /// Init generator of calling thread with given seed (to obtain the same sequence)
     /// \param s seed
-    /// 
+    ///
     /// \dontinclude Common/test/test.cpp \skip rands()
     /// \skipline Init with given seed
     inline void initRandom(unsigned int s)
     {
-        std::srand(s);
-        std::rand();        // The first one is strange (Visual 2003)
+        threadRandom(true,s);
     }
     /// Init.
-    /// Init. Uses a time-dependent seed.
-    /// 
+    /// Init generator of calling thread. Uses a time-dependent seed.
+    ///
     /// \dontinclude Common/test/test.cpp \skip rands()
     /// \skipline Init with time dependent seed
     inline void initRandom()
@@ -30,20 +261,14 @@ namespace Imagine {
         initRandom((unsigned int)std::time(0));
     }
     /// Uniform double.
-    /// Uniform double in [0;1]
+    /// Uniform double in [0;1[
     /// \return random value
     ///
     /// \dontinclude Common/test/test.cpp \skip rands()
     /// \skipline double in [0;1]
     inline double doubleRandom()
     {
-#if (RAND_MAX==0x7fff) // 15 bits? This is really too small!!
-        int a = std::rand()<<15;
-        int b = std::rand();
-        return double(a|b)/((RAND_MAX<<15)|RAND_MAX);
-#else
-        return double(std::rand())/RAND_MAX;
-#endif
+        return threadRandom().doubleRandom();
     }
     /// Uniform int.
     /// Uniform int between to numbers a and b (included)
@@ -54,7 +279,7 @@ namespace Imagine {
     /// \skipline int in [a;b]
     inline int intRandom(int a,int b)
     {
-        return int(a+(b-a+.999)*doubleRandom());
+        return threadRandom().intRandom(a,b);
     }
     /// Uniform unsigned int.
     /// Uniform int between  0 and a (included)
@@ -65,7 +290,7 @@ namespace Imagine {
     /// \skipline unsigned int in [0;a]
     inline unsigned int uintRandom(unsigned int a)
     {
-        return (unsigned int)((a+.999)*doubleRandom());
+        return threadRandom().uintRandom(a);
     }
     /// Uniform size_t.
     /// Uniform size_t between 0 and a (included)
@@ -76,7 +301,7 @@ namespace Imagine {
     /// \skipline size_t in [0;a]
     inline size_t size_tRandom(size_t a)
     {
-        return (size_t)((a+.999)*doubleRandom());
+        return threadRandom().size_tRandom(a);
     }
     /// Normal law.
     /// Normal Gaussian
@@ -86,16 +311,7 @@ namespace Imagine {
     /// \skipline double following a normal Gaussian law
     inline double gaussianRandom()
     {
-        double x; // 1st draw
-        do 
-        x=doubleRandom();
-        while (x==0);
-#ifdef M_PI
-        double pi=M_PI;
-#else
-        double pi=3.1415926535897932384626433832795;
-#endif
-        return double(std::sqrt(-2*std::log(x))*std::cos(2*pi*doubleRandom()));
+        return threadRandom().gaussianRandom();
     }
 
 
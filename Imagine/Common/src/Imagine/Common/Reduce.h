@@ -0,0 +1,209 @@
+// ===========================================================================
+// Imagine++ Libraries
+// Copyright (C) Imagine
+// For detailed information: http://imagine.enpc.fr/software
+// ===========================================================================
+
+namespace Imagine {
+    /// \addtogroup Common
+    /// @{
+
+    /// \headerfile Imagine/Common.h "Imagine/Common.h"
+    /// Accumulator type.
+    /// Type in which sums of values of type T are accumulated (e.g. sum() and norm2() of images): 64 bits integers for
+    /// integer types, double for float, and the same coordinatewise for FVector, RGB and RGBA. Other types are
+    /// accumulated in themselves.
+    /// \param T value type
+    template <typename T> struct SumTraits {
+        /// Accumulator type
+        typedef T type;
+        /// Zero.
+        /// Initial value of sums
+        /// \return zero
+        static type zero() { return type(0); }
+    };
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    template <typename T, typename S> struct SumScalarTraits {
+        typedef S type;
+        static type zero() { return type(0); }
+    };
+    template <> struct SumTraits<char> : public SumScalarTraits<char,long long> {};
+    template <> struct SumTraits<signed char> : public SumScalarTraits<signed char,long long> {};
+    template <> struct SumTraits<short> : public SumScalarTraits<short,long long> {};
+    template <> struct SumTraits<int> : public SumScalarTraits<int,long long> {};
+    template <> struct SumTraits<long> : public SumScalarTraits<long,long long> {};
+    template <> struct SumTraits<long long> : public SumScalarTraits<long long,long long> {};
+    template <> struct SumTraits<unsigned char> : public SumScalarTraits<unsigned char,unsigned long long> {};
+    template <> struct SumTraits<unsigned short> : public SumScalarTraits<unsigned short,unsigned long long> {};
+    template <> struct SumTraits<unsigned int> : public SumScalarTraits<unsigned int,unsigned long long> {};
+    template <> struct SumTraits<unsigned long> : public SumScalarTraits<unsigned long,unsigned long long> {};
+    template <> struct SumTraits<unsigned long long> : public SumScalarTraits<unsigned long long,unsigned long long> {};
+    template <> struct SumTraits<float> : public SumScalarTraits<float,double> {};
+    template <> struct SumTraits<double> : public SumScalarTraits<double,double> {};
+    // Compound types: zero built from FVector (RGBA(T) would set alpha to 1)
+    template <typename T,int dim> struct SumTraits< FVector<T,dim> > {
+        typedef FVector<typename SumTraits<T>::type,dim> type;
+        static type zero() { return type(typename SumTraits<T>::type(0)); }
+    };
+    template <typename T> struct SumTraits< RGB<T> > {
+        typedef RGB<typename SumTraits<T>::type> type;
+        static type zero() { return type(SumTraits< FVector<T,3> >::zero()); }
+    };
+    template <typename T> struct SumTraits< RGBA<T> > {
+        typedef RGBA<typename SumTraits<T>::type> type;
+        static type zero() { return type(SumTraits< FVector<T,4> >::zero()); }
+    };
+
+    // Reductions of contiguous values. Kernels keep REDUCE_LANES independent accumulators so that loops with constant
+    // trip count vectorize and do not wait for the previous addition, and are compiled for each CPU level (see
+    // cpuDispatch()). Large inputs are split into chunks reduced in parallel (see parallelReduce()), partial results
+    // being combined in chunk order.
+    const int REDUCE_LANES=16;
+    const size_t REDUCE_GRAIN=size_t(1)<<17;    // minimum number of elements per chunk
+
+    // Sum of n values, possibly with Kahan compensation. Bytes and shorts are first summed by blocks in 32 bits.
+    template <typename T, bool small=std::is_integral<T>::value && sizeof(T)<=2> struct SumKernel {
+        typedef typename SumTraits<T>::type S;
+        static S sum(const T* p, size_t n, bool compensated) {
+            if (compensated && !std::numeric_limits<S>::is_integer)
+                return kahan(p,n);
+            S s[REDUCE_LANES];
+            for (int j=0;j<REDUCE_LANES;j++)
+                s[j]=SumTraits<T>::zero();
+            size_t i=0;
+            for (;i+REDUCE_LANES<=n;i+=REDUCE_LANES)
+                for (int j=0;j<REDUCE_LANES;j++)
+                    s[j]+=S(p[i+j]);
+            for (;i<n;i++)
+                s[0]+=S(p[i]);
+            for (int w=REDUCE_LANES/2;w>0;w/=2)
+                for (int j=0;j<w;j++)
+                    s[j]+=s[j+w];
+            return s[0];
+        }
+        static S kahan(const T* p, size_t n) {
+            S s=SumTraits<T>::zero(), c=s;
+            for (size_t i=0;i<n;i++) {
+                const S y=S(p[i])-c, t=s+y;
+                c=(t-s)-y;
+                s=t;
+            }
+            return s;
+        }
+    };
+    template <typename T> struct SumKernel<T,true> {
+        typedef typename SumTraits<T>::type S;
+        typedef typename std::conditional<std::is_signed<T>::value,int,unsigned int>::type I;
+        static const size_t BLOCK=size_t(1)<<15;    // |sum| < 2^15*2^16: no 32 bits overflow
+        static S sum(const T* p, size_t n, bool) {
+            S s=0;
+            for (size_t b=0;b<n;b+=BLOCK) {
+                const size_t e=std::min(n,b+BLOCK);
+                I a[REDUCE_LANES]={0};
+                size_t i=b;
+                for (;i+REDUCE_LANES<=e;i+=REDUCE_LANES)
+                    for (int j=0;j<REDUCE_LANES;j++)
+                        a[j]+=I(p[i+j]);
+                for (;i<e;i++)
+                    a[0]+=I(p[i]);
+                for (int j=0;j<REDUCE_LANES;j++)
+                    s+=S(a[j]);
+            }
+            return s;
+        }
+    };
+    template <typename T> typename SumTraits<T>::type reduceSum(const T* p, size_t n, bool compensated=false) {
+        return cpuDispatch([&]() { return SumKernel<T>::sum(p,n,compensated); });
+    }
+
+    // Sum of squares of n scalar values. Squares of bytes are first summed by blocks in 32 bits.
+    template <typename T> typename SumTraits<T>::type norm2Kernel(const T* p, size_t n) {
+        typedef typename SumTraits<T>::type S;
+        if (std::is_integral<T>::value && sizeof(T)==1) {
+            const size_t BLOCK=size_t(1)<<15;       // sum < 2^15*2^16
+            S s=0;
+            for (size_t b=0;b<n;b+=BLOCK) {
+                const size_t e=std::min(n,b+BLOCK);
+                unsigned int a[REDUCE_LANES]={0};
+                size_t i=b;
+                for (;i+REDUCE_LANES<=e;i+=REDUCE_LANES)
+                    for (int j=0;j<REDUCE_LANES;j++)
+                        a[j]+=(unsigned int)(int(p[i+j])*int(p[i+j]));
+                for (;i<e;i++)
+                    a[0]+=(unsigned int)(int(p[i])*int(p[i]));
+                for (int j=0;j<REDUCE_LANES;j++)
+                    s+=S(a[j]);
+            }
+            return s;
+        }
+        S s[REDUCE_LANES];
+        for (int j=0;j<REDUCE_LANES;j++)
+            s[j]=S(0);
+        size_t i=0;
+        for (;i+REDUCE_LANES<=n;i+=REDUCE_LANES)
+            for (int j=0;j<REDUCE_LANES;j++)
+                s[j]+=S(p[i+j])*S(p[i+j]);
+        for (;i<n;i++)
+            s[0]+=S(p[i])*S(p[i]);
+        for (int w=REDUCE_LANES/2;w>0;w/=2)
+            for (int j=0;j<w;j++)
+                s[j]+=s[j+w];
+        return s[0];
+    }
+    template <typename T> typename SumTraits<T>::type reduceNorm2(const T* p, size_t n) {
+        return cpuDispatch([&]() { return norm2Kernel(p,n); });
+    }
+
+    // Min and max of n>0 values (std::min and std::max semantics), scalar types
+    template <typename T> std::pair<T,T> reduceRange(const T* p, size_t n, std::true_type) {
+        T m[REDUCE_LANES], M[REDUCE_LANES];
+        for (int j=0;j<REDUCE_LANES;j++)
+            m[j]=M[j]=p[0];
+        size_t i=0;
+        for (;i+REDUCE_LANES<=n;i+=REDUCE_LANES)
+            for (int j=0;j<REDUCE_LANES;j++) {
+                m[j] = p[i+j]<m[j] ? p[i+j] : m[j];
+                M[j] = M[j]<p[i+j] ? p[i+j] : M[j];
+            }
+        for (;i<n;i++) {
+            m[0]=std::min(m[0],p[i]);
+            M[0]=std::max(M[0],p[i]);
+        }
+        for (int j=1;j<REDUCE_LANES;j++) {
+            m[0]=std::min(m[0],m[j]);
+            M[0]=std::max(M[0],M[j]);
+        }
+        return std::pair<T,T>(m[0],M[0]);
+    }
+    // Other types: a single accumulator (comparisons may be costly)
+    template <typename T> std::pair<T,T> reduceRange(const T* p, size_t n, std::false_type) {
+        std::pair<T,T> r(p[0],p[0]);
+        for (size_t i=1;i<n;i++) {
+            r.first=std::min(r.first,p[i]);
+            r.second=std::max(r.second,p[i]);
+        }
+        return r;
+    }
+    template <typename T> std::pair<T,T> reduceRange(const T* p, size_t n) {
+        return cpuDispatch([&]() { return reduceRange(p,n,std::integral_constant<bool,std::is_arithmetic<T>::value>()); });
+    }
+    template <typename T> std::pair<T,T> combineRange(const std::pair<T,T>& a, const std::pair<T,T>& b) {
+        return std::pair<T,T>(std::min(a.first,b.first),std::max(a.second,b.second));
+    }
+    // Pointwise min and max of n>0 values
+    template <typename T> std::pair<T,T> reducePRange(const T* p, size_t n) {
+        std::pair<T,T> r(p[0],p[0]);
+        for (size_t i=1;i<n;i++) {
+            r.first=pmin(r.first,p[i]);
+            r.second=pmax(r.second,p[i]);
+        }
+        return r;
+    }
+    template <typename T> std::pair<T,T> combinePRange(const std::pair<T,T>& a, const std::pair<T,T>& b) {
+        return std::pair<T,T>(pmin(a.first,b.first),pmax(a.second,b.second));
+    }
+#endif
+
+    ///@}
+}
@@ -0,0 +1,108 @@
+// ===========================================================================
+// Imagine++ Libraries
+// Copyright (C) Imagine
+// For detailed information: http://imagine.enpc.fr/software
+// ===========================================================================
+
+namespace Imagine {
+    /// \addtogroup Common
+    /// @{
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    // Kernels of FVector and FMatrix arithmetic. Generic loops, specialized with SSE2 intrinsics (unless
+    // IMAGINE_NO_SIMD is defined) for FVector<float,3>, FVector<float,4>, FVector<double,2>, FVector<double,3> and
+    // FMatrix<float,4,4> products. Loads and stores are unaligned and never go past the last element: FArray layout
+    // (a plain C array) is unchanged. Cross products stay scalar: shuffles cost more than they save.
+    template <typename T,int dim> struct FVectorLoops {
+        static void add(T* w, const T* a, const T* b) { for (int i=0;i<dim;i++) w[i]=a[i]+b[i]; }
+        static void sub(T* w, const T* a, const T* b) { for (int i=0;i<dim;i++) w[i]=a[i]-b[i]; }
+        static void scale(T* w, const T* a, T s) { for (int i=0;i<dim;i++) w[i]=a[i]*s; }
+        static T dot(const T* a, const T* b) {
+            T s=0;
+            for (int i=0;i<dim;i++)
+                s+=a[i]*b[i];
+            return s;
+        }
+        static void cross(T* w, const T* a, const T* b) {
+            w[0]=a[1]*b[2]-a[2]*b[1];
+            w[1]=a[2]*b[0]-a[0]*b[2];
+            w[2]=a[0]*b[1]-a[1]*b[0];
+        }
+    };
+    template <typename T,int dim> struct FVectorOps : public FVectorLoops<T,dim> {};
+
+    // Column major MxN matrix A times vector v (w=Av, w and v distinct)
+    template <typename T,int M,int N> struct FMatrixOps {
+        static void mulVec(T* w, const T* A, const T* v) {
+            for (int i=0;i<M;i++)
+                w[i]=0;
+            for (int j=0;j<N;j++)
+                for (int i=0;i<M;i++)
+                    w[i]+=A[i+M*j]*v[j];
+        }
+    };
+
+#ifdef IMAGINE_SSE2
+    inline float simdSum(__m128 m) {
+        m=_mm_add_ps(m,_mm_movehl_ps(m,m));
+        return _mm_cvtss_f32(_mm_add_ss(m,_mm_shuffle_ps(m,m,1)));
+    }
+    inline double simdSum(__m128d m) { return _mm_cvtsd_f64(_mm_add_sd(m,_mm_unpackhi_pd(m,m))); }
+    // 3 floats, 4th lane zeroed
+    inline __m128 simdLoad3(const float* p) {
+        return _mm_movelh_ps(_mm_loadl_pi(_mm_setzero_ps(),(const __m64*)p),_mm_load_ss(p+2));
+    }
+    inline void simdStore3(float* p, __m128 m) {
+        _mm_storel_pi((__m64*)p,m);
+        _mm_store_ss(p+2,_mm_movehl_ps(m,m));
+    }
+
+    template <> struct FVectorOps<float,4> : public FVectorLoops<float,4> {
+        static void add(float* w, const float* a, const float* b) { _mm_storeu_ps(w,_mm_add_ps(_mm_loadu_ps(a),_mm_loadu_ps(b))); }
+        static void sub(float* w, const float* a, const float* b) { _mm_storeu_ps(w,_mm_sub_ps(_mm_loadu_ps(a),_mm_loadu_ps(b))); }
+        static void scale(float* w, const float* a, float s) { _mm_storeu_ps(w,_mm_mul_ps(_mm_loadu_ps(a),_mm_set1_ps(s))); }
+        static float dot(const float* a, const float* b) { return simdSum(_mm_mul_ps(_mm_loadu_ps(a),_mm_loadu_ps(b))); }
+    };
+    template <> struct FVectorOps<float,3> : public FVectorLoops<float,3> {
+        static void add(float* w, const float* a, const float* b) { simdStore3(w,_mm_add_ps(simdLoad3(a),simdLoad3(b))); }
+        static void sub(float* w, const float* a, const float* b) { simdStore3(w,_mm_sub_ps(simdLoad3(a),simdLoad3(b))); }
+        static void scale(float* w, const float* a, float s) { simdStore3(w,_mm_mul_ps(simdLoad3(a),_mm_set1_ps(s))); }
+        static float dot(const float* a, const float* b) { return simdSum(_mm_mul_ps(simdLoad3(a),simdLoad3(b))); }
+    };
+    template <> struct FVectorOps<double,2> : public FVectorLoops<double,2> {
+        static void add(double* w, const double* a, const double* b) { _mm_storeu_pd(w,_mm_add_pd(_mm_loadu_pd(a),_mm_loadu_pd(b))); }
+        static void sub(double* w, const double* a, const double* b) { _mm_storeu_pd(w,_mm_sub_pd(_mm_loadu_pd(a),_mm_loadu_pd(b))); }
+        static void scale(double* w, const double* a, double s) { _mm_storeu_pd(w,_mm_mul_pd(_mm_loadu_pd(a),_mm_set1_pd(s))); }
+        static double dot(const double* a, const double* b) { return simdSum(_mm_mul_pd(_mm_loadu_pd(a),_mm_loadu_pd(b))); }
+    };
+    template <> struct FVectorOps<double,3> : public FVectorLoops<double,3> {
+        static void add(double* w, const double* a, const double* b) {
+            _mm_storeu_pd(w,_mm_add_pd(_mm_loadu_pd(a),_mm_loadu_pd(b)));
+            w[2]=a[2]+b[2];
+        }
+        static void sub(double* w, const double* a, const double* b) {
+            _mm_storeu_pd(w,_mm_sub_pd(_mm_loadu_pd(a),_mm_loadu_pd(b)));
+            w[2]=a[2]-b[2];
+        }
+        static void scale(double* w, const double* a, double s) {
+            _mm_storeu_pd(w,_mm_mul_pd(_mm_loadu_pd(a),_mm_set1_pd(s)));
+            w[2]=a[2]*s;
+        }
+        static double dot(const double* a, const double* b) {
+            return simdSum(_mm_mul_pd(_mm_loadu_pd(a),_mm_loadu_pd(b)))+a[2]*b[2];
+        }
+    };
+    template <> struct FMatrixOps<float,4,4> {
+        static void mulVec(float* w, const float* A, const float* v) {
+            __m128 r=_mm_mul_ps(_mm_loadu_ps(A),_mm_set1_ps(v[0]));
+            r=_mm_add_ps(r,_mm_mul_ps(_mm_loadu_ps(A+4),_mm_set1_ps(v[1])));
+            r=_mm_add_ps(r,_mm_mul_ps(_mm_loadu_ps(A+8),_mm_set1_ps(v[2])));
+            r=_mm_add_ps(r,_mm_mul_ps(_mm_loadu_ps(A+12),_mm_set1_ps(v[3])));
+            _mm_storeu_ps(w,r);
+        }
+    };
+#endif
+#endif
+
+    ///@}
+}
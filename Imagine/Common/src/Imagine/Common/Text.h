@@ -0,0 +1,540 @@
+// ===========================================================================
+// Imagine++ Libraries
+// Copyright (C) Imagine
+// For detailed information: http://imagine.enpc.fr/software
+// ===========================================================================
+
+namespace Imagine {
+    /// \addtogroup Common
+    /// @{
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    // Text codec of saveText() and loadText() for arrays: values are formatted and parsed in memory buffers, without
+    // iostreams. Floating point values are written with the shortest decimal representation that reads back to the
+    // same value. The format is the one of operator<<() (whitespace separated values, characters for char types),
+    // so that files can be exchanged both ways.
+
+    const int TEXT_MAX_CHARS=32;    // maximum length of a formatted scalar
+
+    inline bool textSpace(char c) { return c==' ' || c=='\n' || c=='\t' || c=='\r' || c=='\v' || c=='\f'; }
+    inline const char* textSkip(const char* p, const char* e) {
+        while (p<e && textSpace(*p))
+            p++;
+        return p;
+    }
+    // Exact powers of ten
+    inline const double* textPowers() {
+        static const double p[23]={1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,1e12,1e13,1e14,1e15,1e16,
+                                   1e17,1e18,1e19,1e20,1e21,1e22};
+        return p;
+    }
+    inline const long double* textLongPowers() {
+        static const long double p[28]={1e0L,1e1L,1e2L,1e3L,1e4L,1e5L,1e6L,1e7L,1e8L,1e9L,1e10L,1e11L,1e12L,1e13L,
+                                        1e14L,1e15L,1e16L,1e17L,1e18L,1e19L,1e20L,1e21L,1e22L,1e23L,1e24L,1e25L,
+                                        1e26L,1e27L};
+        return p;
+    }
+    // 10^k (k>=0), exact up to 10^27 when long double has a 64 bits mantissa (x87)
+    inline long double textPower(int k) { return k<=27 ? textLongPowers()[k] : std::pow(10.L,(long double)k); }
+    // Whether long double has a 64 bits mantissa, giving exact products of 19 digits integers and powers of ten
+    const bool TEXT_EXTENDED = std::numeric_limits<long double>::digits>=64;
+
+    // Correctly rounded value of m*10^e. Returns false when the fast computation cannot decide (the caller then uses
+    // strtod()). Exact if m<2^53 and |e|<=22 (a single rounding), otherwise computed in extended precision and
+    // rejected if too close to a halfway point between two doubles (within the error bound of the computation: one
+    // rounding if |e|<=27, a few more with std::pow()).
+    inline bool textDecimal(unsigned long long m, int e, double& v) {
+        if (m==0) {
+            v=0;
+            return true;
+        }
+        if (m<(1ULL<<53) && e>=-22 && e<=22) {
+            v = e>=0 ? double(m)*textPowers()[e] : double(m)/textPowers()[-e];
+            return true;
+        }
+        if (!TEXT_EXTENDED)
+            return false;
+        const long double x = e>=0 ? (long double)m*textPower(e) : (long double)m/textPower(-e);
+        v=double(x);
+        if (!(std::abs(v)>=std::numeric_limits<double>::min() && std::abs(v)<=std::numeric_limits<double>::max()))
+            return false;
+        const long double r=x-v;
+        if (r==0)
+            return true;
+        const long double h=((long double)std::nextafter(v,r>0 ? HUGE_VAL : -HUGE_VAL)-v)/2;
+        const long double tolerance=(std::abs(e)<=27 ? 1 : 8)*std::numeric_limits<long double>::epsilon();
+        return std::abs(std::abs(r)-std::abs(h))>std::abs(x)*tolerance;
+    }
+    // Same for float: the double value gives the right float unless it is exactly halfway between two floats
+    inline bool textDecimal(unsigned long long m, int e, float& v) {
+        double d;
+        if (!textDecimal(m,e,d))
+            return false;
+        v=float(d);
+        if (!(std::abs(v)>=std::numeric_limits<float>::min() && std::abs(v)<=std::numeric_limits<float>::max()))
+            return d==0;
+        if (double(v)==d)
+            return true;
+        const float w=std::nextafter(v,d>v ? HUGE_VALF : -HUGE_VALF);
+        return double(v)+double(w)!=2*d;
+    }
+
+    inline char* textFormatUnsigned(char* p, unsigned long long v) {
+        char d[20];
+        int n=0;
+        do {
+            d[n++]=char('0'+v%10);
+            v/=10;
+        } while (v);
+        while (n)
+            *p++=d[--n];
+        return p;
+    }
+    // Writes (-)m*10^e (m>0) like printf("%g") with all digits of m: fixed notation for exponents in [-5,17[
+    inline char* textFormatDecimal(char* p, bool negative, unsigned long long m, int e) {
+        while (m%10==0) {
+            m/=10;
+            e++;
+        }
+        char d[20];
+        int n=0;
+        for (;m;m/=10)
+            d[n++]=char('0'+m%10);
+        const int x=n-1+e;  // exponent of leading digit
+        if (negative)
+            *p++='-';
+        if (x>=0 && x<17) {
+            for (int i=0;i<=x;i++)
+                *p++ = n ? d[--n] : '0';
+            if (n)
+                *p++='.';
+        } else if (x<0 && x>=-5) {
+            *p++='0';
+            *p++='.';
+            for (int i=-1;i>x;i--)
+                *p++='0';
+        } else {
+            *p++=d[--n];
+            if (n)
+                *p++='.';
+        }
+        while (n)
+            *p++=d[--n];
+        if (x>=17 || x<-5) {
+            *p++='e';
+            *p++ = x<0 ? '-' : '+';
+            if (std::abs(x)<10)
+                *p++='0';
+            p=textFormatUnsigned(p,(unsigned long long)std::abs(x));
+        }
+        return p;
+    }
+    // Shortest decimal representation of v reading back to v (by textDecimal()), or given number of significant
+    // digits if precision>=0. Candidates of d digits are round(|v|*10^(d-1-x)), x being the exponent of |v|: the
+    // smallest d is found by bisection between 1 and the number of digits always sufficient (9 for float, 17 for double).
+    template <typename S> char* textFormatFloat(char* p, S v, int precision) {
+        typedef typename std::conditional<sizeof(S)==4,double,long double>::type W;
+        const int maxDigits = sizeof(S)==4 ? 9 : 17;
+        const bool finite = std::abs(v)<=std::numeric_limits<S>::max();
+        if (precision<0 && finite && v!=0) {
+            const bool negative=v<0;
+            const W a=negative ? -W(v) : W(v);
+            const int x=int(std::floor(std::log10(double(a))));
+            unsigned long long best=0;
+            int bestExp=0;
+            // m*10^e candidate of d digits, if it reads back to v
+            auto candidate=[&](int d) {
+                const int k=d-1-x;
+                const W s = sizeof(S)==4 && std::abs(k)<=22 ? W(textPowers()[std::abs(k)]) : W(textPower(std::abs(k)));
+                const W r=std::floor((k>=0 ? a*s : a/s)+W(0.5));
+                if (!(r>=1 && r<W(1e19)))
+                    return false;
+                S b;
+                if (!textDecimal((unsigned long long)r,-k,b)) {   // undecided: standard library
+                    char t[TEXT_MAX_CHARS];
+                    *textFormatDecimal(t,false,(unsigned long long)r,-k)=0;
+                    b = sizeof(S)==4 ? S(std::strtof(t,0)) : S(std::strtod(t,0));
+                }
+                if (b!=S(a))
+                    return false;
+                best=(unsigned long long)r;
+                bestExp=-k;
+                return true;
+            };
+            int lo=0, hi = (sizeof(S)==4 || TEXT_EXTENDED) ? maxDigits : 15;    // lo digits fail, hi succeed
+            if (candidate(hi)) {
+                while (hi-lo>1) {
+                    const int mid=(lo+hi)/2;
+                    if (candidate(mid))
+                        hi=mid;
+                    else
+                        lo=mid;
+                }
+                return textFormatDecimal(p,negative,best,bestExp);  // best: last success, i.e. hi digits
+            }
+            // Rare values (subnormal, or undecided halfway cases): standard library
+            for (int d=1;d<maxDigits;d++) {
+                const int n=std::snprintf(p,TEXT_MAX_CHARS,"%.*g",d,double(v));
+                if ((sizeof(S)==4 ? S(std::strtof(p,0)) : S(std::strtod(p,0)))==v)
+                    return p+n;
+            }
+        }
+        if (v==0 && precision<0) {
+            if (std::signbit(v))
+                *p++='-';
+            *p++='0';
+            return p;
+        }
+        return p+std::snprintf(p,TEXT_MAX_CHARS,"%.*g",precision<0 ? maxDigits : std::min(precision,17),double(v));
+    }
+
+    // Parses a floating point value. Token must end with whitespace or e.
+    template <typename S> bool textParseFloat(const char*& p, const char* e, S& v) {
+        const char* s=p;
+        bool negative=false;
+        if (p<e && (*p=='-' || *p=='+'))
+            negative = *p++=='-';
+        unsigned long long m=0;
+        int n=0, x=0;               // significant digits, exponent
+        bool digits=false, exact=true;
+        for (;p<e && (unsigned char)(*p-'0')<10;p++) {
+            digits=true;
+            if (n<19) {
+                m=m*10+(*p-'0');
+                n+=(m!=0);
+            } else {
+                x++;
+                exact = exact && *p=='0';
+            }
+        }
+        if (p<e && *p=='.')
+            for (p++;p<e && (unsigned char)(*p-'0')<10;p++) {
+                digits=true;
+                if (n<19) {
+                    m=m*10+(*p-'0');
+                    n+=(m!=0);
+                    x--;
+                } else
+                    exact = exact && *p=='0';
+            }
+        if (digits && p<e && (*p=='e' || *p=='E')) {
+            p++;
+            bool ne=false;
+            if (p<e && (*p=='-' || *p=='+'))
+                ne = *p++=='-';
+            int y=0;
+            bool yd=false;
+            for (;p<e && (unsigned char)(*p-'0')<10;p++) {
+                yd=true;
+                y=std::min(y*10+(*p-'0'),100000);
+            }
+            if (!yd)
+                return false;
+            x += ne ? -y : y;
+        }
+        if (digits && (p==e || textSpace(*p)) && exact && textDecimal(m,x,v)) {
+            if (negative)
+                v=-v;
+            return true;
+        }
+        // Long mantissas, halfway cases, inf, nan...: standard library on the whole token
+        while (p<e && !textSpace(*p))
+            p++;
+        char b[64];
+        std::string l;
+        const char* t=b;
+        if (p-s<64) {
+            std::memcpy(b,s,p-s);
+            b[p-s]=0;
+        } else {
+            l.assign(s,p);
+            t=l.c_str();
+        }
+        char* end;
+        v = sizeof(S)==4 ? S(std::strtof(t,&end)) : S(std::strtod(t,&end));
+        return end==t+(p-s) && p>s;
+    }
+
+    // Scalar codecs: format(p,v,precision) writes at most TEXT_MAX_CHARS characters and returns the end, parse(p,e,v)
+    // reads a value at p (after whitespace) and moves p after it. chars: each non space character is a value.
+    template <typename T> struct TextScalar {
+        static const bool fast=false, chars=false;
+    };
+    template <typename T> struct TextInteger {
+        static const bool fast=true, chars=false;
+        static char* format(char* p, T v, int) {
+            if (v<T(0)) {
+                *p++='-';
+                return textFormatUnsigned(p,0ULL-(unsigned long long)v);
+            }
+            return textFormatUnsigned(p,(unsigned long long)v);
+        }
+        static bool parse(const char*& p, const char* e, T& v) {
+            bool negative=false;
+            if (p<e && (*p=='-' || *p=='+'))
+                negative = *p++=='-';
+            unsigned long long m=0;
+            const char* s=p;
+            for (;p<e && (unsigned char)(*p-'0')<10;p++) {
+                const unsigned d=unsigned(*p-'0');
+                if (m>~0ULL/10 || m*10>~0ULL-d)
+                    return false;
+                m=m*10+d;
+            }
+            if (p==s || (p<e && !textSpace(*p)))
+                return false;
+            if (negative) {
+                if (!std::numeric_limits<T>::is_signed || m>(unsigned long long)std::numeric_limits<T>::max()+1)
+                    return false;
+                v=T(0ULL-m);
+            } else {
+                if (m>(unsigned long long)std::numeric_limits<T>::max())
+                    return false;
+                v=T(m);
+            }
+            return true;
+        }
+    };
+    template <typename T> struct TextChar {
+        static const bool fast=true, chars=true;
+        static char* format(char* p, T v, int) {
+            *p++=char(v);
+            return p;
+        }
+        static bool parse(const char*& p, const char* e, T& v) {
+            if (p==e)
+                return false;
+            v=T(*p++);
+            return true;
+        }
+    };
+    template <typename T> struct TextFloat {
+        static const bool fast=true, chars=false;
+        static char* format(char* p, T v, int precision) { return textFormatFloat(p,v,precision); }
+        static bool parse(const char*& p, const char* e, T& v) { return textParseFloat(p,e,v); }
+    };
+    template <> struct TextScalar<bool> {
+        static const bool fast=true, chars=false;
+        static char* format(char* p, bool v, int) {
+            *p++ = v ? '1' : '0';
+            return p;
+        }
+        static bool parse(const char*& p, const char* e, bool& v) {
+            int i;
+            if (!TextInteger<int>::parse(p,e,i) || (i!=0 && i!=1))
+                return false;
+            v = i==1;
+            return true;
+        }
+    };
+    template <> struct TextScalar<char> : public TextChar<char> {};
+    template <> struct TextScalar<signed char> : public TextChar<signed char> {};
+    template <> struct TextScalar<unsigned char> : public TextChar<unsigned char> {};
+    template <> struct TextScalar<short> : public TextInteger<short> {};
+    template <> struct TextScalar<unsigned short> : public TextInteger<unsigned short> {};
+    template <> struct TextScalar<int> : public TextInteger<int> {};
+    template <> struct TextScalar<unsigned int> : public TextInteger<unsigned int> {};
+    template <> struct TextScalar<long> : public TextInteger<long> {};
+    template <> struct TextScalar<unsigned long> : public TextInteger<unsigned long> {};
+    template <> struct TextScalar<long long> : public TextInteger<long long> {};
+    template <> struct TextScalar<unsigned long long> : public TextInteger<unsigned long long> {};
+    template <> struct TextScalar<float> : public TextFloat<float> {};
+    template <> struct TextScalar<double> : public TextFloat<double> {};
+
+    // Element codecs: scalars, or fixed size arrays of scalars (FArray, FVector, Coords, RGB...) written as their
+    // coordinates, characters being then written as integers (as Color, e.g. "65 32 10"). size: number of scalar values
+    // per element.
+    template <typename S,int n> std::integral_constant<int,n> textFArraySize(const FArray<S,n>*);
+    std::integral_constant<int,0> textFArraySize(const void*);
+    template <typename S,int n> S textFArrayScalar(const FArray<S,n>*);
+    template <typename T, int n=decltype(textFArraySize((const T*)0))::value> struct TextElement {
+        typedef decltype(textFArrayScalar((const T*)0)) S;
+        typedef typename std::conditional<TextScalar<S>::chars,TextInteger<S>,TextScalar<S> >::type Scalar;
+        static const bool fast=Scalar::fast;
+        static const int size=n;
+        static char* format(char* p, const T& v, int precision) {
+            for (int i=0;i<n;i++) {
+                if (i)
+                    *p++=' ';
+                p=Scalar::format(p,v[i],precision);
+            }
+            return p;
+        }
+        static bool parse(const char*& p, const char* e, T& v) {
+            for (int i=0;i<n;i++) {
+                p=textSkip(p,e);
+                if (!Scalar::parse(p,e,v[i]))
+                    return false;
+            }
+            return true;
+        }
+    };
+    template <typename T> struct TextElement<T,0> {
+        typedef TextScalar<T> Scalar;
+        static const bool fast=Scalar::fast;
+        static const int size=1;
+        static char* format(char* p, const T& v, int precision) { return Scalar::format(p,v,precision); }
+        static bool parse(const char*& p, const char* e, T& v) {
+            p=textSkip(p,e);
+            return Scalar::parse(p,e,v);
+        }
+    };
+    template <typename T> bool textParse(const char*& p, const char* e, T& v) { return TextElement<T>::parse(p,e,v); }
+
+    // Writes values get(i), i in [0,n), each preceded by a space if lead is true, otherwise separated by spaces, rows
+    // of rowLength values being ended by newlines (0 for none). Values are formatted in parallel by pieces, written
+    // in order.
+    template <typename T, typename G> bool textWrite(std::ostream& out, size_t n, size_t rowLength, bool lead, G get,
+                                                     int precision) {
+        typedef TextElement<T> E;
+        const size_t piece=size_t(1)<<16;
+        const size_t pieces=(n+piece-1)/piece, batch=4*size_t(Parallel::threads());
+        std::vector<std::string> buf(std::min(pieces,batch));
+        for (size_t b=0;b<pieces;b+=batch) {
+            const size_t m=std::min(batch,pieces-b);
+            parallelFor(0,m,[&](size_t k) {
+                const size_t i0=(b+k)*piece, i1=std::min(n,i0+piece);
+                std::string& s=buf[k];
+                s.resize((i1-i0)*(E::size*(TEXT_MAX_CHARS+1)+1));
+                char* const s0=&s[0];
+                char* p=s0;
+                for (size_t i=i0;i<i1;i++) {
+                    if (lead || (rowLength ? i%rowLength : i)!=0)
+                        *p++=' ';
+                    p=E::format(p,get(i),precision);
+                    if (rowLength && i%rowLength==rowLength-1)
+                        *p++='\n';
+                }
+                s.resize(size_t(p-s0));
+            },1);
+            for (size_t k=0;k<m;k++)
+                out.write(buf[k].data(),(std::streamsize)buf[k].size());
+        }
+        return !out.fail();
+    }
+
+    // Text file in memory: mapped if possible, read otherwise
+    class TextBuffer {
+        void* _mem;
+        size_t _size;
+        std::vector<char> _copy;
+        bool _ok;
+        TextBuffer(const TextBuffer&);
+        void operator=(const TextBuffer&);
+    public:
+        TextBuffer(const std::string& filename) : _mem(0), _size(0), _ok(false) {
+            std::ifstream in(filename.c_str(), std::ios::in|std::ios::binary|std::ios::ate);
+            if (!in.is_open()) {
+                std::cerr << "Error: failed to open file '" << filename << "' for reading" << std::endl;
+                return;
+            }
+            _size=size_t(in.tellg());
+            _mem=mapFile(filename,_size);
+            if (!_mem) {
+                _copy.resize(_size);
+                in.seekg(0);
+                in.read(_copy.data(),(std::streamsize)_size);
+                if (in.fail())
+                    return;
+            }
+            _ok=true;
+        }
+        ~TextBuffer() {
+            if (_mem)
+                unmapFile(_mem,_size);
+        }
+        bool isOpen() const { return _ok; }
+        const char* begin() const { return _mem ? (const char*)_mem : _copy.data(); }
+        const char* end() const { return begin()+_size; }
+    };
+
+    // Number of values (scalars) in [p,e)
+    template <bool chars> size_t textCount(const char* p, const char* e) {
+        size_t n=0;
+        bool space=true;
+        for (;p<e;p++) {
+            const bool s=textSpace(*p);
+            n += chars ? !s : (space && !s);
+            space=s;
+        }
+        return n;
+    }
+    // Skips k values
+    template <bool chars> const char* textSkipValues(const char* p, const char* e, size_t k) {
+        for (;k>0;k--) {
+            p=textSkip(p,e);
+            if (chars)
+                p += p<e;
+            else
+                while (p<e && !textSpace(*p))
+                    p++;
+        }
+        return p;
+    }
+
+    // Reads n values at p, calling set(i,v) for the i^th one, and moves p after them. Large buffers are cut in parts
+    // at line ends (or spaces for long lines), values of each part are counted in parallel, then parsed in parallel.
+    template <typename T, typename F> bool textRead(const char*& p, const char* e, size_t n, F set) {
+        typedef TextElement<T> E;
+        const bool chars=E::Scalar::chars;
+        const size_t part=size_t(1)<<22;
+        const size_t threads=size_t(Parallel::threads());
+        const size_t k = threads>1 ? std::min<size_t>(size_t(e-p)/part,4*threads) : 0;
+        if (k<=1) {
+            T v;
+            for (size_t i=0;i<n;i++) {
+                if (!E::parse(p,e,v))
+                    return false;
+                set(i,v);
+            }
+            return true;
+        }
+        std::vector<const char*> b(k+1);
+        b[0]=p;
+        b[k]=e;
+        for (size_t j=1;j<k;j++) {
+            const char* q=std::max(b[j-1],p+(e-p)/k*j);
+            const char* l=(const char*)std::memchr(q,'\n',size_t(std::min<ptrdiff_t>(e-q,part/2)));
+            if (l)
+                q=l;
+            else
+                while (q<e && !textSpace(*q))
+                    q++;
+            b[j]=q;
+        }
+        std::vector<size_t> t(k+1,0);    // index of first value (scalar) of each part
+        parallelFor(0,k,[&](size_t j) { t[j+1]=chars ? textCount<true>(b[j],b[j+1]) : textCount<false>(b[j],b[j+1]); },1);
+        for (size_t j=1;j<=k;j++)
+            t[j]+=t[j-1];
+        // Parts start with whole elements
+        for (size_t j=1;j<k;j++) {
+            const size_t r=(E::size-t[j]%E::size)%E::size;
+            if (r) {
+                b[j]=chars ? textSkipValues<true>(b[j],e,r) : textSkipValues<false>(b[j],e,r);
+                t[j]+=r;
+            }
+            if (t[j]>t[j+1]) {
+                b[j+1]=b[j];
+                t[j+1]=t[j];
+            }
+        }
+        if (t[k]<n*E::size)
+            return false;
+        std::atomic<bool> ok(true);
+        parallelFor(0,k,[&](size_t j) {
+            const char* q=b[j];
+            T v;
+            for (size_t i=t[j]/E::size, i1=std::min(n,t[j+1]/E::size);i<i1 && ok;i++) {
+                if (!E::parse(q,b[j+1],v))
+                    ok=false;
+                else
+                    set(i,v);
+            }
+        },1);
+        p=e;
+        return ok;
+    }
+#endif
+
+    ///@}
+}
@@ -11,23 +11,22 @@ namespace Imagine {
 
     /// \headerfile Imagine/Common.h "Imagine/Common.h"
     /// Timers.
-    /// Small timer class
+    /// Small timer class, measuring wall clock time with a monotonic clock (nanosecond resolution on most platforms).
+    /// Time spent by other threads or waiting is thus counted.
     class Timer {
     private:
-        double _start;
-        static double time() {
-#if _WIN32
-            return double(std::clock())/CLOCKS_PER_SEC;
-#else
-            struct tms b;
-            times(&b);
-            return double(b.tms_utime)/sysconf(_SC_CLK_TCK);
-#endif
-        }
+        uint64_t _start;
     public:
+        /// Current time.
+        /// Nanoseconds on a monotonic clock (since an unspecified origin)
+        /// \return nanoseconds
+        static uint64_t now() {
+            return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
         /// Constructor.
         /// Constructs and start a timer
-        /// 
+        ///
         /// \dontinclude Common/test/test.cpp \skip timers()
         /// \skipline construct
         Timer() {
@@ -41,7 +40,16 @@ namespace Imagine {
         /// \skipline construct
         /// \until seconds for code 3
         double lap() const {
-            return Timer::time() - _start;
+            return double(lapNs())*1e-9;
+        }
+        /// Lap in nanoseconds.
+        /// Nanoseconds since construction of latest reset()
+        /// \return nanoseconds
+        ///
+        /// \dontinclude Common/test/test.cpp \skip timers()
+        /// \skipline nanoseconds
+        uint64_t lapNs() const {
+            return now() - _start;
         }
         /// Reset.
         /// Reset timer
@@ -49,7 +57,292 @@ namespace Imagine {
         /// \dontinclude Common/test/test.cpp \skip timers()
         /// \skipline reset
         void reset() {
-            _start = Timer::time();
+            _start = now();
+        }
+    };
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    // Statistics of a profiled scope, its children being the scopes opened inside it
+    struct ProfileNode {
+        static const int BUCKETS=8*62;  // durations histogram: 8 buckets per power of 2 (12% precision)
+        std::string name;
+        ProfileNode* parent;
+        uint64_t count, total, min, max;
+        uint32_t histogram[BUCKETS];
+        std::vector<std::unique_ptr<ProfileNode> > children;
+
+        ProfileNode(const std::string& n="", ProfileNode* p=0) : name(n), parent(p) { clear(); }
+        void clear() {
+            count=total=max=0;
+            min=std::numeric_limits<uint64_t>::max();
+            std::fill(histogram,histogram+BUCKETS,0u);
+            for (size_t i=0;i<children.size();i++)
+                children[i]->clear();
+        }
+        static int bucket(uint64_t ns) {
+            if (ns<8)
+                return int(ns);
+            int e=3;
+            while (e<63 && (ns>>(e+1))!=0)
+                e++;
+            return std::min(BUCKETS-1,8*(e-2)+int((ns>>(e-3))&7));
+        }
+        static uint64_t bucketStart(int b) {
+            return b<8 ? uint64_t(b) : uint64_t(8+b%8)<<(b/8-1);
+        }
+        ProfileNode* child(const char* n) {
+            for (size_t i=0;i<children.size();i++)
+                if (children[i]->name==n)
+                    return children[i].get();
+            children.emplace_back(new ProfileNode(n,this));
+            return children.back().get();
+        }
+        void add(uint64_t ns) {
+            count++;
+            total+=ns;
+            min=std::min(min,ns);
+            max=std::max(max,ns);
+            histogram[bucket(ns)]++;
+        }
+        void merge(const ProfileNode& n) {
+            count+=n.count;
+            total+=n.total;
+            min=std::min(min,n.min);
+            max=std::max(max,n.max);
+            for (int b=0;b<BUCKETS;b++)
+                histogram[b]+=n.histogram[b];
+            for (size_t i=0;i<n.children.size();i++)
+                child(n.children[i]->name.c_str())->merge(*n.children[i]);
+        }
+        // Duration below which a fraction p of calls are (middle of histogram bucket)
+        uint64_t percentile(double p) const {
+            uint64_t seen=0;
+            for (int b=0;b<BUCKETS;b++)
+                if ((seen+=histogram[b])>=p*count && histogram[b]) {
+                    const uint64_t s=bucketStart(b), e = b+1<BUCKETS ? bucketStart(b+1) : max;
+                    return std::max(min,std::min(max,s+(e-s)/2));
+                }
+            return max;
+        }
+    };
+
+    // Profile of one thread
+    struct ThreadProfile {
+        std::mutex mutex;       // held when recording, so that reports can be made while threads run
+        ProfileNode root;
+        ProfileNode* current;   // innermost open scope
+        ThreadProfile();
+        ~ThreadProfile();
+    };
+#endif
+
+    /// \headerfile Imagine/Common.h "Imagine/Common.h"
+    /// Profiler.
+    /// Gathers durations of scopes marked by ScopedTimer in all threads: calls, total, mean, min, max and percentiles
+    /// of durations, for each path of nested scopes (e.g. deriche inside blur is reported apart from deriche alone).
+    /// Each thread records in its own profile, which are merged by reports.
+    ///
+    /// Profiling is disabled by default, ScopedTimer then costing a test. It is enabled by enable() or, without
+    /// recompiling, by setting environment variable IMAGINE_PROFILE before running the program: to "1" to print
+    /// report() on std::cerr at exit, or to a file name to save saveJson() in it at exit. Functions of Images (e.g.
+    /// blur, deriche) and LinAlg (e.g. svd, linSolve) are marked.
+    ///
+    /// \dontinclude Common/test/test.cpp \skip timers()
+    /// \skipline enable profiler
+    /// \until JSON
+    class Profiler {
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+        std::mutex _mutex;
+        std::vector<ThreadProfile*> _threads;   // live threads
+        ProfileNode _finished;                  // profiles of finished threads
+        std::atomic<bool> _enabled;
+        std::string _output;                    // IMAGINE_PROFILE
+
+        Profiler() : _enabled(false) {
+            const char* e=std::getenv("IMAGINE_PROFILE");
+            _output = (e && std::strcmp(e,"0")!=0) ? e : "";
+            _enabled = !_output.empty();
+        }
+        ~Profiler() {
+            if (_output=="1")
+                report(std::cerr);
+            else if (!_output.empty())
+                saveJson(_output);
+        }
+        static Profiler& instance() {
+            static Profiler p;
+            return p;
+        }
+        static ProfileNode merged() {
+            Profiler& p=instance();
+            std::lock_guard<std::mutex> l(p._mutex);
+            ProfileNode r;
+            r.merge(p._finished);
+            for (size_t i=0;i<p._threads.size();i++) {
+                std::lock_guard<std::mutex> lt(p._threads[i]->mutex);
+                r.merge(p._threads[i]->root);
+            }
+            return r;
+        }
+        static void report(std::ostream& out, const ProfileNode& n, int depth) {
+            for (size_t i=0;i<n.children.size();i++) {
+                const ProfileNode& c=*n.children[i];
+                if (c.count) {
+                    const std::string name=std::string(2*depth,' ')+c.name;
+                    out << std::left << std::setw(32) << name << std::right << std::setw(10) << c.count;
+                    const double values[7]={double(c.total),double(c.total)/c.count,double(c.min),
+                                            double(c.percentile(.5)),double(c.percentile(.9)),
+                                            double(c.percentile(.99)),double(c.max)};
+                    for (int k=0;k<7;k++)
+                        out << std::setw(12) << std::setprecision(4) << values[k]*1e-6;
+                    out << std::endl;
+                }
+                report(out,c,depth+1);
+            }
+        }
+        static void json(std::ostream& out, const ProfileNode& n) {
+            out << '[';
+            for (size_t i=0;i<n.children.size();i++) {
+                const ProfileNode& c=*n.children[i];
+                out << (i ? ",{" : "{") << "\"name\":\"";
+                for (size_t k=0;k<c.name.size();k++) {
+                    if (c.name[k]=='"' || c.name[k]=='\\')
+                        out << '\\';
+                    out << c.name[k];
+                }
+                out << "\",\"calls\":" << c.count << ",\"total\":" << c.total << ",\"min\":" << (c.count ? c.min : 0)
+                    << ",\"p50\":" << c.percentile(.5) << ",\"p90\":" << c.percentile(.9) << ",\"p99\":"
+                    << c.percentile(.99) << ",\"max\":" << c.max << ",\"children\":";
+                json(out,c);
+                out << '}';
+            }
+            out << ']';
+        }
+        friend struct ThreadProfile;
+#endif
+    public:
+        /// Enabling.
+        /// Enables or disables recording (initially enabled if IMAGINE_PROFILE is set). Scopes opened while disabled
+        /// are not recorded.
+        /// \param e true to enable
+        static void enable(bool e=true) { instance()._enabled=e; }
+        /// Enabled.
+        /// Whether recording is enabled
+        /// \return status
+        static bool enabled() { return instance()._enabled.load(std::memory_order_relaxed); }
+        /// Reset.
+        /// Clears statistics gathered so far
+        static void reset() {
+            Profiler& p=instance();
+            std::lock_guard<std::mutex> l(p._mutex);
+            p._finished.clear();
+            for (size_t i=0;i<p._threads.size();i++) {
+                std::lock_guard<std::mutex> lt(p._threads[i]->mutex);
+                p._threads[i]->root.clear();
+            }
+        }
+        /// Report.
+        /// Writes a table of statistics of all threads, nested scopes being indented. Durations are in milliseconds.
+        /// \param out output stream
+        static void report(std::ostream& out) {
+            const std::ios::fmtflags f=out.flags();
+            out << std::left << std::setw(32) << "scope (ms)" << std::right << std::setw(10) << "calls";
+            const char* columns[7]={"total","mean","min","p50","p90","p99","max"};
+            for (int k=0;k<7;k++)
+                out << std::setw(12) << columns[k];
+            out << std::endl;
+            report(out,merged(),0);
+            out.flags(f);
+        }
+        /// JSON output.
+        /// Writes statistics of all threads as JSON: an array of scopes, each with name, calls, total, min, p50, p90,
+        /// p99, max (in nanoseconds) and children (array of nested scopes)
+        /// \param out output stream
+        static void writeJson(std::ostream& out) {
+            json(out,merged());
+            out << std::endl;
+        }
+        /// JSON saving.
+        /// Saves writeJson() output in a file
+        /// \param filename file name
+        /// \return false if failed
+        static bool saveJson(const std::string& filename) {
+            std::ofstream out(filename.c_str());
+            if (!out.is_open()) {
+                std::cerr << "Error: failed to open file '" << filename << "' for writing" << std::endl;
+                return false;
+            }
+            writeJson(out);
+            return !out.fail();
+        }
+    };
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    inline ThreadProfile::ThreadProfile() : current(&root) {
+        Profiler& p=Profiler::instance();
+        std::lock_guard<std::mutex> l(p._mutex);
+        p._threads.push_back(this);
+    }
+    inline ThreadProfile::~ThreadProfile() {
+        Profiler& p=Profiler::instance();
+        std::lock_guard<std::mutex> l(p._mutex);
+        p._finished.merge(root);
+        p._threads.erase(std::find(p._threads.begin(),p._threads.end(),this));
+    }
+    inline ThreadProfile& threadProfile() {
+        thread_local ThreadProfile p;
+        return p;
+    }
+#endif
+
+    /// \headerfile Imagine/Common.h "Imagine/Common.h"
+    /// Scoped timer.
+    /// Records in the Profiler the duration between its construction and its destruction, under the given name and
+    /// inside the scopes of the same thread open at construction. Nothing is done if profiling is disabled. If
+    /// MemoryStats are enabled, the scope is also the allocation site of Arrays allocated meanwhile (see MemorySite).
+    ///
+    /// \dontinclude Common/test/test.cpp \skip timers()
+    /// \skipline enable profiler
+    /// \until JSON
+    class ScopedTimer {
+        ThreadProfile* _profile;
+        ProfileNode* _node;
+        uint64_t _start;
+        const char** _site;     // memory site of calling thread (0 if not set)
+        const char* _previous;  // previous memory site
+        ScopedTimer(const ScopedTimer&);
+        void operator=(const ScopedTimer&);
+    public:
+        /// Constructor.
+        /// Opens a scope
+        /// \param name name (usually a literal string)
+        explicit ScopedTimer(const char* name) : _profile(0), _site(0) {
+            if (MemoryStats::enabled()) {
+                _site=&memorySite();
+                _previous=*_site;
+                *_site=name;
+            }
+            if (!Profiler::enabled())
+                return;
+            _profile=&threadProfile();
+            {
+                std::lock_guard<std::mutex> l(_profile->mutex);
+                _node=_profile->current->child(name);
+                _profile->current=_node;
+            }
+            _start=Timer::now();
+        }
+        /// Destructor.
+        /// Closes the scope and records its duration
+        ~ScopedTimer() {
+            if (_site)
+                *_site=_previous;
+            if (!_profile)
+                return;
+            const uint64_t d=Timer::now()-_start;
+            std::lock_guard<std::mutex> l(_profile->mutex);
+            _node->add(d);
+            _profile->current=_node->parent;
         }
     };
 
@@ -0,0 +1,476 @@
+// ===========================================================================
+// Imagine++ Libraries
+// Copyright (C) Imagine
+// For detailed information: http://imagine.enpc.fr/software
+// ===========================================================================
+
+// Micro benchmarks of Common containers.
+// Not a test for correctness: prints timings (and a few sanity checks) to compare implementations.
+
+#include <Imagine/Common.h>
+
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace Imagine;
+
+// Former Array storage, kept here as a reference: separate heap counter, non atomic.
+template <typename T> class TwoAllocArray {
+    int* _count;
+    T* _data;
+    size_t _size;
+public:
+    explicit TwoAllocArray(size_t n) : _count(new int(1)), _data(new T[n]), _size(n) {}
+    TwoAllocArray(const TwoAllocArray& A) : _count(A._count), _data(A._data), _size(A._size) { (*_count)++; }
+    ~TwoAllocArray() {
+        if (--(*_count)==0) {
+            delete _count;
+            delete[] _data;
+        }
+    }
+    T* data() { return _data; }
+};
+
+void allocations() {
+    cout << "Allocation/reference counting of many small arrays" << endl;
+    const int n=2000000;
+    Timer t;
+    float s=0;
+    for (int i=0;i<n;i++) {
+        TwoAllocArray<float> a(16);
+        a.data()[0]=float(i);
+        TwoAllocArray<float> b(a);
+        s+=b.data()[0];
+    }
+    double t0=t.lap();
+    t.reset();
+    for (int i=0;i<n;i++) {
+        Array<float> a(16);
+        a[0]=float(i);
+        Array<float> b(a);
+        s+=b[0];
+    }
+    double t1=t.lap();
+    cout << "  two allocations, int counter:   " << t0 << "s" << endl;
+    cout << "  one allocation, atomic counter: " << t1 << "s" << endl;
+    cout << "  (checksum " << s << ")" << endl;
+}
+
+void sharing() {
+    cout << "Sharing one array between threads" << endl;
+    Array<float> a(1024);
+    a.fill(1.f);
+    vector<thread> workers;
+    const int nthreads=4,n=500000;
+    Timer t;
+    for (int k=0;k<nthreads;k++)
+        workers.push_back(thread([a]() {
+            for (int i=0;i<n;i++) {
+                Array<float> b(a);
+                Array<float> c;
+                c=b;
+            }
+        }));
+    for (size_t k=0;k<workers.size();k++)
+        workers[k].join();
+    cout << "  " << nthreads*n*2 << " copies in " << t.lap() << "s" << endl;
+}
+
+// Former getSubArray: one offset computation per element
+template <typename T, int dim>
+MultiArray<T,dim> subArrayPerElement(const MultiArray<T,dim>& A, const Coords<dim>& offset, const Coords<dim>& sz) {
+    MultiArray<T,dim> S(sz);
+    for (CoordsIterator<dim> p = S.coordsBegin() ; p != S.coordsEnd() ; ++p)
+        S(*p)=A(*p+offset);
+    return S;
+}
+
+template <int dim>
+void crop(const Coords<dim>& sz, const Coords<dim>& offset, const Coords<dim>& csz, int n) {
+    MultiArray<float,dim> A(sz);
+    A.fill(1.f);
+    Timer t;
+    float s=0;
+    for (int i=0;i<n;i++)
+        s+=subArrayPerElement(A,offset,csz)(Coords<dim>(0));
+    double t0=t.lap();
+    t.reset();
+    for (int i=0;i<n;i++)
+        s+=A.getSubArray(offset,csz)(Coords<dim>(0));
+    double t1=t.lap();
+    t.reset();
+    for (int i=0;i<n*1000;i++)
+        s+=A.getSubArrayView(offset,csz)(Coords<dim>(0));
+    double t2=t.lap()/1000;
+    cout << "  " << sz << " -> " << csz << ": per element copy " << t0/n << "s, row copy " << t1/n
+         << "s, view " << t2/n << "s (checksum " << s << ")" << endl;
+}
+
+void crops() {
+    cout << "Cropping regions of interest" << endl;
+    crop(Coords<2>(3840,2160),Coords<2>(960,540),Coords<2>(1920,1080),20);
+    crop(Coords<3>(256,256,256),Coords<3>(64,64,64),Coords<3>(128,128,128),10);
+}
+
+// Former global generator, kept here as a reference: std::rand(), one value of each Box-Muller pair
+double randDouble() {
+#if (RAND_MAX==0x7fff)
+    int a = std::rand()<<15;
+    int b = std::rand();
+    return double(a|b)/((RAND_MAX<<15)|RAND_MAX);
+#else
+    return double(std::rand())/RAND_MAX;
+#endif
+}
+double randGaussian() {
+    double x;
+    do
+        x=randDouble();
+    while (x==0);
+    return std::sqrt(-2*std::log(x))*std::cos(2*3.1415926535897932384626433832795*randDouble());
+}
+
+// Runs f(k) in nthreads threads
+template <typename F> void inThreads(int nthreads, F f) {
+    vector<thread> workers;
+    for (int k=0;k<nthreads;k++)
+        workers.push_back(thread(f,k));
+    for (size_t k=0;k<workers.size();k++)
+        workers[k].join();
+}
+
+void randoms() {
+    cout << "Random numbers" << endl;
+    const int n=10000000, nthreads=4;
+    MultiArray<float,2> N(1000,n/1000);
+    Random rng(1);
+    Timer t;
+    double s=0;
+    for (int i=0;i<n;i++)
+        s+=randDouble();
+    double t0=t.lap();
+    t.reset();
+    for (int i=0;i<n;i++)
+        s+=rng.doubleRandom();
+    double t1=t.lap();
+    t.reset();
+    rng.fillUniform(N);
+    double t2=t.lap();
+    cout << "  uniform: std::rand " << t0 << "s, Random " << t1 << "s, fill " << t2 << "s" << endl;
+    t.reset();
+    for (int i=0;i<n;i++)
+        s+=randGaussian();
+    t0=t.lap();
+    t.reset();
+    for (int i=0;i<n;i++)
+        s+=rng.gaussianRandom();
+    t1=t.lap();
+    t.reset();
+    rng.fillGaussian(N);
+    t2=t.lap();
+    cout << "  Gaussian: std::rand " << t0 << "s, Random " << t1 << "s, fill " << t2 << "s" << endl;
+    vector<double> x(nthreads,0.);
+    t.reset();
+    inThreads(nthreads,[&](int k) { for (int i=0;i<n/nthreads;i++) x[k]+=randDouble(); });
+    t0=t.lap();
+    t.reset();
+    inThreads(nthreads,[&](int k) { Random r=rng.stream(k); for (int i=0;i<n/nthreads;i++) x[k]+=r.doubleRandom(); });
+    t1=t.lap();
+    for (int k=0;k<nthreads;k++)
+        s+=x[k];
+    cout << "  uniform in " << nthreads << " threads: std::rand " << t0 << "s, one stream per thread " << t1 << "s"
+         << " (checksum " << s+N(0,0) << ")" << endl;
+}
+
+// Build with -DIMAGINE_NO_SIMD to compare with generic loops
+template <typename T,int dim>
+void fixedVector(const char* name, int n) {
+    vector<FVector<T,dim> > a(n),b(n),c(n);
+    for (int i=0;i<n;i++)
+        for (int k=0;k<dim;k++) {
+            a[i][k]=T(i%7+k);
+            b[i][k]=T(k-i%5);
+        }
+    Timer t;
+    for (int i=0;i<n;i++)
+        c[i]=(a[i]+b[i])*T(2)-a[i];
+    double t0=t.lap();
+    t.reset();
+    T s=0;
+    for (int i=0;i<n;i++)
+        s+=a[i]*b[i]+norm2(c[i]);
+    double t1=t.lap();
+    t.reset();
+    double t2=0;
+    if (dim==3) {
+        for (int i=0;i<n;i++)
+            c[i]=FVector<T,dim>((FVector<T,3>(a[i].data())^FVector<T,3>(b[i].data())).data());
+        t2=t.lap();
+    }
+    cout << "  " << name << ": +-* " << t0 << "s, dot/norm2 " << t1 << "s";
+    if (dim==3)
+        cout << ", cross " << t2 << "s";
+    cout << " (checksum " << s+c[n/2][0] << ")" << endl;
+}
+
+void fixedVectors() {
+#ifdef IMAGINE_SSE2
+    cout << "Fixed vectors and matrices (SSE2)" << endl;
+#else
+    cout << "Fixed vectors and matrices (generic loops)" << endl;
+#endif
+    const int n=4000000;
+    fixedVector<float,3>("FVector<float,3>",n);
+    fixedVector<float,4>("FVector<float,4>",n);
+    fixedVector<double,2>("FVector<double,2>",n);
+    fixedVector<double,3>("FVector<double,3>",n);
+    vector<FVector<float,4> > v(n);
+    for (int i=0;i<n;i++) {
+        v[i].fill(1.f);
+        v[i][0]=float(i%3);
+        v[i][2]=float(i%5);
+    }
+    FMatrix<float,4,4> A=FMatrix<float,4,4>::Identity(), B;
+    A(0,3)=1; A(1,2)=.5f; A(2,1)=-.5f;
+    Timer t;
+    for (int i=0;i<n;i++)
+        v[i]=A*v[i];
+    double t0=t.lap();
+    t.reset();
+    B=A;
+    for (int i=0;i<n/4;i++)
+        B=A*B*float(1./1.0000001);
+    double t1=t.lap();
+    cout << "  FMatrix<float,4,4>: matrix*vector " << t0 << "s, matrix*matrix (" << n/4 << ") " << t1 << "s"
+         << " (checksum " << v[n/2][0]+B(0,0) << ")" << endl;
+}
+
+void pointSets() {
+    cout << "Point sets: std::vector<FVector> vs PointSet" << endl;
+    const int n=2000000, nq=200, m=20000;
+    vector<FVector<float,3> > v(n);
+    for (int i=0;i<n;i++)
+        v[i]=FVector<float,3>(float(i%101),float(i%103)*.5f,float(i%107)*.25f);
+    PointSet<float,3> P(v);
+    FMatrix<float,3,3> R=FMatrix<float,3,3>::Identity();
+    R(0,1)=.1f; R(1,0)=-.1f;
+    const FVector<float,3> t(1,2,3), q(50,25,12);
+    Timer tm;
+    for (int i=0;i<n;i++)
+        v[i]=R*v[i]+t;
+    double t0=tm.lap();
+    tm.reset();
+    P.transform(R,t);
+    double t1=tm.lap();
+    cout << "  transform: " << t0 << "s / " << t1 << "s" << endl;
+    vector<float> d(n);
+    tm.reset();
+    for (int i=0;i<n;i++)
+        d[i]=norm2(v[i]-q);
+    t0=tm.lap();
+    tm.reset();
+    Array<float> d2=squaredDist(P,q);
+    t1=tm.lap();
+    cout << "  squared distances to a point: " << t0 << "s / " << t1 << "s" << endl;
+    tm.reset();
+    FVector<double,3> c(0.);
+    for (int i=0;i<n;i++)
+        c+=FVector<double,3>(v[i]);
+    FVector<float,3> lo=v[0],hi=v[0];
+    for (int i=0;i<n;i++) {
+        lo=pmin(lo,v[i]);
+        hi=pmax(hi,v[i]);
+    }
+    t0=tm.lap();
+    tm.reset();
+    FVector<float,3> c2=centroid(P),pmin2,pmax2;
+    boundingBox(P,pmin2,pmax2);
+    t1=tm.lap();
+    cout << "  centroid and bounding box: " << t0 << "s / " << t1 << "s" << endl;
+    PointSet<float,3> S(m),Q(nq);
+    for (int i=0;i<m;i++)
+        S.set(i,P[i*(n/m)]);
+    for (int j=0;j<nq;j++)
+        Q.set(j,P[j*(n/nq)]+FVector<float,3>(.3f,.2f,.1f));
+    vector<FVector<float,3> > s=S.toVector(), qv=Q.toVector();
+    tm.reset();
+    long k=0;
+    for (int j=0;j<nq;j++) {
+        float best=norm2(s[0]-qv[j]);
+        for (int i=1;i<m;i++) {
+            const float e=norm2(s[i]-qv[j]);
+            if (e<best) {
+                best=e;
+                k+=i;
+            }
+        }
+    }
+    t0=tm.lap();
+    tm.reset();
+    Array<float> dq;
+    Array<long> kq=nearest(S,Q,dq);
+    t1=tm.lap();
+    cout << "  nearest points (" << nq << " among " << m << "): " << t0 << "s / " << t1 << "s" << endl;
+    cout << "  (checksum " << d[n/2]+d2[n/2]+c[0]/n+c2[0]+lo[1]+pmin2[1]+hi[2]+pmax2[2]+k+kq[nq/2] << ")" << endl;
+}
+
+void texts() {
+    cout << "Text files: operator<< and operator>> vs saveText and loadText" << endl;
+    Array<double> a(2000000);
+    MultiArray<float,2> m(2000,1000);
+    for (size_t i=0;i<a.size();i++)
+        a[i]=sin(double(i))*1000;
+    for (size_t i=0;i<m.totalSize();i++)
+        m[i]=float(i%1000)/7;
+    Timer t;
+    {
+        ofstream out("bench.txt");
+        out.precision(17);
+        out << a;
+    }
+    double t0=t.lap();
+    Array<double> b;
+    t.reset();
+    {
+        ifstream in("bench.txt");
+        in >> b;
+    }
+    double t1=t.lap();
+    t.reset();
+    saveText(a,"bench.txt");
+    double t2=t.lap();
+    Array<double> c;
+    t.reset();
+    loadText(c,"bench.txt");
+    double t3=t.lap();
+    cout << "  Array<double> (" << a.size() << "): write " << t0 << "s / " << t2 << "s, read " << t1 << "s / " << t3 << "s"
+         << (b==a && c==a ? "" : " MISMATCH") << endl;
+    t.reset();
+    {
+        ofstream out("bench.txt");
+        out.precision(9);
+        out << m;
+    }
+    t0=t.lap();
+    MultiArray<float,2> n;
+    t.reset();
+    {
+        ifstream in("bench.txt");
+        in >> n;
+    }
+    t1=t.lap();
+    t.reset();
+    saveText(m,"bench.txt");
+    t2=t.lap();
+    MultiArray<float,2> o;
+    t.reset();
+    loadText(o,"bench.txt");
+    t3=t.lap();
+    cout << "  MultiArray<float,2> " << m.sizes() << ": write " << t0 << "s / " << t2 << "s, read " << t1 << "s / " << t3
+         << "s" << (n==m && o==m ? "" : " MISMATCH") << endl;
+    remove("bench.txt");
+}
+
+// Synthetic image kernel: 3x3 box blur of a 4000x4000 float image, rows in parallel. Efficiency with p threads is
+// t1/(p*tp) (1 for perfect scaling).
+void scaling() {
+    cout << "Parallel scaling: 3x3 blur of a 4000x4000 float image" << endl;
+    const int w=4000, h=4000;
+    MultiArray<float,2> I(w,h), J(w,h);
+    for (size_t i=0;i<I.totalSize();i++)
+        I[i]=float(i%w)+float(i/w%7);
+    const int maxThreads=max(1,int(thread::hardware_concurrency()));
+    double t1=0;
+    for (int p=1;p<=maxThreads;p++) {
+        Parallel::setThreads(p);
+        Timer t;
+        for (int k=0;k<5;k++)
+            J.parallelForEachRow([&](float* q, size_t n, const Coords<2>& c) {
+                const int y=c[1], y0=max(y-1,0), y1=min(y+1,h-1);
+                const float *a=&I(0,y0), *b=&I(0,y), *d=&I(0,y1);
+                q[0]=q[n-1]=b[0];
+                for (size_t x=1;x+1<n;x++)
+                    q[x]=(a[x-1]+a[x]+a[x+1]+b[x-1]+b[x]+b[x+1]+d[x-1]+d[x]+d[x+1])*(1.f/9);
+            });
+        const double tp=t.lap()/5;
+        if (p==1)
+            t1=tp;
+        cout << "  " << p << " thread(s): " << tp*1000 << "ms, speedup " << t1/tp << ", efficiency " << t1/(p*tp)
+             << endl;
+    }
+    Parallel::setThreads(0);
+}
+
+// FFTs: plan preparation vs cached plan, complex vs real transforms (in GFlops, 5n*log2(n) flops per complex
+// transform), and direct vs FFT convolution of n values by kernels of k taps (crossover chosen by FFT_COST).
+void ffts() {
+    cout << "FFTs (one thread)" << endl;
+    Parallel::setThreads(1);
+    const size_t sizes[]={1000,1024,4096,100000,131072};
+    for (size_t n: sizes) {
+        vector<complex<float> > x(n), y(n);
+        vector<float> r(n);
+        vector<complex<float> > R(n/2+1), w(2*n);
+        for (size_t i=0;i<n;i++) {
+            x[i]=complex<float>(float(i%7),float(i%3));
+            r[i]=float(i%7);
+        }
+        Timer t;
+        FFTPlan<float> P(n);
+        const double tp=t.lap();
+        FFTPlan<float>::get(n);
+        t.reset();
+        const shared_ptr<const FFTPlan<float> > Q=FFTPlan<float>::get(n);
+        const double tg=t.lap();
+        const int m=int(max<size_t>(1,20000000/n));
+        t.reset();
+        for (int k=0;k<m;k++)
+            Q->transform(&x[0],&y[0]);
+        const double tc=t.lap()/m;
+        const shared_ptr<const RealFFTPlan<float> > RP=RealFFTPlan<float>::get(n);
+        t.reset();
+        for (int k=0;k<m;k++)
+            RP->forward(&r[0],&R[0],&w[0]);
+        const double tr=t.lap()/m;
+        const double flops=5*double(n)*log2(double(n));
+        cout << "  n=" << n << ": plan " << tp*1e6 << "us (cached " << tg*1e6 << "us), complex " << tc*1e6 << "us ("
+             << flops/tc*1e-9 << " GFlops), real " << tr*1e6 << "us" << endl;
+    }
+    const size_t n=100000;
+    MultiArray<float,1> a((Coords<1>(int(n))));
+    for (size_t i=0;i<n;i++)
+        a[i]=float(i%7);
+    for (size_t k=8;k<=512;k*=2) {
+        MultiArray<float,1> b((Coords<1>(int(k))));
+        for (size_t i=0;i<k;i++)
+            b[i]=1.f/float(i+1);
+        vector<float> c(n+k-1);
+        Timer t;
+        for (size_t i=0;i<n;i++)
+            for (size_t j=0;j<k;j++)
+                c[i+j]+=a[i]*b[j];
+        const double td=t.lap();
+        fftConvolve(a,b);   // plans prepared
+        t.reset();
+        const MultiArray<float,1> f=fftConvolve(a,b);
+        const double tf=t.lap();
+        cout << "  convolution " << n << "x" << k << ": direct " << td*1000 << "ms, FFT " << tf*1000 << "ms"
+             << (abs(f[n/2]-c[n/2])<1e-3f*c[n/2] ? "" : " MISMATCH") << endl;
+    }
+    Parallel::setThreads(0);
+}
+
+int main() {
+    allocations();  // One allocation per array
+    sharing();      // Thread-safe reference counting
+    crops();        // Sub arrays and views
+    randoms();      // Random generators
+    fixedVectors(); // SIMD kernels of FVector and FMatrix
+    pointSets();    // Structure of arrays
+    texts();        // Text files
+    scaling();      // Parallel loops
+    ffts();         // Fast Fourier transforms
+    return 0;
+}
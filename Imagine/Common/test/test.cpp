@@ -128,6 +128,8 @@ void fVectors() {
     x=dist(di,di);                          // distance
     x=intL1Dist(di,di);                     // Integer L1-distance
     x=L1Dist(di,di);                        // L1-distance
+    FVector<float,3> p(1,2,3),q(4,5,6);     // float 3/4 and double 2/3 use SIMD kernels
+    cout << "p+q=" << p+q << " p*q=" << p*q << " p^q=" << (p^q) << " norm2(p)=" << norm2(p) << endl;
 }
 
 void fMatrices() {
@@ -193,6 +195,9 @@ void fMatrices() {
     FVector<double,3> v3;
     v3=A32*v2;                          // matrix * vector
     v2=tmult(A32,v3);                   // matrix^T * vector
+    float t16[]={1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16};
+    FMatrix<float,4,4> A44(t16);        // 4x4 float products use SIMD kernels
+    cout << A44*FVector<float,4>(t16) << endl << A44*FMatrix<float,4,4>::Identity()-A44 << endl;
     double t9[]={1,2,9,3,4,6,5,7,2};    // Some values
     FMatrix<double,1,1> A11(t9);
     FMatrix<double,2,2> A22(t9);
@@ -297,6 +302,7 @@ void arrays() {
     if (a.empty())                  // is empty?
         cout<< "a is empty" << endl;// ...
     size_t s=a.size();              // number of elements
+    size_t al=Array<char>::alignment(); // alignment
     b.fill('x');                    // filling with constant value
     char x;
     x=b[2];                         // read access []
@@ -327,6 +333,16 @@ void arrays() {
     in.open("tmp.txt");                     // ASCII read
     in >> a;                                // ...
     in.close();
+    MemoryStats::enable();                  // enable memory statistics (or set IMAGINE_MEMORY)
+    MemoryStats::setBudget(size_t(1)<<30);  // budget: bad_alloc beyond 1 GiB alive
+    {                                       // ...
+        MemorySite site("arrays test");     // allocation site
+        Array<double> big(1000);            // ...
+        cout << MemoryStats::liveBytes() << " " << MemoryStats::peakBytes() << endl;   // ...
+    }                                       // ...
+    MemoryStats::report(cout);              // report
+    MemoryStats::setBudget(0);
+    MemoryStats::enable(false);
 }
 
 void coords() {
@@ -363,6 +379,7 @@ void multiArrays() {
     MultiArray<char,2> e2(t2,Coords<2>(2,3),true);  // ...
     MultiArray<char,2> g(t,2,3);                // pre-allocated, 2D alias
     MultiArray<char,3> i(t,1,2,3);              // pre-allocated, 3D alias
+    MultiArray<float,2> pd(Coords<2>(5,3),64);  // padded rows
     MultiArray<char,2> jc(e);                   // copy constructor
     MultiArray<int,2> ji(e);                    // from different type
     e.setSize(Coords<2>(4,4));                  // setSize
@@ -372,6 +389,20 @@ void multiArrays() {
     ji=jc;                                      // different type assignment
     a=b.clone();                                // cloning (fresh memory)
     a.fill('x');                                // filling with constant value
+    if (pd.isContiguous())                      // contiguous?
+        cout << "no padding" << endl;
+    if (a==b)   cout << "a equals b" << endl;               // ==
+    if (a!=b)   cout << "a is different from b" << endl;    // !=
+    pd.fill(1.f);
+    pair<float,float> r=range(pd);              // range
+    MultiArray<int,2> big(Coords<2>(1000,1000),64);     // large padded array (parallel reduction)
+    big.fill(0);                                        // ...
+    big(999,999)=-7;big(3,500)=9;                       // ...
+    assert(range(big)==make_pair(-7,9));                // ...
+    MultiArray<Coords<2>,2> f(1,2);             // pointwise range
+    f(0,0)=Coords<2>(1,5);
+    f(0,1)=Coords<2>(4,2);
+    pair<Coords<2>,Coords<2> > p2=prange(f);    // ...
     Coords<2> sizes=a.sizes();                  // sizes
     size_t s=a.totalSize();                     // number of elements
     int s1=a.size(1);                           // i^th size
@@ -379,6 +410,7 @@ void multiArrays() {
     int h=c3.height();                          // Size. alias 1
     int d=c3.depth();                           // Size. alias 2
     a=c2.getSubArray(Coords<2>(1,1),Coords<2>(1,2)); // sub array (fresh memory)
+    a=c2.getSubArrayView(Coords<2>(1,1),Coords<2>(1,2)); // sub array view (shared memory)
     FArray<size_t,3> stride=c3.stride();        // stride
     size_t st1=c3.stride(1);                    // i^th stride
     size_t o=c3.offset(Coords<3>(1,0,1));       // offset
@@ -393,6 +425,9 @@ void multiArrays() {
     c3(1,0,1)=x;                                // write access 3D alias
     for (CoordsIterator<3> it=i.coordsBegin(); it != i.coordsEnd(); ++it )  // coords iterator
         cout << "[" << *it << "]=" << i(*it) << endl;                           // ...
+    i.forEachRow([](char* p, size_t n, const Coords<3>& c) {                // row traversal
+        for (size_t x=0; x<n; x++) p[x]=char(x+c[1]+c[2]); });                  // ...
+    i.forEachElement([](char& v) { v++; });                                   // element traversal
     ofstream out("tmp.bin",ios::binary);    // binary write
     write(out,i);                           // ...
     out.close();
@@ -407,6 +442,47 @@ void multiArrays() {
     in.close();
 }
 
+void pointSets() {
+    cout << "Testing PointSet functions!" << endl;
+    vector<FVector<float,3> > v;
+    for (int i=0;i<1000;i++)
+        v.push_back(FVector<float,3>(float(i%10),float(i/10%10),float(i/100)));
+    PointSet<float,3> P(v);                 // from FVector (e.g. Mesh vertices)
+    FVector<float,3> p=P[123];              // point access
+    cout << p << endl;
+    FMatrix<float,3,3> R(0.f);              // 90 degrees around z
+    R(0,1)=-1; R(1,0)=1; R(2,2)=1;
+    PointSet<float,3> Q=P.clone();
+    Q.transform(R,FVector<float,3>(1,0,0)); // affine transform
+    FMatrix<float,4,4> H=FMatrix<float,4,4>::Identity();
+    H(3,3)=2;
+    Q.transform(H);                         // homogeneous transform
+    Array<float> d=squaredDist(P,p);        // squared distances to a point
+    MultiArray<float,2> D=squaredDist(P,Q); // pairwise squared distances
+    float d2=0;
+    long k=nearest(P,FVector<float,3>(2.2f,3.9f,7.1f),d2);  // nearest point
+    Array<float> d2s;
+    Array<long> ks=nearest(P,Q,d2s);        // nearest points
+    FVector<float,3> c=centroid(P);         // centroid
+    FVector<float,3> pmin,pmax;
+    boundingBox(Q,pmin,pmax);               // bounding box
+    vector<FVector<float,3> > w=Q.toVector();   // to FVector
+    cout << d[0] << " " << D(0,0) << " " << k << " " << d2 << " " << ks[999] << " " << d2s[999] << endl
+         << c << " " << pmin << " " << pmax << " " << w[999] << " " << squaredDist(R*v[999]+FVector<float,3>(1,0,0),w[999]*2.f) << endl;
+}
+
+void moves() {
+    cout << "Testing move functions!" << endl;
+    Array<float> a(10);
+    Array<float> b(std::move(a));               // move constructor (a becomes empty)
+    a=std::move(b);                             // move assignment (b becomes empty)
+    int n=a.useCount();                         // number of users
+    MultiArray<float,2> c(2,3);
+    MultiArray<float,2> d(std::move(c));        // nD move constructor
+    c=std::move(d);                             // nD move assignment
+    cout << n << " " << b.empty() << " " << d.empty() << endl;
+}
+
 void rands() {
     cout << "Testing random functions!"<<endl;
     initRandom(0);                          // Init with given seed
@@ -416,6 +492,12 @@ void rands() {
     cout << uintRandom(15) << " ";          // unsigned int in [0;a]
     cout << size_tRandom(15) << " ";        // size_t in [0;a]
     cout << gaussianRandom() << endl;       // double following a normal Gaussian law
+    Random rng(42);                         // generator (seed 42)
+    Random rng1=rng.stream(1);              // ... independent stream (e.g. for another thread)
+    cout << rng.doubleRandom() << " " << rng1.gaussianRandom() << endl;   // ...
+    MultiArray<float,2> N(64,48);
+    rng.fillUniform(N,0.f,255.f);           // uniform fill
+    rng.fillGaussian(N,0.f,10.f);           // Gaussian fill
 }
 
 
@@ -429,6 +511,117 @@ void timers() {
     t.reset();          // reset    
     // some code 3
     x=t.lap();          // seconds for code 3
+    uint64_t ns=t.lapNs();  // nanoseconds
+    Profiler::enable();                 // enable profiler (or set IMAGINE_PROFILE)
+    for (int i=0; i<3; i++) {           // ...
+        ScopedTimer st("outer");        // ...
+        ScopedTimer st2("inner");       // ...
+    }                                   // ...
+    Profiler::report(cout);             // report
+    Profiler::writeJson(cout);          // JSON
+    Profiler::enable(false);
+    cout << x << " " << ns << endl;
+}
+
+void parallel() {
+    cout << "Testing parallel functions!"<<endl;
+    Parallel::setThreads(4);                // number of threads (0: number of cores, or set IMAGINE_THREADS)
+    Array<double> a(10000);
+    parallelFor(0,a.size(),[&](size_t i) { a[i]=double(i); });     // parallel loop
+    parallelForRanges(0,a.size(),[&](size_t b, size_t e) {          // parallel loop over ranges
+        for (size_t i=b;i<e;i++)                                    // ...
+            a[i]*=2;                                                // ...
+    });                                                             // ...
+    double s=parallelReduce<double>(0,a.size(),                     // parallel reduction
+        [&](size_t b, size_t e) { double x=0; for (size_t i=b;i<e;i++) x+=a[i]; return x; },   // ...
+        [](double x, double y) { return x+y; },1000);               // ...
+    assert(s==9999.*10000);
+    MultiArray<int,3> V(Coords<3>(5,4,3),16), W(5,4,3);
+    V.parallelForEachRow([](int* p, size_t n, const Coords<3>& c) {    // parallel row traversal
+        for (size_t i=0;i<n;i++)                                        // ...
+            p[i]=int(i)+10*c[1]+100*c[2];                               // ...
+    });                                                                 // ...
+    W.parallelForEachSlab([&](int b, int e) {               // parallel slab traversal
+        for (int z=b;z<e;z++)                               // ...
+            for (int y=0;y<4;y++)                           // ...
+                for (int x=0;x<5;x++)                       // ...
+                    W(x,y,z)=V(x,y,z);                      // ...
+    },1);                                                   // ...
+    assert(W==V && W(4,3,2)==234);
+    bool thrown=false;
+    try {
+        parallelFor(0,100,[](size_t i) { if (i==57) throw std::runtime_error("57"); },1);
+    } catch (const std::runtime_error&) {
+        thrown=true;
+    }
+    assert(thrown);
+    Parallel::setThreads(0);
+}
+
+void cpus() {
+    cout << "Testing CPU dispatch!"<<endl;
+    CpuLevel s=Cpu::supported();            // supported level (CPUID)
+    cout << Cpu::name(Cpu::level()) << endl;    // current level (lowered by IMAGINE_CPU)
+    Cpu::setLevel(CPU_BASELINE);            // force a level (e.g. for testing)
+    Array<float> a(1000);
+    for (size_t i=0;i<a.size();i++)
+        a[i]=float(i%17)/3;
+    const pair<float,float> r=range(a);
+    Cpu::setLevel(s);
+    assert(range(a)==r && r.second==16.f/3);
+}
+
+void ffts() {
+    cout << "Testing FFT functions!"<<endl;
+    assert(fftSize(1001)==1024 && fftSize(97)==100);    // size for FFT (prime factors 2, 3, 5)
+    const int n=12;
+    vector<complex<double> > x(n), y(n), z(n);
+    for (int i=0;i<n;i++)
+        x[i]=complex<double>(i%5,i%3);
+    shared_ptr<const FFTPlan<double> > P=FFTPlan<double>::get(n);  // complex FFT plan (cached)
+    P->transform(&x[0],&y[0]);                                      // ... forward
+    P->transform(&y[0],&z[0],true);                                 // ... inverse (not divided by n)
+    const double pi=3.14159265358979323846;
+    complex<double> y1=0;
+    for (int i=0;i<n;i++) {
+        y1+=x[i]*polar(1.,-2*pi*i/n);
+        assert(abs(z[i]-x[i]*double(n))<1e-9);
+    }
+    assert(abs(y[1]-y1)<1e-9);
+    vector<float> r(n), r2(n);
+    vector<complex<float> > R(n/2+1), w(2*n);
+    for (int i=0;i<n;i++)
+        r[i]=float(x[i].real());
+    shared_ptr<const RealFFTPlan<float> > Q=RealFFTPlan<float>::get(n); // real FFT plan (cached)
+    Q->forward(&r[0],&R[0],&w[0]);                                      // ... n/2+1 values
+    Q->inverse(&R[0],&r2[0],&w[0]);                                     // ... (not divided by n)
+    assert(abs(R[1]-complex<float>(y[1]+conj(y[n-1]))/2.f)<1e-4f && abs(r2[7]-n*r[7])<1e-4f);
+    MultiArray<double,2> a(30,20), b(5,4);
+    for (size_t i=0;i<a.totalSize();i++)
+        a[i]=double(i%7);
+    b.fill(1.);
+    MultiArray<complex<double>,2> A=fft(a); // FFT of a real array (a.size(0)/2+1 values along x)
+    MultiArray<double,2> a2=inverseFFT(A,a.size(0));    // inverse FFT
+    MultiArray<double,2> c=fftConvolve(a,b);            // convolution by FFT (full)
+    assert(A.size(0)==16 && abs(A(0,0)-1795.)<1e-9 && abs(a2(13,11)-a(13,11))<1e-12);
+    double c1=0;
+    for (int j=0;j<4;j++)
+        for (int i=0;i<5;i++)
+            c1+=a(10-i,7-j);
+    assert(c.size(0)==34 && c.size(1)==23 && abs(c(10,7)-c1)<1e-9);
+    MultiArray<double,3> p(Coords<3>(9,5,4),64);     // padded rows
+    for (CoordsIterator<3> it=p.coordsBegin();it!=p.coordsEnd();++it)
+        p(*it)=double(((*it)[0]+2*(*it)[1]+3*(*it)[2])%7);
+    MultiArray<complex<double>,3> F=fft(p), F2=fft(p.clone()), Fp(F.sizes(),64), G=F.clone();
+    for (CoordsIterator<3> it=F.coordsBegin();it!=F.coordsEnd();++it)
+        Fp(*it)=F(*it);
+    fftLines(G,true);
+    fftLines(Fp,true);
+    MultiArray<double,3> p2=inverseFFT(F,p.size(0));
+    for (CoordsIterator<3> it=F.coordsBegin();it!=F.coordsEnd();++it)
+        assert(abs(F(*it)-F2(*it))<1e-9 && abs(Fp(*it)-G(*it))<1e-9);
+    for (CoordsIterator<3> it=p.coordsBegin();it!=p.coordsEnd();++it)
+        assert(abs(p2(*it)-p(*it))<1e-12);
 }
 
 void io() {
@@ -438,6 +631,45 @@ void io() {
     loadText(v,"tmp.txt");              // load object (ASCII)
     saveBinary(v,"tmp.bin");            // save object (binary)
     loadBinary(v,"tmp.bin");            // load object (binary)
+    MultiArray<double,2> T(3,2), T2;
+    T.fill(0.1);
+    saveText(T,"tmp.txt");              // save array (ASCII, exact)
+    loadText(T2,"tmp.txt");             // load array (ASCII)
+    assert(T2==T);
+    MultiArray<Color,2> C(3,2), C2;
+    for (size_t i=0;i<C.totalSize();i++)
+        C[i]=Color(byte(10*i),byte(255-i),byte(i%2 ? 7 : 0));
+    saveText(C,"tmp.txt");              // colors written as integers (as operator<<)
+    loadText(C2,"tmp.txt");
+    assert(C2==C);
+    MultiArray<float,2> Wb(4,3);
+    Wb.fill(2.f);
+    saveBinary(Wb,"tmp.bin");
+    BinaryHeader h;
+    {
+        fstream f("tmp.bin",ios::in|ios::out|ios::binary);
+        f.read((char*)&h,sizeof(h));
+        h.strides[1]=~0ULL/3+1;         // strides*sizes wraps around to 2...
+        h.dataSize=2*sizeof(float);     // ... matched by the data size
+        h.seal();
+        f.seekp(0);
+        f.write((const char*)&h,sizeof(h));
+    }
+    assert(!loadBinary(Wb,"tmp.bin"));  // rejected header
+    MultiArray<float,3> V(4,3,2);
+    V.fill(1.f);
+    saveBinary(V,"tmp.bin",true);       // save nD array (binary, with checksum)
+    loadBinary(V,"tmp.bin",true);       // mapped loading (no copy)
+    uint32_t crc=crc32c(V.data(),V.totalSize()*sizeof(float));  // CRC32C
+    cout << crc << endl;
+    MultiArrayWriter<float,3> wr("tmp2.bin",Coords<3>(4,3,2)); // streaming write
+    for (int z=0; z<2; z++)                                     // ...
+        wr.append(V.getSubArrayView(Coords<3>(0,0,z),Coords<3>(4,3,1)));
+    wr.close();                                                 // ...
+    saveBinary(V,"tmp2.bin",false,true);    // save nD array (binary, compressed)
+    MultiArrayReader<float,3> rd("tmp2.bin");   // partial read
+    MultiArray<float,3> S;                      // ...
+    rd.read(S,1,1);                             // ... (slice z=1)
 }
 
 int main() {
@@ -449,8 +681,13 @@ int main() {
     arrays();       // Arrays
     coords();       // Coordinates (used by arrays) 
     multiArrays();  // nD Arrays
+    pointSets();    // Sets of points
+    moves();        // Moving arrays
     rands();        // Random numbers generation
     timers();       // Timers
+    parallel();     // Parallel loops
+    cpus();         // CPU dispatch
+    ffts();         // Fast Fourier transforms
     io();           // Input/output
     waitKey();        // Wait before terminating program
     return 0;
@@ -13,6 +13,7 @@
 #include <cstring>
 #include <iostream>
 #include <fstream>
+#include <vector>
 
 #include <Imagine/Common.h>
 #include <Imagine/Graphics.h>
@@ -25,6 +26,8 @@
 #include "Images/Image.h"
 #include "Images/IO.h"
 #include "Images/Algos.h"
+#include "Images/Colors.h"
+#include "Images/Convolution.h"
 #include "Images/Schemes.h"
 
 #endif
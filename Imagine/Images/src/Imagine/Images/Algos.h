@@ -22,15 +22,15 @@ namespace Imagine {
     template <typename T, int dim>
     Image<T,dim> scaleUp(const Image<T,dim>&I,int fact) 
     {
+        ScopedTimer timer("Images::scaleUp");
         Image<T,dim> I1(I.sizes() * fact);
-        // coordinates aware iterator
-        for (CoordsIterator<dim> r = I.coordsBegin() ; r != I.coordsEnd() ; ++r) {
-            Coords<dim> o=*r;
-            T b=I(o);
-            for (CoordsIterator<dim> zr(o * fact, o * fact + Coords<dim>(fact-1));zr!=I.coordsEnd();++zr){
-                I1(*zr)=b;
-            }
-        }
+        // row traversal: each row of I1 repeats fact times each pixel of a row of I
+        I1.forEachRow([&](T* r, size_t, const Coords<dim>& c) {
+            const T* a=I.data()+I.offset(c/fact);
+            for (int x=0;x<I.width();x++)
+                for (int k=0;k<fact;k++)
+                    *(r++)=a[x];
+        });
         return I1;
     }
     /// Down scaling: fast naive version.
@@ -44,10 +44,14 @@ namespace Imagine {
     template <typename T, int dim>
     Image<T,dim> scaleDown(const Image<T,dim>&I,int fact) 
     {
+        ScopedTimer timer("Images::scaleDown");
         Image<T,dim> I1(I.sizes()/fact);
-        // coordinates aware iterator
-        for (CoordsIterator<dim> r = I1.coordsBegin() ; r != I1.coordsEnd() ; ++r)
-            I1(*r)=I((*r)*fact);
+        // row traversal
+        I1.forEachRow([&](T* r, size_t n, const Coords<dim>& c) {
+            const T* a=I.data()+I.offset(c*fact);
+            for (size_t x=0;x<n;x++)
+                r[x]=a[x*fact];
+        });
         return I1;
     }
     /// Reduce image (integer factor).
@@ -61,17 +65,26 @@ namespace Imagine {
     template <typename T, int dim>
     Image<T,dim> reduce(const Image<T,dim>&I, int fact)  
     {
+        ScopedTimer timer("Images::reduce");
         typedef typename PixelTraits<T>::template CastPixel<double>::value_type doubleT;
         Coords<dim> d=I.sizes()/fact;
         double nb=pow(double(fact),dim);
         Image<T,dim> Ir(d);
-        for (CoordsIterator<dim> r = Ir.coordsBegin() ; r != Ir.coordsEnd() ; ++r) {
-            doubleT p(0.);
-            for (CoordsIterator<dim> r2((*r)*fact,((*r)*fact+Coords<dim>(fact-1))); r2!=CoordsIterator<dim>(); ++r2) {
-                p+=doubleT(I(*r2));
+        std::vector<doubleT> p(d[0]);
+        Ir.forEachRow([&](T* r, size_t n, const Coords<dim>& c) {
+            std::fill(p.begin(),p.end(),doubleT(0.));
+            // sums the fact^(dim-1) rows of I covered by this row of Ir
+            Coords<dim> beg=c*fact, end=c*fact+Coords<dim>(fact-1);
+            end[0]=0;
+            for (CoordsIterator<dim> r2(beg,end); r2!=CoordsIterator<dim>(); ++r2) {
+                const T* a=I.data()+I.offset(*r2);
+                for (size_t x=0;x<n;x++)
+                    for (int k=0;k<fact;k++)
+                        p[x]+=doubleT(a[x*fact+k]);
             }
-            Ir(*r)=T(p/nb);
-        }
+            for (size_t x=0;x<n;x++)
+                r[x]=T(p[x]/nb);
+        });
         return Ir;
     }
     /// Reduce image (given dimensions).
@@ -87,6 +100,7 @@ namespace Imagine {
     template <typename T, int dim>
     Image<T,dim> reduce(const Image<T,dim>&I,Coords<dim> nd,bool keepRatio=false)  
     {
+        ScopedTimer timer("Images::reduce");
         typedef typename PixelTraits<T>::template CastPixel<double>::value_type doubleT;
         Image<doubleT,dim> oI(I);
         Coords<dim> od=I.sizes();
@@ -99,10 +113,15 @@ namespace Imagine {
         }
         inPlaceBlur(oI,1.5*(sqrt(f)-.99)); // Todo: better filtering
         Image<T,dim> nI(nd);
-        for (CoordsIterator<dim> r = nI.coordsBegin() ; r != nI.coordsEnd() ; ++r) {
-            FVector<double,dim> x=mult(FVector<double,dim>(*r),f);
-            nI(*r)=T(oI.interpolate(x));
-        }
+        nI.forEachRow([&](T* r, size_t n, const Coords<dim>& c) {
+            cpuDispatch([&]() {
+                FVector<double,dim> x=mult(FVector<double,dim>(c),f);
+                for (size_t i=0;i<n;i++) {
+                    x[0]=i*f[0];
+                    r[i]=T(oI.interpolate(x));
+                }
+            });
+        });
         return nI;
     }
     /// Reduce image (given dimensions), 2D alias.
@@ -136,6 +155,7 @@ namespace Imagine {
     template <typename T,int dim>
     Image<T,dim> enlarge(const Image<T,dim>&I,Coords<dim> nd,bool keepRatio=false)  
     {
+        ScopedTimer timer("Images::enlarge");
         typedef typename PixelTraits<T>::template CastPixel<double> doubleT;
         Coords<dim> od=I.sizes();
         FVector<double,dim> f=div(FVector<double,dim>(od),FVector<double,dim>(nd));
@@ -146,10 +166,15 @@ namespace Imagine {
             nd=Coords<dim>(FVector<double,dim>(od)/mM.second);
         }
         Image<T,dim> nI(nd);
-        for (CoordsIterator<dim> r = nI.coordsBegin() ; r != nI.coordsEnd() ; ++r) {
-            FVector<double,dim> x=mult(FVector<double,dim>(*r),f);
-            nI(*r)=T(I.interpolate(x));
-        }
+        nI.forEachRow([&](T* r, size_t n, const Coords<dim>& c) {
+            cpuDispatch([&]() {
+                FVector<double,dim> x=mult(FVector<double,dim>(c),f);
+                for (size_t i=0;i<n;i++) {
+                    x[0]=i*f[0];
+                    r[i]=T(I.interpolate(x));
+                }
+            });
+        });
         return nI;
     }
     /// Enlarge image (given dimensions), 2D alias.
@@ -171,11 +196,103 @@ namespace Imagine {
         return enlarge(I,nd);
     }
 
+    // ===============================================
+    // Line filters
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    // Bytes of adjacent lines filtered together along dimensions other than x (see forEachLine())
+    const size_t LINE_BAND=256;
+
+    // Real value to scalar type T: plain conversion, or rounded and saturated for integer types. Bounds are compared
+    // with min() and max()+1, both powers of 2 exactly represented in S (max() itself being rounded for 64 bit types).
+    template <typename T, typename S> inline T realToScalar(S x, std::false_type) { return T(x); }
+    template <typename T, typename S> inline T realToScalar(S x, std::true_type) {
+        const S m=S(std::numeric_limits<T>::min()), M=S(std::numeric_limits<T>::max()/2+1)*S(2);
+        const S r=x+std::copysign(S(.5),x);
+        if (r<=m)
+            return std::numeric_limits<T>::min();
+        if (r>=M)
+            return std::numeric_limits<T>::max();
+        return T(r);
+    }
+    // Pixels of type T as computed by filters: type R with real channels (T itself unless channels are integers), and
+    // back
+    template <typename T> struct RealPixel {
+        typedef typename PixelTraits<T>::scalar_type scalar;
+        typedef typename PixelTraits<T>::real_type real;
+        typedef typename PixelTraits<T>::template CastPixel<real>::value_type R;
+        static R toReal(const T& x) { return R(x); }
+        static T fromReal(const R& x) { return fromReal(x,std::is_same<T,R>(),std::is_arithmetic<T>()); }
+        static T fromReal(const R& x, std::true_type, ...) { return x; }
+        static T fromReal(const R& x, std::false_type, std::true_type) {
+            return realToScalar<T>(x,std::is_integral<T>());
+        }
+        static T fromReal(const R& x, std::false_type, std::false_type) {
+            T y;
+            for (size_t c=0; c<sizeof(T)/sizeof(scalar); c++)
+                y[c]=realToScalar<scalar>(x[c],std::is_integral<scalar>());
+            return y;
+        }
+        // fromReal() of w<=n values. Integers of at most 16 bits are rounded and saturated as ints in a local array
+        // first, so that compilers vectorize both steps (filtered values of such types fit in an int).
+        template <size_t n> static void fromReal(const R* x, size_t w, T* y) {
+            fromReal<n>(x,w,y,std::integral_constant<bool,std::is_integral<T>::value && sizeof(T)<=2>());
+        }
+        template <size_t n> static void fromReal(const R* x, size_t w, T* y, std::false_type) {
+            for (size_t k=0; k<w; k++)
+                y[k]=fromReal(x[k]);
+        }
+        template <size_t n> static void fromReal(const R* x, size_t w, T* y, std::true_type) {
+            const int m=std::numeric_limits<T>::min(), M=std::numeric_limits<T>::max();
+            int q[n];
+            for (size_t k=0; k<w; k++) {
+                const int i=int(x[k]+std::copysign(real(.5),x[k]));
+                q[k] = i<m ? m : (i>M ? M : i);
+            }
+            for (size_t k=0; k<w; k++)
+                y[k]=T(q[k]);
+        }
+    };
+
+    // Calls f(c,w,Y) for the lines along dimension d of an image of given sizes, c being the coordinates of the first
+    // element of a line (c[d]=0). Lines along x are taken one at a time (w=1). Along other dimensions, elements of a
+    // line are far apart in memory: w<=lanes adjacent lines (a band) are taken together, so that f reads contiguous
+    // runs of w elements. Lines are shared among threads (see Parallel) by ranges of coordinates along the last
+    // dimension p other than d (counted in bands for x, only used for 2D images along y: along z, y gives many more
+    // ranges), each range having its own buffer Y of n values, and f is compiled for each CPU level (see cpuDispatch()).
+    template <typename R, int dim, typename F>
+    void forEachLine(const Coords<dim>& sizes, int d, size_t lanes, size_t n, F f) {
+        const size_t W = d==0 ? 1 : lanes;
+        Coords<dim> sz = sizes;
+        sz[0] = int((size_t(sz[0])+W-1)/W);
+        const int p = d!=dim-1 ? dim-1 : (dim>=3 ? dim-2 : 0);
+        parallelForRanges(0, p==d ? 1 : size_t(sz[p]), [&](size_t b, size_t e) {
+            std::vector<R> buffer(n);
+            Coords<dim> beg(0), end = sz - Coords<dim>(1);
+            if (p!=d) {
+                beg[p]=int(b);
+                end[p]=int(e)-1;
+            }
+            end[d]=0;
+            cpuDispatch([&]() {
+                for (CoordsIterator<dim> c(beg,end); c != CoordsIterator<dim>(); ++c) {
+                    Coords<dim> x = *c;
+                    x[0] *= int(W);
+                    f(x,std::min(W,size_t(sizes[0]-x[0])),&buffer[0]);
+                }
+            });
+        });
+    }
+#endif
+
     // ===============================================
     // Deriche 
 
     /// In place Deriche filter.
-    /// In place Deriche filter 
+    /// In place Deriche filter. Lines along dimension d are filtered in parallel (see Parallel), and by bands of
+    /// adjacent ones for d>0, so that filtering along y or z reads memory contiguously (vectorized, see Cpu).
+    /// Images of integers (e.g. byte) are filtered in floating point, values being rounded and saturated when
+    /// written back.
     /// \param I input/output image.
     /// \param sigma smoothing parameter 
     /// \param order order of derivation (between 0 and 2)
@@ -186,12 +303,13 @@ namespace Imagine {
     /// \skipline in place Deriche
     /// \until ...
     template <typename T,int dim>
-    void inPlaceDeriche(Image<T,dim>&I,typename PixelTraits<T>::scalar_type sigma, int order, int d, bool neumann = true) {
+    void inPlaceDeriche(Image<T,dim>&I,typename PixelTraits<T>::real_type sigma, int order, int d, bool neumann = true) {
+        ScopedTimer timer("Images::deriche");
         // Checks parameter values
         assert(sigma>0 && order>=0 && order<3 && d>=0 && d<dim);
 
         // Computes coefficients of the recursive filter
-        const typename PixelTraits<T>::scalar_type
+        const typename PixelTraits<T>::real_type
             alpha = 1.695f/sigma,
             ea = std::exp(alpha),
             ema = std::exp(-alpha),
@@ -199,7 +317,7 @@ namespace Imagine {
             b1 = 2*ema,
             b2 = -em2a;
 
-        typename PixelTraits<T>::scalar_type ek,ekn,parity,a1,a2,a3,a4,g0,sumg1,sumg0;
+        typename PixelTraits<T>::real_type ek,ekn,parity,a1,a2,a3,a4,g0,sumg1,sumg0;
 
         switch(order) {
 
@@ -255,46 +373,110 @@ namespace Imagine {
                     break;
         }
 
-        // filter init
-        T *Y = new T[I.size(d)];
         const size_t offset = I.stride(d);
         const size_t nb = I.size(d);
 
-        // Iterates on dimensions other than d
-        Coords<dim> beg(0), end = I.sizes() - Coords<dim>(1);
-        end[d]=0;
-        for (CoordsIterator<dim> p(beg,end); p != CoordsIterator<dim>(); ++p) {
-            T *ima = &(I(*p));
-            T I2 = *ima; ima += offset;
-            T I1 = *ima; ima += offset;
-            T Y2 = *(Y++) = sumg0*I2;
-            T Y1 = *(Y++) = g0*I1 + sumg1*I2;
+        // Filters the line starting at ima, Y being a buffer of nb values
+        typedef RealPixel<T> P;
+        typedef typename P::R R;
+        auto line = [&](T* ima, R* Y) {
+            R I2 = P::toReal(*ima); ima += offset;
+            R I1 = P::toReal(*ima); ima += offset;
+            R Y2 = *(Y++) = sumg0*I2;
+            R Y1 = *(Y++) = g0*I1 + sumg1*I2;
+            I2 = I1;
             for (size_t i=2; i<nb; i++) {
-                I1 = *ima; ima+=offset;
-                T Y0 = *(Y++) = a1*I1 + a2*I2 + b1*Y1 + b2*Y2;
+                I1 = P::toReal(*ima); ima+=offset;
+                R Y0 = *(Y++) = a1*I1 + a2*I2 + b1*Y1 + b2*Y2;
                 I2=I1; Y2=Y1; Y1=Y0;
             }
             ima -= offset;
-            I2 = *ima;
+            I2 = P::toReal(*ima);
             Y2 = Y1 = (parity*sumg1)*I2;
-            *ima = *(--Y)+Y2;
+            *ima = P::fromReal(*(--Y)+Y2);
             ima-=offset;
-            I1 = *ima;
-            *ima = *(--Y)+Y1;
+            I1 = P::toReal(*ima);
+            *ima = P::fromReal(*(--Y)+Y1);
             for (size_t i=nb-3; ; i--) {
-                T Y0 = a3*I1+a4*I2+b1*Y1+b2*Y2;
+                R Y0 = a3*I1+a4*I2+b1*Y1+b2*Y2;
                 ima-=offset;
                 I2=I1;
-                I1=*ima;
-                *ima=*(--Y)+Y0;
+                I1=P::toReal(*ima);
+                *ima=P::fromReal(*(--Y)+Y0);
                 Y2=Y1;
                 Y1=Y0;
                 if (i==0)
                     break;
-            } 
-        }
-        delete [] Y;
+            }
+        };
+        // Along dimensions other than x, elements of a line are far apart in memory: w<=L adjacent lines (a band) are
+        // filtered together, each step reading a contiguous run of w elements and updating the states of the w lines,
+        // kept in small arrays (I1, Y1 at distance 1, I2, Y2 at distance 2). Operations are those of line(), vectorized
+        // across lines. Y is a buffer of nb*L values. Steps compute into local array X before storing it, so that
+        // compilers know that stores do not modify operands.
+        static const size_t L = sizeof(R)>=LINE_BAND ? 1 : LINE_BAND/sizeof(R);
+        auto band = [&](T* ima, size_t w, R* Y) {
+            const typename PixelTraits<T>::real_type c1=a1, c2=a2, c3=a3, c4=a4, d1=b1, d2=b2,
+                h0=g0, s0=sumg0, s1=sumg1, e1=parity*sumg1;
+            R X[L], I1[L], I2[L], Y1[L], Y2[L];
+            for (size_t k=0; k<w; k++) {
+                I2[k] = P::toReal(ima[k]);
+                I1[k] = P::toReal(ima[offset+k]);
+                Y2[k] = s0*I2[k];
+                Y1[k] = h0*I1[k] + s1*I2[k];
+            }
+            for (size_t k=0; k<w; k++) {
+                Y[k] = Y2[k];
+                Y[L+k] = Y1[k];
+            }
+            for (size_t i=2; i<nb; i++) {
+                const T *r = ima+i*offset;
+                for (size_t k=0; k<w; k++) {
+                    const R x = P::toReal(r[k]);
+                    X[k] = c1*x + c2*I1[k] + d1*Y1[k] + d2*Y2[k];
+                    I1[k] = x;
+                    Y2[k] = Y1[k];
+                    Y1[k] = X[k];
+                }
+                R *y = Y+i*L;
+                for (size_t k=0; k<w; k++)
+                    y[k] = X[k];
+            }
+            T *r = ima+(nb-1)*offset, *r1 = r-offset;
+            const R *y = Y+(nb-1)*L, *y1 = y-L;
+            for (size_t k=0; k<w; k++) {
+                I2[k] = P::toReal(r[k]);
+                I1[k] = P::toReal(r1[k]);
+                Y2[k] = Y1[k] = e1*I2[k];
+                X[k] = y[k]+Y2[k];
+            }
+            P::template fromReal<L>(X,w,r);
+            for (size_t k=0; k<w; k++)
+                X[k] = y1[k]+Y1[k];
+            P::template fromReal<L>(X,w,r1);
+            for (size_t i=nb-2; i-->0; ) {
+                r = ima+i*offset;
+                y = Y+i*L;
+                for (size_t k=0; k<w; k++) {
+                    const R Y0 = c3*I1[k]+c4*I2[k]+d1*Y1[k]+d2*Y2[k];
+                    I2[k] = I1[k];
+                    I1[k] = P::toReal(r[k]);
+                    Y2[k] = Y1[k];
+                    Y1[k] = Y0;
+                    X[k] = y[k]+Y0;
+                }
+                P::template fromReal<L>(X,w,r);
+            }
+        };
 
+        forEachLine<R>(I.sizes(), d, L, d==0 ? nb : nb*L, [&](const Coords<dim>& c, size_t w, R* Y) {
+            if (d==0)
+                line(&I(c),Y);
+            else if (w==L)
+                band(&I(c),L,Y);    // constant width: vectorized loops
+            else
+                band(&I(c),w,Y);
+        });
     }
     /// Deriche filter.
     /// Deriche filter 
@@ -309,13 +491,13 @@ namespace Imagine {
     /// \skipline Deriche
     /// \until ...
     template <typename T,int dim>
-    Image<T,dim> deriche(const Image<T,dim>&I,typename PixelTraits<T>::scalar_type sigma, int order, int d, bool neumann = true) {
+    Image<T,dim> deriche(const Image<T,dim>&I,typename PixelTraits<T>::real_type sigma, int order, int d, bool neumann = true) {
         Image<T,dim> J=I.clone();
         inPlaceDeriche(J,sigma,order,d,neumann);
         return J;
     }
     /// In Place Blur (anisotropic).
-    /// In place anisotropic blur using Deriche 
+    /// In place anisotropic blur using Deriche, one pass per dimension, each one in parallel (see inPlaceDeriche())
     /// \param I input/output image.
     /// \param sigmas smoothing parameters (sigmas[i] for dimension i) 
     /// \param neumann Neumann border condition (default=true)
@@ -323,7 +505,8 @@ namespace Imagine {
     /// \dontinclude Images/test/test.cpp \skip algos()
     /// \skipline in place anisotropic blur
     template <typename T,int dim>
-    void inPlaceBlur(Image<T,dim>&I,const FVector<typename PixelTraits<T>::scalar_type,dim>& sigmas, bool neumann = true) {
+    void inPlaceBlur(Image<T,dim>&I,const FVector<typename PixelTraits<T>::real_type,dim>& sigmas, bool neumann = true) {
+        ScopedTimer timer("Images::blur");
         for (int i=0;i<dim;i++) {
             inPlaceDeriche(I,sigmas[i], 0, i, neumann);
         }
@@ -337,8 +520,8 @@ namespace Imagine {
     /// \dontinclude Images/test/test.cpp \skip algos()
     /// \skipline in place blur
     template <typename T,int dim>
-    void inPlaceBlur(Image<T,dim>&I,typename PixelTraits<T>::scalar_type sigma, bool neumann = true) {
-        inPlaceBlur(I,FVector<typename PixelTraits<T>::scalar_type,dim>(sigma),neumann);
+    void inPlaceBlur(Image<T,dim>&I,typename PixelTraits<T>::real_type sigma, bool neumann = true) {
+        inPlaceBlur(I,FVector<typename PixelTraits<T>::real_type,dim>(sigma),neumann);
     }
     /// Blur.
     /// Blur using Deriche 
@@ -350,7 +533,7 @@ namespace Imagine {
     /// \dontinclude Images/test/test.cpp \skip algos()
     /// \skipline blur
     template <typename T,int dim>
-    Image<T,dim> blur(const Image<T,dim>&I,typename PixelTraits<T>::scalar_type sigma, bool neumann = true) {
+    Image<T,dim> blur(const Image<T,dim>&I,typename PixelTraits<T>::real_type sigma, bool neumann = true) {
         Image<T,dim> J=I.clone();
         inPlaceBlur(J,sigma,neumann);
         return J;
@@ -365,11 +548,74 @@ namespace Imagine {
     /// \dontinclude Images/test/test.cpp \skip algos()
     /// \skipline anisotropic blur
     template <typename T,int dim>
-    Image<T,dim> blur(const Image<T,dim>&I,const FVector<typename PixelTraits<T>::scalar_type,dim>& sigmas, bool neumann = true) {
+    Image<T,dim> blur(const Image<T,dim>&I,const FVector<typename PixelTraits<T>::real_type,dim>& sigmas, bool neumann = true) {
         Image<T,dim> J=I.clone();
         inPlaceBlur(J,sigmas,neumann);
         return J;
     }
 
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    // Image expressions (see ImageExpr), evaluated first
+    template <typename T, int dim, typename E> inline Image<T,dim> scaleUp(const ImageExpr<T,dim,E>& I, int fact) {
+        return scaleUp(I.eval(),fact);
+    }
+    template <typename T, int dim, typename E> inline Image<T,dim> scaleDown(const ImageExpr<T,dim,E>& I, int fact) {
+        return scaleDown(I.eval(),fact);
+    }
+    template <typename T, int dim, typename E> inline Image<T,dim> reduce(const ImageExpr<T,dim,E>& I, int fact) {
+        return reduce(I.eval(),fact);
+    }
+    template <typename T, int dim, typename E>
+    inline Image<T,dim> reduce(const ImageExpr<T,dim,E>& I, Coords<dim> nd, bool keepRatio=false) {
+        return reduce(I.eval(),nd,keepRatio);
+    }
+    template <typename T, int dim, typename E> inline Image<T,dim> reduce(const ImageExpr<T,dim,E>& I, double fact) {
+        return reduce(I.eval(),fact);
+    }
+    template <typename T, typename E>
+    inline Image<T,2> reduce(const ImageExpr<T,2,E>& I, int w, int h, bool keepRatio=false) {
+        return reduce(I.eval(),w,h,keepRatio);
+    }
+    template <typename T, typename E>
+    inline Image<T,3> reduce(const ImageExpr<T,3,E>& I, int w, int h, int d, bool keepRatio=false) {
+        return reduce(I.eval(),w,h,d,keepRatio);
+    }
+    template <typename T, int dim, typename E>
+    inline Image<T,dim> enlarge(const ImageExpr<T,dim,E>& I, Coords<dim> nd, bool keepRatio=false) {
+        return enlarge(I.eval(),nd,keepRatio);
+    }
+    template <typename T, int dim, typename E> inline Image<T,dim> enlarge(const ImageExpr<T,dim,E>& I, double fact) {
+        return enlarge(I.eval(),fact);
+    }
+    template <typename T, typename E>
+    inline Image<T,2> enlarge(const ImageExpr<T,2,E>& I, int w, int h, bool keepRatio=false) {
+        return enlarge(I.eval(),w,h,keepRatio);
+    }
+    template <typename T, typename E>
+    inline Image<T,3> enlarge(const ImageExpr<T,3,E>& I, int w, int h, int d, bool keepRatio=false) {
+        return enlarge(I.eval(),w,h,d,keepRatio);
+    }
+    template <typename T, int dim, typename E>
+    inline Image<T,dim> deriche(const ImageExpr<T,dim,E>& I, typename PixelTraits<T>::real_type sigma, int order, int d,
+                                bool neumann = true) {
+        Image<T,dim> J=I.eval();
+        inPlaceDeriche(J,sigma,order,d,neumann);
+        return J;
+    }
+    template <typename T, int dim, typename E>
+    inline Image<T,dim> blur(const ImageExpr<T,dim,E>& I, typename PixelTraits<T>::real_type sigma, bool neumann = true) {
+        Image<T,dim> J=I.eval();
+        inPlaceBlur(J,sigma,neumann);
+        return J;
+    }
+    template <typename T, int dim, typename E>
+    inline Image<T,dim> blur(const ImageExpr<T,dim,E>& I, const FVector<typename PixelTraits<T>::real_type,dim>& sigmas,
+                             bool neumann = true) {
+        Image<T,dim> J=I.eval();
+        inPlaceBlur(J,sigmas,neumann);
+        return J;
+    }
+#endif
+
     ///@}
 }
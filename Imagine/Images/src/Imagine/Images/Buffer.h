@@ -10,6 +10,8 @@
 
 namespace Imagine {
     template <class TI, class TO, int dim> bool readBuffer(Image<TO,dim> &I, std::istream &in) {
+        if (!I.isContiguous())
+            I = Image<TO,dim>(I.sizes());
         size_t size = I.totalSize();
         TI *buffer = new TI[size];
         in.read((char *)buffer,size*sizeof(TI));
@@ -19,6 +21,8 @@ namespace Imagine {
     }
 
     template <class TO, class TI, int dim> bool writeBuffer(const Image<TI,dim> &I, std::ostream &out) {
+        if (!I.isContiguous())
+            return writeBuffer<TO,TI,dim>(I.clone(),out);
         size_t size = I.totalSize();
         TO *buffer = new TO[size];
         for (size_t i=0;i<size;i++) buffer[i] = TO( I[i] );
@@ -0,0 +1,435 @@
+// ===========================================================================
+// Imagine++ Libraries
+// Copyright (C) Imagine
+// For detailed information: http://imagine.enpc.fr/software
+// ===========================================================================
+
+namespace Imagine {
+    /// \addtogroup Images
+    /// @{
+
+    /// Color spaces.
+    /// Color spaces of convertColors(). Values are given for float planes, byte planes holding them rounded and
+    /// saturated as indicated.
+    enum ColorSpace {
+        COLOR_GREY,     ///< Grey level 0.3*R+0.59*G+0.11*B (as RGB::operator T()), in [0,255]
+        COLOR_YUV,      ///< Y in [0,255], U=0.492*(B-Y) and V=0.877*(R-Y) (as RGB2YUV()). Bytes: Y, U+128, V+128
+        COLOR_YCBCR,    ///< Y, Cb and Cr in [0,255] (full range ITU-R BT.601, as JPEG)
+        COLOR_HSV,      ///< Hue in [0,360) degrees, saturation in [0,1], value in [0,255]. Bytes: H*256/360, S*255, V
+        COLOR_LAB       ///< CIE L*a*b* of sRGB values (D65): L in [0,100], a and b about in [-128,127]. Bytes: L*255/100, a+128, b+128
+    };
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    // Pixels are converted by blocks of COLOR_BLOCK, in arrays of constant size so that loops vectorize (see
+    // cpuDispatch()). Byte to byte conversions to grey, YUV and YCbCr use 15 bits fixed point arithmetic.
+    const int COLOR_BLOCK=16;
+
+    // Scalar type and number of channels of color pixels
+    template <typename C> struct ColorPixel;
+    template <typename T> struct ColorPixel< RGB<T> > {
+        typedef T scalar;
+        static const int channels=3;
+    };
+    template <typename T> struct ColorPixel< RGBA<T> > {
+        typedef T scalar;
+        static const int channels=4;
+    };
+    // Opaque alpha value (channels are in [0,255] whatever their type, as in RGBA(r,g,b))
+    template <typename T> inline T colorOpaque() { return T(255); }
+
+    // Fixed point coefficient (15 bits fraction)
+    inline short colorQ15(double c) { return short(std::floor(c*32768+.5)); }
+
+    // sRGB component in [0,255] to linear in [0,1], and back to [0,255]
+    inline float colorLinear(float x) {
+        x/=255;
+        return x<=0.04045f ? x/12.92f : std::pow((x+0.055f)/1.055f,2.4f);
+    }
+    inline float colorGamma(float x) {
+        return 255*(x<=0.0031308f ? 12.92f*x : 1.055f*std::pow(x,1/2.4f)-0.055f);
+    }
+    // Tables: linear values of bytes, and linear values halfway between consecutive bytes (for rounding back)
+    struct ColorTables {
+        float linear[256], halfway[256];
+        ColorTables() {
+            for (int i=0;i<256;i++) {
+                linear[i]=colorLinear(float(i));
+                halfway[i] = i<255 ? float(colorLinear(i+.5f)) : std::numeric_limits<float>::max();
+            }
+        }
+        static const ColorTables& instance() {
+            static const ColorTables t;
+            return t;
+        }
+        // Byte whose linear value is closest to x (in gamma space): number of halfway values below x
+        byte toByte(float x) const {
+            int i=0;
+            for (int s=128;s>0;s/=2)
+                i += x>=halfway[i+s-1] ? s : 0;
+            return byte(i);
+        }
+    };
+    // Cube root: bit level approximation refined by two Halley iterations (float accurate)
+    inline float colorCbrt(float x) {
+        uint32_t u;
+        std::memcpy(&u,&x,4);
+        u=u/3+709921077u;
+        float y;
+        std::memcpy(&y,&u,4);
+        for (int k=0;k<2;k++) {
+            const float y3=y*y*y;
+            y*=(y3+2*x)/(2*y3+x);
+        }
+        return y;
+    }
+    inline float colorLabF(float t) { return t>0.008856f ? colorCbrt(t) : 7.787f*t+16.f/116; }
+    inline float colorLabInvF(float t) { return t>6.f/29 ? t*t*t : (t-4.f/29)*(3*(6.f/29)*(6.f/29)); }
+
+    // Byte storage of channel k of a space: value*scale+offset
+    inline void colorScale(ColorSpace s, int k, float& scale, float& offset) {
+        scale=1;
+        offset=0;
+        if ((s==COLOR_YUV || s==COLOR_LAB) && k>0)
+            offset=128;
+        if (s==COLOR_HSV && k==0)
+            scale=256.f/360;
+        if (s==COLOR_HSV && k==1)
+            scale=255;
+        if (s==COLOR_LAB && k==0)
+            scale=2.55f;
+    }
+
+    // Conversions of a row of n pixels
+    template <typename C, typename S> struct ColorRow {
+        typedef typename ColorPixel<C>::scalar T;
+        static const int K=ColorPixel<C>::channels, B=COLOR_BLOCK;
+
+        // Loads m<=B pixels (zero padded) as floats
+        static void load(const T* q, size_t m, float* r, float* g, float* b) {
+            if (m==size_t(B))
+                for (int j=0;j<B;j++) {
+                    r[j]=float(q[K*j]);
+                    g[j]=float(q[K*j+1]);
+                    b[j]=float(q[K*j+2]);
+                }
+            else
+                for (size_t j=0;j<size_t(B);j++) {
+                    r[j] = j<m ? float(q[K*j]) : 0.f;
+                    g[j] = j<m ? float(q[K*j+1]) : 0.f;
+                    b[j] = j<m ? float(q[K*j+2]) : 0.f;
+                }
+        }
+        // sRGB to linear: table for bytes
+        static void linearize(float* v, std::true_type) {
+            const ColorTables& t=ColorTables::instance();
+            for (int j=0;j<B;j++)
+                v[j]=t.linear[int(v[j])];
+        }
+        static void linearize(float* v, std::false_type) {
+            for (int j=0;j<B;j++)
+                v[j]=colorLinear(v[j]);
+        }
+        // Float conversion of a block (c1 and c2 unused for grey)
+        static void forward(ColorSpace s, float* r, float* g, float* b, float* c0, float* c1, float* c2) {
+            switch (s) {
+            case COLOR_GREY:
+                for (int j=0;j<B;j++)
+                    c0[j]=0.3f*r[j]+0.59f*g[j]+0.11f*b[j];
+                break;
+            case COLOR_YUV:
+                for (int j=0;j<B;j++) {
+                    const float y=0.299f*r[j]+0.587f*g[j]+0.114f*b[j];
+                    c0[j]=y;
+                    c1[j]=0.492f*(b[j]-y);
+                    c2[j]=0.877f*(r[j]-y);
+                }
+                break;
+            case COLOR_YCBCR:
+                for (int j=0;j<B;j++) {
+                    c0[j]=0.299f*r[j]+0.587f*g[j]+0.114f*b[j];
+                    c1[j]=128-0.168736f*r[j]-0.331264f*g[j]+0.5f*b[j];
+                    c2[j]=128+0.5f*r[j]-0.418688f*g[j]-0.081312f*b[j];
+                }
+                break;
+            case COLOR_HSV:
+                for (int j=0;j<B;j++) {
+                    const float M=std::max(r[j],std::max(g[j],b[j])), m=std::min(r[j],std::min(g[j],b[j])), d=M-m;
+                    const float e = d>0 ? 60/d : 0;
+                    float h = M==r[j] ? (g[j]-b[j])*e : M==g[j] ? (b[j]-r[j])*e+120 : (r[j]-g[j])*e+240;
+                    h = h<0 ? h+360 : h;
+                    c0[j]=h;
+                    c1[j] = M>0 ? d/M : 0;
+                    c2[j]=M;
+                }
+                break;
+            case COLOR_LAB:
+                linearize(r,std::is_same<T,byte>());
+                linearize(g,std::is_same<T,byte>());
+                linearize(b,std::is_same<T,byte>());
+                for (int j=0;j<B;j++) {
+                    const float x=(0.412453f*r[j]+0.357580f*g[j]+0.180423f*b[j])*(1/0.950456f),
+                        y=0.212671f*r[j]+0.715160f*g[j]+0.072169f*b[j],
+                        z=(0.019334f*r[j]+0.119193f*g[j]+0.950227f*b[j])*(1/1.088754f);
+                    const float fx=colorLabF(x), fy=colorLabF(y), fz=colorLabF(z);
+                    c0[j]=116*fy-16;
+                    c1[j]=500*(fx-fy);
+                    c2[j]=200*(fy-fz);
+                }
+                break;
+            }
+        }
+        // Stores m values of channel k
+        static void store(ColorSpace, int, const float* c, size_t m, float* o) {
+            std::memcpy(o,c,m*sizeof(float));
+        }
+        static void store(ColorSpace s, int k, const float* c, size_t m, byte* o) {
+            float scale, offset;
+            colorScale(s,k,scale,offset);
+            byte q[B];
+            if (s==COLOR_HSV && k==0)
+                for (int j=0;j<B;j++)
+                    q[j]=byte(int(c[j]*scale+.5f)&255);
+            else
+                for (int j=0;j<B;j++)
+                    q[j]=byte(int(std::min(std::max(c[j]*scale+offset,0.f),255.f)+.5f));
+            std::memcpy(o,q,m);
+        }
+        // Byte to byte conversions in fixed point, false if not available. Bytes and coefficients are 16 bits integers
+        // (products being 32 bits), so that SSE2 multiplies 8 of them at once.
+        static bool fixed(ColorSpace s, const C* p, size_t n, S* o0, S* o1, S* o2, std::true_type) {
+            static const short W[3][3][3]={
+                // grey
+                {{colorQ15(0.3),colorQ15(0.59),short(32768-colorQ15(0.3)-colorQ15(0.59))},{0,0,0},{0,0,0}},
+                // YUV
+                {{colorQ15(0.299),colorQ15(0.587),short(32768-colorQ15(0.299)-colorQ15(0.587))},
+                 {colorQ15(-0.492*0.299),colorQ15(-0.492*0.587),colorQ15(0.492*0.886)},
+                 {colorQ15(0.877*0.701),colorQ15(-0.877*0.587),colorQ15(-0.877*0.114)}},
+                // YCbCr
+                {{colorQ15(0.299),colorQ15(0.587),short(32768-colorQ15(0.299)-colorQ15(0.587))},
+                 {colorQ15(-0.168736),colorQ15(-0.331264),colorQ15(0.5)},
+                 {colorQ15(0.5),colorQ15(-0.418688),colorQ15(-0.081312)}}
+            };
+            if (s!=COLOR_GREY && s!=COLOR_YUV && s!=COLOR_YCBCR)
+                return false;
+            const short (*w)[3]=W[s];
+            const int channels = s==COLOR_GREY ? 1 : 3, round=1<<14, offset=(128<<15)+round;
+            S* const out[3]={o0,o1,o2};
+            for (size_t i=0;i<n;i+=B) {
+                const size_t m=std::min<size_t>(B,n-i);
+                const byte* q=&p[i][0];
+                short r[B], g[B], b[B];
+                if (m==size_t(B))
+                    for (int j=0;j<B;j++) {
+                        r[j]=q[K*j];
+                        g[j]=q[K*j+1];
+                        b[j]=q[K*j+2];
+                    }
+                else
+                    for (size_t j=0;j<size_t(B);j++) {
+                        r[j] = j<m ? q[K*j] : 0;
+                        g[j] = j<m ? q[K*j+1] : 0;
+                        b[j] = j<m ? q[K*j+2] : 0;
+                    }
+                for (int k=0;k<channels;k++) {
+                    const short w0=w[k][0], w1=w[k][1], w2=w[k][2];
+                    const int o = k==0 ? round : offset;
+                    byte v[B];
+                    for (int j=0;j<B;j++)
+                        v[j]=byte(std::min(std::max(w0*r[j]+w1*g[j]+w2*b[j]+o,0),255<<15)>>15);
+                    std::memcpy(out[k]+i,v,m);
+                }
+            }
+            return true;
+        }
+        static bool fixed(ColorSpace, const C*, size_t, S*, S*, S*, std::false_type) { return false; }
+
+        static void split(ColorSpace s, const C* p, size_t n, S* o0, S* o1, S* o2) {
+            if (fixed(s,p,n,o0,o1,o2,std::integral_constant<bool,std::is_same<T,byte>::value && std::is_same<S,byte>::value>()))
+                return;
+            for (size_t i=0;i<n;i+=B) {
+                const size_t m=std::min<size_t>(B,n-i);
+                float r[B], g[B], b[B], c0[B], c1[B], c2[B];
+                load(&p[i][0],m,r,g,b);
+                forward(s,r,g,b,c0,c1,c2);
+                store(s,0,c0,m,o0+i);
+                if (s!=COLOR_GREY) {
+                    store(s,1,c1,m,o1+i);
+                    store(s,2,c2,m,o2+i);
+                }
+            }
+        }
+
+        // Loads m<=B values of channel k as floats (zero padded)
+        static void unstore(ColorSpace, int, const float* o, size_t m, float* c) {
+            for (size_t j=0;j<size_t(B);j++)
+                c[j] = j<m ? o[j] : 0.f;
+        }
+        static void unstore(ColorSpace s, int k, const byte* o, size_t m, float* c) {
+            float scale, offset;
+            colorScale(s,k,scale,offset);
+            for (size_t j=0;j<size_t(B);j++)
+                c[j] = j<m ? (float(o[j])-offset)/scale : 0.f;
+        }
+        // Inverse conversion of a block, to linear values in [0,1] for Lab (linear set to true), [0,255] otherwise
+        static void backward(ColorSpace s, const float* c0, const float* c1, const float* c2, float* r, float* g, float* b) {
+            switch (s) {
+            case COLOR_GREY:
+                for (int j=0;j<B;j++)
+                    r[j]=g[j]=b[j]=c0[j];
+                break;
+            case COLOR_YUV:
+                for (int j=0;j<B;j++) {
+                    r[j]=c0[j]+c2[j]*(1/0.877f);
+                    b[j]=c0[j]+c1[j]*(1/0.492f);
+                    g[j]=(c0[j]-0.299f*r[j]-0.114f*b[j])*(1/0.587f);
+                }
+                break;
+            case COLOR_YCBCR:
+                for (int j=0;j<B;j++) {
+                    r[j]=c0[j]+1.402f*(c2[j]-128);
+                    g[j]=c0[j]-0.344136f*(c1[j]-128)-0.714136f*(c2[j]-128);
+                    b[j]=c0[j]+1.772f*(c1[j]-128);
+                }
+                break;
+            case COLOR_HSV:
+                // f(n)=V-V*S*max(0,min(k,4-k,1)), k=(n+H/60) mod 6, for n=5, 3 and 1
+                for (int j=0;j<B;j++) {
+                    const float h=c0[j]*(1.f/60), vs=c2[j]*c1[j];
+                    float kr=5+h, kg=3+h, kb=1+h;
+                    kr = kr>=6 ? kr-6 : kr;
+                    kg = kg>=6 ? kg-6 : kg;
+                    kb = kb>=6 ? kb-6 : kb;
+                    r[j]=c2[j]-vs*std::max(0.f,std::min(std::min(kr,4-kr),1.f));
+                    g[j]=c2[j]-vs*std::max(0.f,std::min(std::min(kg,4-kg),1.f));
+                    b[j]=c2[j]-vs*std::max(0.f,std::min(std::min(kb,4-kb),1.f));
+                }
+                break;
+            case COLOR_LAB:
+                for (int j=0;j<B;j++) {
+                    const float fy=(c0[j]+16)*(1.f/116), fx=fy+c1[j]*(1.f/500), fz=fy-c2[j]*(1.f/200);
+                    const float x=0.950456f*colorLabInvF(fx), y=colorLabInvF(fy), z=1.088754f*colorLabInvF(fz);
+                    r[j]=3.240479f*x-1.537150f*y-0.498535f*z;
+                    g[j]=-0.969256f*x+1.875992f*y+0.041556f*z;
+                    b[j]=0.055648f*x-0.204043f*y+1.057311f*z;
+                }
+                break;
+            }
+        }
+        // Writes m pixels from values in [0,255] (or linear ones)
+        static void unload(const float* r, const float* g, const float* b, size_t m, bool linear, T* q) {
+            for (size_t j=0;j<m;j++) {
+                const float v[3]={r[j],g[j],b[j]};
+                for (int k=0;k<3;k++)
+                    q[K*j+k]=toScalar(v[k],linear,std::is_same<T,byte>());
+                if (K==4)
+                    q[K*j+3]=colorOpaque<T>();
+            }
+        }
+        static T toScalar(float x, bool linear, std::true_type) {
+            if (linear)
+                return ColorTables::instance().toByte(x);
+            return byte(int(std::min(std::max(x,0.f),255.f)+.5f));
+        }
+        // Other types: integers rounded and saturated (see realToScalar())
+        static T toScalar(float x, bool linear, std::false_type) {
+            return realToScalar<T>(linear ? colorGamma(std::max(x,0.f)) : x,std::is_integral<T>());
+        }
+
+        static void merge(ColorSpace s, const S* o0, const S* o1, const S* o2, size_t n, C* p) {
+            for (size_t i=0;i<n;i+=B) {
+                const size_t m=std::min<size_t>(B,n-i);
+                float r[B], g[B], b[B], c0[B], c1[B], c2[B];
+                unstore(s,0,o0+i,m,c0);
+                if (s!=COLOR_GREY) {
+                    unstore(s,1,o1+i,m,c1);
+                    unstore(s,2,o2+i,m,c2);
+                }
+                backward(s,c0,c1,c2,r,g,b);
+                unload(r,g,b,m,s==COLOR_LAB,&p[i][0]);
+            }
+        }
+    };
+#endif
+
+    /// Color conversion (to grey).
+    /// Converts a color image (RGB<T> or RGBA<T>, e.g. Color or AlphaColor, alpha being ignored) to a grey level
+    /// plane 0.3*R+0.59*G+0.11*B, float or byte (rounded). Whole image at once: rows are converted in parallel (see
+    /// Parallel) with vectorized kernels (see Cpu), byte to byte in fixed point. Same as convertColors(I,COLOR_GREY,...).
+    /// \param I input color image
+    /// \param G output grey level image (float or byte), resized if needed
+    ///
+    /// \dontinclude Images/test/test.cpp \skip colors()
+    /// \skipline conversion to grey
+    template <typename C, typename S, int dim> void convertColors(const Image<C,dim>& I, Image<S,dim>& G) {
+        convertColors(I,COLOR_GREY,G,G,G);
+    }
+    /// Color conversion (to planes).
+    /// Converts a color image (RGB<T> or RGBA<T>, e.g. Color or AlphaColor, alpha being ignored) to three planes of a
+    /// given color space (see ColorSpace), float or byte (rounded and saturated). Whole image at once: rows are
+    /// converted in parallel (see Parallel) with vectorized kernels (see Cpu). Byte to byte conversions to YUV and YCbCr
+    /// use fixed point arithmetic (error below one unit).
+    /// \param I input color image
+    /// \param space color space
+    /// \param P0,P1,P2 output planes (float or byte), resized if needed (P1 and P2 unused for COLOR_GREY)
+    ///
+    /// \dontinclude Images/test/test.cpp \skip colors()
+    /// \skipline conversion to planes
+    /// \until ...
+    template <typename C, typename S, int dim>
+    void convertColors(const Image<C,dim>& I, ColorSpace space, Image<S,dim>& P0, Image<S,dim>& P1, Image<S,dim>& P2) {
+        ScopedTimer timer("Images::convertColors");
+        Image<S,dim>* const P[3]={&P0,&P1,&P2};
+        for (int k=0;k<(space==COLOR_GREY ? 1 : 3);k++)
+            if (P[k]->sizes()!=I.sizes())
+                *P[k]=Image<S,dim>(I.sizes());
+        Image<S,dim>& Q1 = space==COLOR_GREY ? P0 : P1;
+        Image<S,dim>& Q2 = space==COLOR_GREY ? P0 : P2;
+        I.parallelForEachRow([&](const C* p, size_t n, const Coords<dim>& c) {
+            cpuDispatch([&]() {
+                ColorRow<C,S>::split(space,p,n,P0.data()+P0.offset(c),Q1.data()+Q1.offset(c),Q2.data()+Q2.offset(c));
+            });
+        });
+    }
+    /// Color conversion (from planes).
+    /// Converts three planes of a given color space (see ColorSpace), float or byte, back to a color image (RGB<T> or
+    /// RGBA<T>, alpha being set to opaque, i.e. 255 as for RGBA(r,g,b)). Channels of integer types are rounded and
+    /// saturated. Rows are converted in parallel with vectorized kernels.
+    /// \param P0,P1,P2 input planes (P1 and P2 unused for COLOR_GREY)
+    /// \param space color space
+    /// \param I output color image, resized if needed
+    ///
+    /// \dontinclude Images/test/test.cpp \skip colors()
+    /// \skipline conversion from planes
+    template <typename C, typename S, int dim>
+    void convertColors(const Image<S,dim>& P0, const Image<S,dim>& P1, const Image<S,dim>& P2, ColorSpace space, Image<C,dim>& I) {
+        ScopedTimer timer("Images::convertColors");
+        assert(space==COLOR_GREY || (P1.sizes()==P0.sizes() && P2.sizes()==P0.sizes()));
+        if (I.sizes()!=P0.sizes())
+            I=Image<C,dim>(P0.sizes());
+        const Image<S,dim>& Q1 = space==COLOR_GREY ? P0 : P1;
+        const Image<S,dim>& Q2 = space==COLOR_GREY ? P0 : P2;
+        I.parallelForEachRow([&](C* p, size_t n, const Coords<dim>& c) {
+            cpuDispatch([&]() {
+                ColorRow<C,S>::merge(space,P0.data()+P0.offset(c),Q1.data()+Q1.offset(c),Q2.data()+Q2.offset(c),n,p);
+            });
+        });
+    }
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    // Image expressions (see ImageExpr), evaluated first
+    template <typename C, typename S, int dim, typename E> void convertColors(const ImageExpr<C,dim,E>& I, Image<S,dim>& G) {
+        convertColors(I.eval(),G);
+    }
+    template <typename C, typename S, int dim, typename E>
+    void convertColors(const ImageExpr<C,dim,E>& I, ColorSpace space, Image<S,dim>& P0, Image<S,dim>& P1, Image<S,dim>& P2) {
+        convertColors(I.eval(),space,P0,P1,P2);
+    }
+    template <typename C, typename S, int dim, typename E0, typename E1, typename E2>
+    void convertColors(const ImageExpr<S,dim,E0>& P0, const ImageExpr<S,dim,E1>& P1, const ImageExpr<S,dim,E2>& P2,
+                       ColorSpace space, Image<C,dim>& I) {
+        convertColors(P0.eval(),P1.eval(),P2.eval(),space,I);
+    }
+#endif
+
+    ///@}
+}
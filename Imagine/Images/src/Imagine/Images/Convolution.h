@@ -0,0 +1,336 @@
+// ===========================================================================
+// Imagine++ Libraries
+// Copyright (C) Imagine
+// For detailed information: http://imagine.enpc.fr/software
+// ===========================================================================
+
+namespace Imagine {
+    /// \addtogroup Images
+    /// @{
+
+    // ===============================================
+    // Convolution
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    // Kernel k of n coefficients reversed, as real values S: convolving then amounts to sliding dot products
+    template <typename S, typename K> std::vector<S> convolutionTaps(const K& k, size_t n) {
+        std::vector<S> h(n);
+        for (size_t j=0;j<n;j++)
+            h[j]=S(k[n-1-j]);
+        return h;
+    }
+#endif
+
+    /// In place convolution along a dimension.
+    /// Convolves lines of I along dimension d by kernel k of n coefficients: I(x) becomes the sum of
+    /// k[j]*I(x+(n/2-j)*e_d), values outside I being given by border condition bc (NeumannBorder, DirichletBorder,
+    /// MirrorBorder... see Border.h). Lines are copied with their borders to a buffer, so that border conditions are
+    /// only evaluated outside of the inner loops, which accumulate blocks of adjacent elements (vectorized, see Cpu).
+    /// Along d>0, bands of adjacent lines are filtered together and lines are shared among threads as with
+    /// inPlaceDeriche(). Images of integers are filtered in floating point, values being rounded and saturated when
+    /// written back.
+    /// \param I input/output image
+    /// \param k kernel (e.g. Array or FArray of scalars)
+    /// \param d dimension
+    /// \param bc border condition (default: Neumann)
+    ///
+    /// \dontinclude Images/test/test.cpp \skip algos()
+    /// \skipline in place convolution
+    /// \until ...
+    template <typename T, int dim, typename K, class BorderCondition = NeumannBorder<T,dim> >
+    void inPlaceConvolve(Image<T,dim>& I, const K& k, int d, const BorderCondition& bc = BorderCondition()) {
+        ScopedTimer timer("Images::convolve");
+        assert(k.size()>0 && d>=0 && d<dim);
+        typedef typename PixelTraits<T>::real_type S;
+        typedef RealPixel<T> P;
+        typedef typename P::R R;
+        const size_t n = size_t(k.size()), nb = size_t(I.size(d)), offset = I.stride(d);
+        const int left = int(n-1-n/2);
+        const std::vector<S> h = convolutionTaps<S>(k,n);
+        static const size_t L = sizeof(R)>=LINE_BAND ? 1 : LINE_BAND/sizeof(R);
+
+        // Writes w<=L results from buffer X of padded lines, taps being s values apart: y[i] is the dot product of h and
+        // X[i],X[i+s]...X[i+(n-1)*s], computed in local array A so that loops over i vectorize
+        auto taps = [&](const R* X, size_t s, size_t w, T* y) {
+            R A[L];
+            const S h0=h[0];
+            for (size_t i=0; i<w; i++)
+                A[i] = h0*X[i];
+            for (size_t j=1; j<n; j++) {
+                const S hj=h[j];
+                const R* x = X+j*s;
+                for (size_t i=0; i<w; i++)
+                    A[i] += hj*x[i];
+            }
+            P::template fromReal<L>(A,w,y);
+        };
+
+        forEachLine<R>(I.sizes(), d, L, d==0 ? nb+n-1 : (nb+n-1)*L, [&](const Coords<dim>& c, size_t w, R* Y) {
+            T* ima = &I(c);
+            Coords<dim> q = c;
+            if (d==0) {
+                // Line with its borders, then blocks of L elements
+                for (size_t i=0; i<nb; i++)
+                    Y[left+i] = P::toReal(ima[i]);
+                for (int i=0; i<left; i++) {
+                    q[0] = i-left;
+                    Y[i] = P::toReal(bc(I,q));
+                }
+                for (size_t i=nb; i<nb+n-1-left; i++) {
+                    q[0] = int(i);
+                    Y[left+i] = P::toReal(bc(I,q));
+                }
+                size_t i=0;
+                for (; i+L<=nb; i+=L)
+                    taps(Y+i,1,L,ima+i);    // constant width: vectorized loops
+                if (i<nb)
+                    taps(Y+i,1,nb-i,ima+i);
+                return;
+            }
+            // Band of w lines with their borders, row i of the band (of w elements) being at Y+i*L, then rows of
+            // the result
+            R X[L];
+            for (size_t i=0; i<nb; i++) {
+                const T* r = ima+i*offset;
+                for (size_t l=0; l<w; l++)
+                    X[l] = P::toReal(r[l]);
+                R* y = Y+(left+i)*L;
+                for (size_t l=0; l<w; l++)
+                    y[l] = X[l];
+            }
+            for (size_t i=0; i<n-1; i++) {
+                q[d] = int(i)<left ? int(i)-left : int(nb+i)-left;
+                R* y = Y+(int(i)<left ? i : nb+i)*L;
+                for (size_t l=0; l<w; l++) {
+                    q[0] = c[0]+int(l);
+                    y[l] = P::toReal(bc(I,q));
+                }
+            }
+            // Rows of the result, reading all lanes of each row of the band
+            for (size_t i=0; i<nb; i++) {
+                if (w==L)
+                    taps(Y+i*L,L,L,ima+i*offset);   // constant width: vectorized loops
+                else
+                    taps(Y+i*L,L,w,ima+i*offset);
+            }
+        });
+    }
+    /// Convolution along a dimension.
+    /// Convolution of lines of I along dimension d by kernel k (see inPlaceConvolve())
+    /// \param I input image
+    /// \param k kernel (e.g. Array or FArray of scalars)
+    /// \param d dimension
+    /// \param bc border condition (default: Neumann)
+    /// \return convolved image
+    ///
+    /// \dontinclude Images/test/test.cpp \skip algos()
+    /// \skipline convolution along
+    template <typename T, int dim, typename K, class BorderCondition = NeumannBorder<T,dim> >
+    inline Image<T,dim> convolve(const Image<T,dim>& I, const K& k, int d, const BorderCondition& bc = BorderCondition()) {
+        Image<T,dim> J=I.clone();
+        inPlaceConvolve(J,k,d,bc);
+        return J;
+    }
+    /// In place separable convolution.
+    /// Convolves I by kernel k along each dimension (see inPlaceConvolve()), i.e. by the separable kernel
+    /// k[j_0]*...*k[j_{dim-1}]
+    /// \param I input/output image
+    /// \param k kernel (e.g. Array or FArray of scalars)
+    /// \param bc border condition (default: Neumann)
+    ///
+    /// \dontinclude Images/test/test.cpp \skip algos()
+    /// \skipline separable convolution
+    template <typename T, int dim, typename K, class BorderCondition = NeumannBorder<T,dim> >
+    void inPlaceSeparableConvolve(Image<T,dim>& I, const K& k, const BorderCondition& bc = BorderCondition()) {
+        for (int i=0;i<dim;i++)
+            inPlaceConvolve(I,k,i,bc);
+    }
+    /// Separable convolution.
+    /// Convolution of I by kernel k along each dimension (see inPlaceSeparableConvolve())
+    /// \param I input image
+    /// \param k kernel (e.g. Array or FArray of scalars)
+    /// \param bc border condition (default: Neumann)
+    /// \return convolved image
+    template <typename T, int dim, typename K, class BorderCondition = NeumannBorder<T,dim> >
+    inline Image<T,dim> separableConvolve(const Image<T,dim>& I, const K& k, const BorderCondition& bc = BorderCondition()) {
+        Image<T,dim> J=I.clone();
+        inPlaceSeparableConvolve(J,k,bc);
+        return J;
+    }
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    // Sums of X(x+j)*h[j] over taps j of sizes ks (h in storage order) by FFT, written to J, if faster than direct sums
+    // (only for real pixels: returns false otherwise). Correlating by h is convolving by h reversed, the sums being the
+    // full convolution at x+ks-1.
+    template <typename T, int dim, typename R, typename Q>
+    bool fftKernelSums(const Image<R,dim>&, const std::vector<Q>&, const Coords<dim>&, Image<T,dim>&, std::false_type) {
+        return false;
+    }
+    template <typename T, int dim, typename R, typename Q>
+    bool fftKernelSums(const Image<R,dim>& X, const std::vector<Q>& h, const Coords<dim>& ks, Image<T,dim>& J, std::true_type) {
+        const Coords<dim> m = fftSizes(X.sizes());
+        if (!fftFaster(double(J.totalSize()),double(h.size()),m))
+            return false;
+        MultiArray<R,dim> K(ks);
+        for (size_t i=0;i<h.size();i++)
+            K[i] = R(h[h.size()-1-i]);
+        const MultiArray<R,dim> C = fftConvolution<R,dim>(X,K,m);
+        J.parallelForEachRow([&](T* y, size_t n, const Coords<dim>& c) {
+            const R* x = &C(c+ks-Coords<dim>(1));
+            for (size_t i=0;i<n;i++)
+                y[i] = RealPixel<T>::fromReal(x[i]);
+        });
+        return true;
+    }
+
+    // Image whose value at x is the sum of h[j]*I(x+j-left) over taps j of sizes ks (h in storage order), values outside
+    // I being given by border condition bc. I is first copied with its borders to a padded image X (in floating point
+    // for integers). Sums are then computed by FFT if faster, or directly.
+    template <typename T, int dim, typename Q, class BorderCondition>
+    Image<T,dim> kernelSums(const Image<T,dim>& I, const std::vector<Q>& h, const Coords<dim>& ks, const Coords<dim>& left,
+                            const BorderCondition& bc) {
+        typedef RealPixel<T> P;
+        typedef typename P::R R;
+        const Coords<dim> sz = I.sizes();
+        const size_t n0 = size_t(ks[0]), rows = h.size()/n0, w0 = size_t(sz[0]);
+        Image<R,dim> X(sz+ks-Coords<dim>(1));
+
+        // Padded image: rows inside I are copied, border conditions giving the others
+        X.parallelForEachRow([&](R* p, size_t n, const Coords<dim>& c) {
+            Coords<dim> q = c-left;
+            bool inside = true;
+            for (int i=1;i<dim;i++)
+                inside = inside && q[i]>=0 && q[i]<sz[i];
+            size_t b = n, e = n;
+            if (inside) {
+                b = size_t(left[0]);
+                e = b+w0;
+                q[0] = 0;
+                const T* r = &I(q);
+                for (size_t i=b;i<e;i++)
+                    p[i] = P::toReal(r[i-b]);
+            }
+            for (size_t i=0;i<n;i++) {
+                if (i>=b && i<e)
+                    continue;
+                q[0] = int(i)-left[0];
+                p[i] = P::toReal(bc(I,q));
+            }
+        });
+        Image<T,dim> J(sz);
+        if (fftKernelSums(X,h,ks,J,std::integral_constant<bool,std::is_floating_point<R>::value>()))
+            return J;
+
+        // Offsets of kernel rows in X
+        std::vector<size_t> off;
+        Coords<dim> kb(0), ke = ks-Coords<dim>(1);
+        ke[0] = 0;
+        for (CoordsIterator<dim> c(kb,ke); c != CoordsIterator<dim>(); ++c)
+            off.push_back(size_t(&X(*c)-&X(kb)));
+        static const size_t L = sizeof(R)>=LINE_BAND ? 1 : LINE_BAND/sizeof(R);
+        J.parallelForEachRow([&](T* y, size_t n, const Coords<dim>& c) {
+            const R* x0 = &X(c);
+            cpuDispatch([&]() {
+                // Writes w<=L elements from X row r: products with kernel rows, accumulated in local array A
+                auto block = [&](const R* r, size_t w, T* out) {
+                    R A[L];
+                    const Q h0 = h[0];
+                    for (size_t i=0; i<w; i++)
+                        A[i] = h0*r[i];     // first tap (R(0) is not a zero for color pixels)
+                    for (size_t m=0; m<rows; m++) {
+                        const R* x = r+off[m];
+                        const Q* hm = &h[m*n0];
+                        for (size_t j = m==0 ? 1 : 0; j<n0; j++) {
+                            const Q hj = hm[j];
+                            for (size_t i=0; i<w; i++)
+                                A[i] += hj*x[j+i];
+                        }
+                    }
+                    P::template fromReal<L>(A,w,out);
+                };
+                size_t i=0;
+                for (; i+L<=n; i+=L)
+                    block(x0+i,L,y+i);  // constant width: vectorized loops
+                if (i<n)
+                    block(x0+i,n-i,y+i);
+            });
+        });
+        return J;
+    }
+#endif
+
+    /// Convolution.
+    /// Convolution of I by a (non separable) kernel K: result at x is the sum of K(j)*I(x+c-j), c being the center
+    /// K.sizes()/2 of K, values outside I being given by border condition bc (see inPlaceConvolve()). I is first
+    /// copied with its borders to a padded image, in floating point for integers. For large kernels of images of
+    /// scalars, the convolution is computed by FFT (see fftConvolve()), in O(N log N) for N pixels. Otherwise, rows of
+    /// the result are computed in parallel (see Parallel), by blocks of adjacent pixels accumulating products with
+    /// kernel rows (vectorized, see Cpu), for K.totalSize() operations per pixel: prefer separable convolutions
+    /// whenever possible.
+    /// \param I input image
+    /// \param K kernel
+    /// \param bc border condition (default: Neumann)
+    /// \return convolved image
+    ///
+    /// \dontinclude Images/test/test.cpp \skip algos()
+    /// \skipline non separable convolution
+    /// \until ...
+    template <typename T, int dim, typename S, class BorderCondition = NeumannBorder<T,dim> >
+    Image<T,dim> convolve(const Image<T,dim>& I, const Image<S,dim>& K, const BorderCondition& bc = BorderCondition()) {
+        ScopedTimer timer("Images::convolve");
+        typedef typename PixelTraits<T>::real_type Q;
+        std::vector<Q> k;
+        K.forEachElement([&](const S& v) { k.push_back(Q(v)); });
+        Coords<dim> left;
+        for (int i=0;i<dim;i++)
+            left[i] = K.size(i)-1-K.size(i)/2;
+        return kernelSums(I,convolutionTaps<Q>(k,k.size()),K.sizes(),left,bc);
+    }
+    /// Correlation.
+    /// Correlation of I with kernel K (e.g. template matching): result at x is the sum of K(j)*I(x+j-c), c being the
+    /// center K.sizes()/2 of K, i.e. the convolution by K reversed (see convolve(const Image<T,dim>&,const Image<S,dim>&,const BorderCondition&)).
+    /// Computed by FFT for large kernels of images of scalars.
+    /// \param I input image
+    /// \param K kernel
+    /// \param bc border condition (default: Neumann)
+    /// \return correlation image
+    ///
+    /// \dontinclude Images/test/test.cpp \skip algos()
+    /// \skipline correlation
+    /// \until ...
+    template <typename T, int dim, typename S, class BorderCondition = NeumannBorder<T,dim> >
+    Image<T,dim> correlate(const Image<T,dim>& I, const Image<S,dim>& K, const BorderCondition& bc = BorderCondition()) {
+        ScopedTimer timer("Images::correlate");
+        typedef typename PixelTraits<T>::real_type Q;
+        std::vector<Q> k;
+        K.forEachElement([&](const S& v) { k.push_back(Q(v)); });
+        const Coords<dim> left=K.sizes()/2;
+        return kernelSums(I,k,K.sizes(),left,bc);
+    }
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    // Image expressions (see ImageExpr), evaluated first
+    template <typename T, int dim, typename E, typename K, class BorderCondition = NeumannBorder<T,dim> >
+    inline Image<T,dim> convolve(const ImageExpr<T,dim,E>& I, const K& k, int d, const BorderCondition& bc = BorderCondition()) {
+        Image<T,dim> J=I.eval();
+        inPlaceConvolve(J,k,d,bc);
+        return J;
+    }
+    template <typename T, int dim, typename E, typename K, class BorderCondition = NeumannBorder<T,dim> >
+    inline Image<T,dim> separableConvolve(const ImageExpr<T,dim,E>& I, const K& k, const BorderCondition& bc = BorderCondition()) {
+        Image<T,dim> J=I.eval();
+        inPlaceSeparableConvolve(J,k,bc);
+        return J;
+    }
+    template <typename T, int dim, typename E, typename S, class BorderCondition = NeumannBorder<T,dim> >
+    inline Image<T,dim> convolve(const ImageExpr<T,dim,E>& I, const Image<S,dim>& K, const BorderCondition& bc = BorderCondition()) {
+        return convolve(I.eval(),K,bc);
+    }
+    template <typename T, int dim, typename E, typename S, class BorderCondition = NeumannBorder<T,dim> >
+    inline Image<T,dim> correlate(const ImageExpr<T,dim,E>& I, const Image<S,dim>& K, const BorderCondition& bc = BorderCondition()) {
+        return correlate(I.eval(),K,bc);
+    }
+#endif
+
+    ///@}
+}
@@ -0,0 +1,271 @@
+// ===========================================================================
+// Imagine++ Libraries
+// Copyright (C) Imagine
+// For detailed information: http://imagine.enpc.fr/software
+// ===========================================================================
+
+namespace Imagine {
+    /// \addtogroup Images
+    /// @{
+
+    template <typename T, int dim> class Image;
+
+    /// \headerfile Imagine/Images.h "Imagine/Images.h"
+    /// Image expression.
+    /// Elementwise arithmetic on images (+, -, *, / with images and scalars) does not compute anything by itself:
+    /// it builds an expression, which is evaluated when assigned to (or used to construct) an Image. All operations
+    /// are then performed in a single pass over pixels, without intermediate images. E.g. <tt>D=A*s+B-C;</tt> allocates
+    /// only D. Each operation converts its result to the pixel type, exactly as if intermediate images were computed.
+    ///
+    /// An expression converts to an Image (see Image(const ImageExpr<T,dim,E>&)), so it can be given to functions taking
+    /// a const Image&. Function templates of Imagine++ processing whole images (e.g. grey(), blur(), convolve(),
+    /// convertColors()) also take expressions, evaluated first. Other function templates (e.g. pointwise schemes such
+    /// as gradient(), or user ones) need an explicit evaluation: <tt>f(eval(A-B))</tt> or <tt>f((A-B).eval())</tt>.
+    /// Operands are shared, not copied: <b>do not keep an expression (e.g. with auto) after modifying its operands</b>.
+    ///
+    /// \param T pixel type
+    /// \param dim dimension
+    /// \param E actual expression type
+    template <typename T, int dim, typename E> class ImageExpr {
+    public:
+        /// Pixel type.
+        typedef T value_type;
+        /// Scalar type (see Image::scalar_type).
+        typedef typename PixelTraits<T>::scalar_type scalar_type;
+        /// Actual expression.
+        const E& self() const { return static_cast<const E&>(*this); }
+        /// Evaluation.
+        /// Computes the expression in a new image (see ImageExpr)
+        /// \return image
+        ///
+        /// \dontinclude Images/test/test.cpp \skip images()
+        /// \skipline evaluation
+        Image<T,dim> eval() const { return Image<T,dim>(*this); }
+    };
+    /// Evaluation.
+    /// Computes an image expression in a new image, e.g. to give it to a function template taking a const Image&
+    /// \param e expression
+    /// \return image
+    ///
+    /// \dontinclude Images/test/test.cpp \skip images()
+    /// \skipline evaluation
+    template <typename T, int dim, typename E> inline Image<T,dim> eval(const ImageExpr<T,dim,E>& e) { return e.eval(); }
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    // Elementwise operations
+    struct ExprAdd { template <typename A, typename B> static auto apply(const A& a, const B& b) -> decltype(a+b) { return a+b; } };
+    struct ExprSub { template <typename A, typename B> static auto apply(const A& a, const B& b) -> decltype(a-b) { return a-b; } };
+    struct ExprMul { template <typename A, typename B> static auto apply(const A& a, const B& b) -> decltype(a*b) { return a*b; } };
+    struct ExprDiv { template <typename A, typename B> static auto apply(const A& a, const B& b) -> decltype(a/b) { return a/b; } };
+    struct ExprNeg { template <typename A> static auto apply(const A& a) -> decltype(-a) { return -a; } };
+
+    // Expressions hold their operands by value (images thus share memory with the original ones) and provide:
+    // - sizes(), isContiguous() (true if all images involved are contiguous)
+    // - exprBlank(): new image with the layout of the leftmost image
+    // - exprUses(J): number of images sharing memory with J
+    // - exprAliases(J): true if an image reads memory of J at other places than the written ones
+    // - cursor(c): object giving the value of the expression at c+i*stride(0) with operator[](i)
+
+    // T(Op(l,r))
+    template <typename T, int dim, typename L, typename R, typename Op>
+    class ImageBinaryExpr : public ImageExpr<T,dim,ImageBinaryExpr<T,dim,L,R,Op> > {
+        L _l;
+        R _r;
+    public:
+        ImageBinaryExpr(const L& l, const R& r) : _l(l), _r(r) { assert(l.sizes()==r.sizes()); }
+        Coords<dim> sizes() const { return _l.sizes(); }
+        bool isContiguous() const { return _l.isContiguous() && _r.isContiguous(); }
+        Image<T,dim> exprBlank() const { return _l.exprBlank(); }
+        template <typename U> int exprUses(const Image<U,dim>& J) const { return _l.exprUses(J) + _r.exprUses(J); }
+        template <typename U> bool exprAliases(const Image<U,dim>& J) const { return _l.exprAliases(J) || _r.exprAliases(J); }
+        struct Cursor {
+            typename L::Cursor l;
+            typename R::Cursor r;
+            T operator[](size_t i) const { return T(Op::apply(l[i],r[i])); }
+        };
+        Cursor cursor(const Coords<dim>& c) const { Cursor k={_l.cursor(c),_r.cursor(c)}; return k; }
+    };
+
+    // T(Op(e,s)), s being a scalar
+    template <typename T, int dim, typename E, typename S, typename Op>
+    class ImageScalarExpr : public ImageExpr<T,dim,ImageScalarExpr<T,dim,E,S,Op> > {
+        E _e;
+        S _s;
+    public:
+        ImageScalarExpr(const E& e, const S& s) : _e(e), _s(s) {}
+        Coords<dim> sizes() const { return _e.sizes(); }
+        bool isContiguous() const { return _e.isContiguous(); }
+        Image<T,dim> exprBlank() const { return _e.exprBlank(); }
+        template <typename U> int exprUses(const Image<U,dim>& J) const { return _e.exprUses(J); }
+        template <typename U> bool exprAliases(const Image<U,dim>& J) const { return _e.exprAliases(J); }
+        struct Cursor {
+            typename E::Cursor e;
+            S s;
+            T operator[](size_t i) const { return T(Op::apply(e[i],s)); }
+        };
+        Cursor cursor(const Coords<dim>& c) const { Cursor k={_e.cursor(c),_s}; return k; }
+    };
+
+    // T(Op(e))
+    template <typename T, int dim, typename E, typename Op>
+    class ImageUnaryExpr : public ImageExpr<T,dim,ImageUnaryExpr<T,dim,E,Op> > {
+        E _e;
+    public:
+        explicit ImageUnaryExpr(const E& e) : _e(e) {}
+        Coords<dim> sizes() const { return _e.sizes(); }
+        bool isContiguous() const { return _e.isContiguous(); }
+        Image<T,dim> exprBlank() const { return _e.exprBlank(); }
+        template <typename U> int exprUses(const Image<U,dim>& J) const { return _e.exprUses(J); }
+        template <typename U> bool exprAliases(const Image<U,dim>& J) const { return _e.exprAliases(J); }
+        struct Cursor {
+            typename E::Cursor e;
+            T operator[](size_t i) const { return T(Op::apply(e[i])); }
+        };
+        Cursor cursor(const Coords<dim>& c) const { Cursor k={_e.cursor(c)}; return k; }
+    };
+#endif
+
+    /// Opposite.
+    /// Opposite of an image
+    /// \param A image (or image expression)
+    /// \return opposite (expression)
+    ///
+    /// \dontinclude Images/test/test.cpp \skip images()
+    /// \skipline unary -
+    template <typename T, int dim, typename E>
+    inline ImageUnaryExpr<T,dim,E,ExprNeg> operator-(const ImageExpr<T,dim,E>& A) {
+        return ImageUnaryExpr<T,dim,E,ExprNeg>(A.self());
+    }
+    /// Addition.
+    /// Addition of two images
+    /// \param A,B images (or image expressions)
+    /// \return sum (expression)
+    ///
+    /// \dontinclude Images/test/test.cpp \skip images()
+    /// \skipline image +
+    template <typename T, int dim, typename L, typename R>
+    inline ImageBinaryExpr<T,dim,L,R,ExprAdd> operator+(const ImageExpr<T,dim,L>& A, const ImageExpr<T,dim,R>& B) {
+        return ImageBinaryExpr<T,dim,L,R,ExprAdd>(A.self(),B.self());
+    }
+    /// Substraction.
+    /// Substraction of two images
+    /// \param A,B images (or image expressions)
+    /// \return difference (expression)
+    ///
+    /// \dontinclude Images/test/test.cpp \skip images()
+    /// \skipline image -
+    template <typename T, int dim, typename L, typename R>
+    inline ImageBinaryExpr<T,dim,L,R,ExprSub> operator-(const ImageExpr<T,dim,L>& A, const ImageExpr<T,dim,R>& B) {
+        return ImageBinaryExpr<T,dim,L,R,ExprSub>(A.self(),B.self());
+    }
+    /// Constant addition.
+    /// Addition of a constant
+    /// \param A image (or image expression)
+    /// \param v constant to be added to A
+    /// \return result (expression)
+    ///
+    /// \dontinclude Images/test/test.cpp \skip images()
+    /// \skipline constant +
+    template <typename T, int dim, typename E>
+    inline ImageScalarExpr<T,dim,E,T,ExprAdd> operator+(const ImageExpr<T,dim,E>& A, typename ImageExpr<T,dim,E>::value_type v) {
+        return ImageScalarExpr<T,dim,E,T,ExprAdd>(A.self(),v);
+    }
+    /// Constant addition.
+    /// Addition of a constant
+    /// \param v constant to be added to A
+    /// \param A image (or image expression)
+    /// \return result (expression)
+    ///
+    /// \dontinclude Images/test/test.cpp \skip images()
+    /// \skipline constant + image
+    template <typename T, int dim, typename E>
+    inline ImageScalarExpr<T,dim,E,T,ExprAdd> operator+(typename ImageExpr<T,dim,E>::value_type v, const ImageExpr<T,dim,E>& A) {
+        return A+v;
+    }
+    /// Constant substraction.
+    /// Substraction of a constant
+    /// \param A image (or image expression)
+    /// \param v constant to be substracted from A
+    /// \return result (expression)
+    ///
+    /// \dontinclude Images/test/test.cpp \skip images()
+    /// \skipline constant -
+    template <typename T, int dim, typename E>
+    inline ImageScalarExpr<T,dim,E,T,ExprSub> operator-(const ImageExpr<T,dim,E>& A, typename ImageExpr<T,dim,E>::value_type v) {
+        return ImageScalarExpr<T,dim,E,T,ExprSub>(A.self(),v);
+    }
+    /// Constant substraction.
+    /// Substraction of a constant
+    /// \param v constant from which A is to be substracted
+    /// \param A image (or image expression)
+    /// \return result (expression)
+    ///
+    /// \dontinclude Images/test/test.cpp \skip images()
+    /// \skipline constant - image
+    template <typename T, int dim, typename E>
+    inline ImageScalarExpr<T,dim,ImageUnaryExpr<T,dim,E,ExprNeg>,T,ExprAdd> operator-(typename ImageExpr<T,dim,E>::value_type v, const ImageExpr<T,dim,E>& A) {
+        return (-A)+v;
+    }
+    /// Scalar multiplication.
+    /// Multiplication by a scalar
+    /// \param A image (or image expression)
+    /// \param s scalar factor
+    /// \return result (expression)
+    ///
+    /// \dontinclude Images/test/test.cpp \skip images()
+    /// \skipline scalar *
+    template <typename T, int dim, typename E>
+    inline ImageScalarExpr<T,dim,E,typename PixelTraits<T>::scalar_type,ExprMul> operator*(const ImageExpr<T,dim,E>& A, typename ImageExpr<T,dim,E>::scalar_type s) {
+        return ImageScalarExpr<T,dim,E,typename PixelTraits<T>::scalar_type,ExprMul>(A.self(),s);
+    }
+    /// Scalar multiplication.
+    /// Multiplication by a scalar
+    /// \param s scalar factor
+    /// \param A image (or image expression)
+    /// \return result (expression)
+    ///
+    /// \dontinclude Images/test/test.cpp \skip images()
+    /// \skipline scalar * image
+    template <typename T, int dim, typename E>
+    inline ImageScalarExpr<T,dim,E,typename PixelTraits<T>::scalar_type,ExprMul> operator*(typename ImageExpr<T,dim,E>::scalar_type s, const ImageExpr<T,dim,E>& A) {
+        return A*s;
+    }
+    /// Scalar division.
+    /// Division by a scalar
+    /// \param A image (or image expression)
+    /// \param s scalar factor
+    /// \return result (expression)
+    ///
+    /// \dontinclude Images/test/test.cpp \skip images()
+    /// \skipline scalar /
+    template <typename T, int dim, typename E>
+    inline ImageScalarExpr<T,dim,E,typename PixelTraits<T>::scalar_type,ExprDiv> operator/(const ImageExpr<T,dim,E>& A, typename ImageExpr<T,dim,E>::scalar_type s) {
+        return ImageScalarExpr<T,dim,E,typename PixelTraits<T>::scalar_type,ExprDiv>(A.self(),s);
+    }
+    /// Pointwise scalar multiplication.
+    /// Pointwise multiplication by a scalar image
+    /// \param A image (or image expression)
+    /// \param B scalar image (or image expression)
+    /// \return result (expression)
+    ///
+    /// \dontinclude Images/test/test.cpp \skip images()
+    /// \skipline pointwise scalar *
+    template <typename T, int dim, typename L, typename R>
+    inline ImageBinaryExpr<T,dim,L,R,ExprMul> operator*(const ImageExpr<T,dim,L>& A, const ImageExpr<typename PixelTraits<T>::scalar_type,dim,R>& B) {
+        return ImageBinaryExpr<T,dim,L,R,ExprMul>(A.self(),B.self());
+    }
+    /// Pointwise scalar division.
+    /// Pointwise division by a scalar image
+    /// \param A image (or image expression)
+    /// \param B scalar image (or image expression)
+    /// \return result (expression)
+    ///
+    /// \dontinclude Images/test/test.cpp \skip images()
+    /// \skipline pointwise scalar /
+    template <typename T, int dim, typename L, typename R>
+    inline ImageBinaryExpr<T,dim,L,R,ExprDiv> operator/(const ImageExpr<T,dim,L>& A, const ImageExpr<typename PixelTraits<T>::scalar_type,dim,R>& B) {
+        return ImageBinaryExpr<T,dim,L,R,ExprDiv>(A.self(),B.self());
+    }
+
+    ///@}
+}
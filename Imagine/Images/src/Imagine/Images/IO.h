@@ -10,6 +10,13 @@ namespace Imagine {
 
 
 
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    // I itself if its pixels are contiguous, otherwise a contiguous copy (as expected by Graphics functions)
+    template <typename T, int dim> inline Image<T,dim> contiguousPixels(const Image<T,dim>& I) {
+        return I.isContiguous() ? I : I.clone();
+    }
+#endif
+
     /// Create a transparency mask from a specified color-key.
     /// Create a transparency mask from a specified color-key.
     /// Hides a color in current image by making it invisible.
@@ -21,7 +28,14 @@ namespace Imagine {
     /// \until ...
     inline void createMaskFromColor(Image<AlphaColor>& I, AlphaColor col) {
         AlphaColor* aC = I.data();
-        setMaskFromColor(aC,I.width(), I.height(), col);
+        if (I.isContiguous()) {
+            setMaskFromColor(aC,I.width(), I.height(), col);
+            return;
+        }
+        for (int y=0; y<I.height(); y++) {
+            aC = I.data()+I.offset(0,y);
+            setMaskFromColor(aC,I.width(), 1, col);
+        }
     }
 
     // Files
@@ -51,7 +65,8 @@ namespace Imagine {
     /// \dontinclude Images/test/test.cpp \skip io()
     /// \skipline save grey
     inline bool save(const Image<byte>& I, std::string name) {
-        return saveGreyImage(name,(byte *)I.data(),I.width(),I.height());
+        const Image<byte> C=contiguousPixels(I);
+        return saveGreyImage(name,(byte *)C.data(),C.width(),C.height());
     }
     /// Load color image.
     /// Loads a color (i.e Color) image from a file. Known formats are JPG, PNG, TIFF
@@ -117,7 +132,8 @@ namespace Imagine {
     /// \skipline save color
     /// \until ...
     inline bool save(const Image<Color>& I, std::string name,int quality=85) {
-        return saveColorImage(name,I.data(),I.width(),I.height(),quality);
+        const Image<Color> C=contiguousPixels(I);
+        return saveColorImage(name,C.data(),C.width(),C.height(),quality);
     }
     /// Save color imagewith alpha channel.
     /// Saves a alpha color (i.e AlphaColor) image to a file. Known formats are JPG, PNG, TIFF, GIF
@@ -129,7 +145,8 @@ namespace Imagine {
     /// \dontinclude Images/test/test.cpp \skip io_transparency()
     /// \skipline save image with alpha channel
     inline bool save(Image<AlphaColor>& I, std::string name, int quality=85) {
-        return saveAlphaColorImage(name, I.data(), I.width(), I.height(), quality);
+        Image<AlphaColor> C=contiguousPixels(I);
+        return saveAlphaColorImage(name, C.data(), C.width(), C.height(), quality);
     }
 
 
@@ -144,7 +161,8 @@ namespace Imagine {
     /// \skipline save color chanels
     inline bool save(const Image<byte>& IR, const Image<byte>& IG, const Image<byte>& IB, std::string name,int quality=85) {
         assert(IR.sizes() == IG.sizes() && IR.sizes() == IB.sizes());
-        return saveColorImage(name,(byte *)IR.data(),(byte *)IG.data(),(byte *)IB.data(),IR.width(),IR.height(),quality);
+        const Image<byte> R=contiguousPixels(IR),G=contiguousPixels(IG),B=contiguousPixels(IB);
+        return saveColorImage(name,(byte *)R.data(),(byte *)G.data(),(byte *)B.data(),R.width(),R.height(),quality);
     }
 
     //==================== DISPLAY ===============
@@ -159,7 +177,8 @@ namespace Imagine {
     /// \dontinclude Images/test/test.cpp \skip io()
     /// \skipline display grey
     inline void display(const Image<byte>& I, int x=0, int y=0,bool xorMode=false,double fact=1.) {
-        putGreyImage(x,y,(byte *)I.data(),I.width(),I.height(),xorMode,fact);
+        const Image<byte> C=contiguousPixels(I);
+        putGreyImage(x,y,(byte *)C.data(),C.width(),C.height(),xorMode,fact);
     }
     /// Display grey image (IntPoint2 alias).
     inline void display(const Image<byte>& I,IntPoint2 p,bool xorMode=false,double fact=1.) { display(I,p.x(),p.y(),xorMode,fact); }
@@ -173,7 +192,8 @@ namespace Imagine {
     /// \dontinclude Images/test/test.cpp \skip io()
     /// \skipline display color
     inline void display(const Image<Color>& I, int x=0, int y=0,bool xorMode=false,double fact=1.) {
-        putColorImage(x,y,(Color *)I.data(),I.width(),I.height(),xorMode,fact);
+        const Image<Color> C=contiguousPixels(I);
+        putColorImage(x,y,(Color *)C.data(),C.width(),C.height(),xorMode,fact);
     }
     /// Display color image with alpha channel.
     /// Displays a alpha color image in current Window. NB: zooming factor is a fast hardware rendering and does not necesseraly use interpolation or anti aliasing.
@@ -185,7 +205,8 @@ namespace Imagine {
     /// \dontinclude Images/test/test.cpp \skip io_transparency()
     /// \skipline Display PNG Image
     inline void display(const Image<AlphaColor>& I, int x = 0, int y = 0, bool xorMode = false, double fact=1.) {
-        putAlphaColorImage(x,y,(AlphaColor *)I.data(), I.width(), I.height(), xorMode, fact);
+        const Image<AlphaColor> C=contiguousPixels(I);
+        putAlphaColorImage(x,y,(AlphaColor *)C.data(), C.width(), C.height(), xorMode, fact);
     }
 
     /// Display color image (IntPoint2 alias).
@@ -201,7 +222,8 @@ namespace Imagine {
     /// \skipline display color (3 chanels)
     inline void display(const Image<byte>& IR, const Image<byte>& IG, const Image<byte>& IB, int x=0, int y=0,bool xorMode=false,double fact=1.) {
         assert( IR.sizes() == IG.sizes() && IR.sizes() == IB.sizes());
-        putColorImage(x,y,(byte *)IR.data(),(byte *)IG.data(),(byte *)IB.data(),IR.width(),IR.height(),xorMode,fact);
+        const Image<byte> R=contiguousPixels(IR),G=contiguousPixels(IG),B=contiguousPixels(IB);
+        putColorImage(x,y,(byte *)R.data(),(byte *)G.data(),(byte *)B.data(),R.width(),R.height(),xorMode,fact);
     }
     /// Display color image (3 chanels, IntPoint2 alias).
     inline void display(const Image<byte>& IR, const Image<byte>& IG, const Image<byte>& IB,IntPoint2 p,bool xorMode=false,double fact=1.) { display(IR,IG,IB,p.x(),p.y(),xorMode,fact);    }
@@ -220,11 +242,13 @@ namespace Imagine {
         Coords<2> sz=Coords<2>(I.size(d1),I.size(d2));
         Image<T> C(sz);
         Coords<dim> p=cut;
-        for (CoordsIterator<2> r=C.coordsBegin();r!=C.coordsEnd();++r) {
-            p[d1]=(*r)[0];
-            p[d2]=(*r)[1];
-            C(*r)=I(p);
-        }
+        C.forEachRow([&](T* r, size_t n, const Coords<2>& c) {
+            p[d2]=c[1];
+            for (size_t x=0;x<n;x++) {
+                p[d1]=int(x);
+                r[x]=I(p);
+            }
+        });
         return C;
     }
 
@@ -258,6 +282,8 @@ namespace Imagine {
     template <typename T, int dim> 
     Image<Color,dim> rainbow(const Image<T,dim>& I, T m, T M) 
     {
+        if (!I.isContiguous())
+            return rainbow(I.clone(),m,M);
         Image<Color,dim> c(I.sizes());
         typename Image<T,dim>::const_iterator it1 = I.begin();
         typename Image<Color,dim>::iterator it2 = c.begin();
@@ -288,6 +314,8 @@ namespace Imagine {
     template <typename T, int dim> 
     Image<byte,dim> grey(const Image<T,dim>& I, T m, T M) 
     {
+        if (!I.isContiguous())
+            return grey(I.clone(),m,M);
         Image<byte,dim> c(I.sizes());
         typename Image<T,dim>::const_iterator it1 = I.begin();
         typename Image<byte,dim>::iterator it2 = c.begin();
@@ -321,6 +349,8 @@ namespace Imagine {
     template <typename T, int dim> 
     Image<Color,dim> color(const Image<RGB<T>,dim>& I,const RGB<T>& m,const RGB<T>& M) 
     {
+        if (!I.isContiguous())
+            return color(I.clone(),m,M);
         Image<Color,dim> C(I.sizes());
         typename Image<RGB<T>,dim>::const_iterator it1 = I.begin();
         typename Image<Color,dim>::iterator it2 = C.begin();
@@ -343,6 +373,33 @@ namespace Imagine {
         return color(I,r.first,r.second);
     }
 
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    // Image expressions (see ImageExpr), evaluated first. Non template functions (save(), display()...) take them
+    // through the conversion to Image.
+    template <typename T, int dim, typename E>
+    inline Image<T> cut2D(const ImageExpr<T,dim,E>& I, const Coords<dim>& cut, int d1, int d2) {
+        return cut2D(I.eval(),cut,d1,d2);
+    }
+    template <typename T, int dim, typename E> inline Image<Color,dim> rainbow(const ImageExpr<T,dim,E>& I, T m, T M) {
+        return rainbow(I.eval(),m,M);
+    }
+    template <typename T, int dim, typename E> inline Image<Color,dim> rainbow(const ImageExpr<T,dim,E>& I) {
+        return rainbow(I.eval());
+    }
+    template <typename T, int dim, typename E> inline Image<byte,dim> grey(const ImageExpr<T,dim,E>& I, T m, T M) {
+        return grey(I.eval(),m,M);
+    }
+    template <typename T, int dim, typename E> inline Image<byte,dim> grey(const ImageExpr<T,dim,E>& I) {
+        return grey(I.eval());
+    }
+    template <typename T, int dim, typename E>
+    inline Image<Color,dim> color(const ImageExpr<RGB<T>,dim,E>& I, const RGB<T>& m, const RGB<T>& M) {
+        return color(I.eval(),m,M);
+    }
+    template <typename T, int dim, typename E> inline Image<Color,dim> color(const ImageExpr<RGB<T>,dim,E>& I) {
+        return color(I.eval());
+    }
+#endif
 
     ///@}
 }
@@ -7,6 +7,7 @@
 #include "PixelTraits.h"
 #include "Interpol.h"
 #include "Border.h"
+#include "Expr.h"
 
 namespace Imagine {
     /// \addtogroup Images
@@ -19,11 +20,64 @@ namespace Imagine {
     /// - the last object using memory frees it when it dies
     /// - use clone() when this sharing is not desired
     ///
+    /// Arithmetic operators (+, -, *, /) give expressions, computed in a single pass when assigned to an image (see ImageExpr).
+    ///
     /// \param T pixel type
     /// \param dim dimension (default=2)
-    template <typename T, int dim=2> class Image : public MultiArray<T,dim> {
+    template <typename T, int dim=2> class Image : public MultiArray<T,dim>, public ImageExpr<T,dim,Image<T,dim> > {
         typedef MultiArray<T,dim> Base;
 
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+        // Constructs an allocated image with given sizes and (nested) strides
+        Image(const Coords<dim>& sz, const FArray<size_t,dim>& stride) : Base(sz,stride) {}
+        // Fresh image with the same sizes, keeping row padding when there is some
+        Image blank() const { return this->isDense() ? Image(this->sizes(),this->stride()) : Image(this->sizes()); }
+        // Computes e into *this, which has the same sizes
+        template <typename E> void evaluate(const E& e) {
+            this->forEachRun([&](size_t o, size_t n, const Coords<dim>& c) {
+                T* r=this->data()+o;
+                const typename E::Cursor k=e.cursor(c);
+                for (size_t i=0;i<n;i++)
+                    r[i]=k[i];
+            },!(this->isContiguous() && e.isContiguous()));
+        }
+        // Calls f(a) for pixels a of *this
+        template <typename F> Image& apply(F f) {
+            this->forEachRun([&](size_t o, size_t n, const Coords<dim>&) {
+                T* a=this->data()+o;
+                for (size_t i=0;i<n;i++)
+                    f(a[i]);
+            });
+            return *this;
+        }
+        // Calls f(a,b) for pixels a and b of *this and B
+        template <typename U, typename F> Image& apply(const Image<U,dim>& B, F f) {
+            assert(this->sizes()==B.sizes());
+            this->forEachRun([&](size_t o, size_t n, const Coords<dim>& c) {
+                T* a=this->data()+o;
+                const U* b=B.data()+B.offset(c);
+                for (size_t i=0;i<n;i++)
+                    f(a[i],b[i]);
+            },!(this->isContiguous() && B.isContiguous()));
+            return *this;
+        }
+    public:
+        // Image as an expression (see Expr.h)
+        Image exprBlank() const { return blank(); }
+        template <typename U> int exprUses(const Image<U,dim>& J) const {
+            return this->totalSize()>0 && J.totalSize()>0 &&
+                   (const void*)this->data()<(const void*)J.end() && (const void*)J.data()<(const void*)this->end();
+        }
+        template <typename U> bool exprAliases(const Image<U,dim>& J) const {
+            return exprUses(J) && ((const void*)this->data()!=(const void*)J.data() || sizeof(T)!=sizeof(U) || this->stride()!=J.stride());
+        }
+        struct Cursor {
+            const T* p;
+            const T& operator[](size_t i) const { return p[i]; }
+        };
+        Cursor cursor(const Coords<dim>& c) const { Cursor k={this->data()+this->offset(c)}; return k; }
+#endif
+
     public:
         /// Scalar type.
         /// This is useful for images whose pixel type T is itself composed,
@@ -62,6 +116,15 @@ namespace Imagine {
         /// \dontinclude Images/test/test.cpp \skip images()
         /// \skipline allocated with specified size (3D alias)
         Image(int w, int h, int d) : Base(w,h,d) {}
+        /// Constructor (padded rows).
+        /// Constructs an allocated image whose rows are padded so that each one starts on a multiple of rowAlign bytes.
+        /// The padded distances are given by stride(). Arithmetic operations on such an image give padded images too.
+        /// \param sz image sizes
+        /// \param rowAlign row alignment in bytes (e.g. 64 for cache lines)
+        ///
+        /// \dontinclude Images/test/test.cpp \skip images()
+        /// \skipline padded rows
+        Image(const Coords<dim>& sz, size_t rowAlign) : Base(sz,rowAlign) {}
         /// Constructor (pre-allocated).
         /// Constructs an image of pixels of type T and dimension dim, stored at an already allocated memory. ptr contains elements (0,0,...), (1,0,...), ...
         /// Does not allocate fresh memory. Does not free given memory at object destruction unless handleDelete=true. This memory must indeed stay available 
@@ -104,6 +167,21 @@ namespace Imagine {
         /// \dontinclude Images/test/test.cpp \skip images()
         /// \skipline copy constructor
         Image(const Base& I) : Base(I) {}
+        /// Copy constructor.
+        /// Constructs an image from another one (sharing memory!)
+        /// \param I image to copy
+        Image(const Image& I) : Base(I) {}
+        /// Move constructor.
+        /// Constructs an image taking over memory of another one, which becomes empty
+        /// \param I image to move from
+        /// 
+        /// \dontinclude Images/test/test.cpp \skip images()
+        /// \skipline move constructor
+        Image(Base&& I) : Base(std::move(I)) {}
+        /// Move constructor.
+        /// Constructs an image taking over memory of another one, which becomes empty
+        /// \param I image to move from
+        Image(Image&& I) : Base(std::move(static_cast<Base&>(I))) {}
         /// Constructor (different type).
         /// Constructs an image of type T from one of another type (thus without sharing memory!)
         /// \param I image to copy
@@ -113,6 +191,14 @@ namespace Imagine {
         /// \skipline from different type
         /// \until ...
         template <typename T2> Image(const MultiArray<T2,dim> &I) : Base(I) {}
+        /// Constructor (expression).
+        /// Constructs an image by computing an image expression, in a single pass (see ImageExpr)
+        /// \param e expression
+        /// \tparam E actual expression type
+        /// 
+        /// \dontinclude Images/test/test.cpp \skip images()
+        /// \skipline from expression
+        template <typename E> Image(const ImageExpr<T,dim,E>& e) : Base(e.self().exprBlank()) { evaluate(e.self()); }
         /// Destructor.
         /// Reference counted desctructor: frees memory if the object is the last one to use it.
         virtual ~Image() {}
@@ -124,6 +210,24 @@ namespace Imagine {
         /// \dontinclude Images/test/test.cpp \skip images()
         /// \skipline assignment 
         Image& operator=(const Base& I) { Base::operator = (I); return *this; }
+        /// Assignment.
+        /// Assigns from image (sharing its memory)
+        /// \param I image to be assigned to
+        /// \return self reference
+        Image& operator=(const Image& I) { Base::operator = (I); return *this; }
+        /// Move assignment.
+        /// Takes over memory of another image, which becomes empty
+        /// \param I image to move from
+        /// \return self reference
+        /// 
+        /// \dontinclude Images/test/test.cpp \skip images()
+        /// \skipline move assignment
+        Image& operator=(Base&& I) { Base::operator = (std::move(I)); return *this; }
+        /// Move assignment.
+        /// Takes over memory of another image, which becomes empty
+        /// \param I image to move from
+        /// \return self reference
+        Image& operator=(Image&& I) { Base::operator = (std::move(static_cast<Base&>(I))); return *this; }
         /// Assignment (different type).
         /// Assign from an image of another type (thus without sharing memory!)
         /// \param I image to copy
@@ -137,6 +241,27 @@ namespace Imagine {
             Base::operator = (I);
             return *this;
         }
+        /// Assignment (expression).
+        /// Assigns from an image expression, computed in a single pass (see ImageExpr). As for other assignments, images
+        /// that shared memory with *this are not modified: the result is written into the memory of *this only if no one
+        /// else uses it, otherwise into fresh memory.
+        /// \param e expression
+        /// \tparam E actual expression type
+        /// \return self reference
+        /// 
+        /// \dontinclude Images/test/test.cpp \skip images()
+        /// \skipline expression assignment
+        template <typename E> Image& operator= (const ImageExpr<T,dim,E>& e) {
+            const E& x=e.self();
+            if (this->sizes()==x.sizes() && this->useCount()==1+x.exprUses(*this) && !x.exprAliases(*this))
+                evaluate(x);
+            else {
+                Image C=x.exprBlank();
+                C.evaluate(x);
+                *this=std::move(C);
+            }
+            return *this;
+        }
         /// Cloning.
         /// Clones: creates a new image, with fresh memory, copying values to it
         /// \return cloned image
@@ -186,6 +311,41 @@ namespace Imagine {
         Image getSubImage(int x,int y,int z,int w,int h,int d) const {
             return this->getSubArray(Coords<3>(x,y,z),Coords<3>(w,h,d));
         }
+        /// Sub image view.
+        /// Constructs a view of a part of *this, i.e. an image <b>sharing memory</b> with *this (no copy): modifying its
+        /// pixels modifies *this. It can be used as any other image (algorithms, display...). Use clone() to get a
+        /// contiguous copy.
+        /// \param offset coordinates of first element
+        /// \param sz sizes of sub image
+        /// \return view
+        /// 
+        /// \dontinclude Images/test/test.cpp \skip images()
+        /// \skipline sub image view
+        Image getSubImageView(const Coords<dim> &offset, const Coords<dim> &sz) const {
+            return this->getSubArrayView(offset,sz);
+        }
+        /// Sub image view (2D).
+        /// Constructs a view of a part of *this, sharing memory with it.
+        /// \param x,y coordinates of first element
+        /// \param w,h sizes of sub image
+        /// \return view
+        /// 
+        /// \dontinclude Images/test/test.cpp \skip images()
+        /// \skipline sub image view 2D
+        Image getSubImageView(int x,int y,int w,int h) const {
+            return this->getSubArrayView(Coords<2>(x,y),Coords<2>(w,h));
+        }
+        /// Sub image view (3D).
+        /// Constructs a view of a part of *this, sharing memory with it.
+        /// \param x,y,z coordinates of first element
+        /// \param w,h,d sizes of sub image
+        /// \return view
+        /// 
+        /// \dontinclude Images/test/test.cpp \skip images()
+        /// \skipline sub image view 3D
+        Image getSubImageView(int x,int y,int z,int w,int h,int d) const {
+            return this->getSubArrayView(Coords<3>(x,y,z),Coords<3>(w,h,d));
+        }
         /// Interpolation.
         /// Bilinear interpolation of a pixel value. Return type depends on coordinates type (e.g double coordinates yield double of RGB<double> value)
         /// \tparam V coordinates type
@@ -254,31 +414,40 @@ namespace Imagine {
         //////////////////////////////////////////////////////////////////////////////////////////////////////////
 
         /// Sum of pixels.
-        /// Sum of pixel values. <b>Beware of overflow</b>.
+        /// Sum of pixel values, accumulated in a wider type (see SumTraits: 64 bits integers for integer pixels,
+        /// double for float ones, coordinatewise for colors and vectors). Large images are summed in parallel.
         /// \param I argument
+        /// \param compensated use Kahan compensated summation (floating point values, slower but more accurate)
         /// \return sum
         /// 
         /// \dontinclude Images/test/test.cpp \skip images()
         /// \skipline sum of pixels
-        friend inline T sum(const Image& I) {
-            return std::accumulate(I.begin(), I.end(), T(scalar_type(0)));
+        friend inline typename SumTraits<T>::type sum(const Image& I, bool compensated=false) {
+            typedef typename SumTraits<T>::type S;
+            if (I.totalSize()==0)
+                return SumTraits<T>::zero();
+            return I.template reduce<S>([=](const T* p, size_t n) { return reduceSum(p,n,compensated); },
+                                        [](const S& a, const S& b) { return S(a+b); });
         }
         /// Squared Euclidean norm.
-        /// Squared Euclidean norm of pixel values, i.e the sum of the squared norm of pixels. <b>Beware of overflow</b>.
+        /// Squared Euclidean norm of pixel values, i.e the sum of the squared norm of pixels, accumulated in a wider
+        /// type (see SumTraits). Large images are processed in parallel.
         /// \param I argument
         /// \return squared norm.
         /// 
         /// \dontinclude Images/test/test.cpp \skip images()
         /// \skipline Squared Euclidean norm
-        friend inline scalar_type norm2(const Image& I) {
-            scalar_type n = 0;
-            for (const_iterator it = I.begin() ; it != I.end() ; ++it) {
-                n += (*it) * (*it);
-            }
-            return n;
+        friend inline typename SumTraits<scalar_type>::type norm2(const Image& I) {
+            typedef typename SumTraits<scalar_type>::type S;
+            static_assert(sizeof(T)%sizeof(scalar_type)==0,"pixels must be made of scalars");
+            const size_t k=sizeof(T)/sizeof(scalar_type);
+            if (I.totalSize()==0)
+                return S(0);
+            return I.template reduce<S>([=](const T* p, size_t n) { return reduceNorm2((const scalar_type*)p,n*k); },
+                                        [](S a, S b) { return a+b; });
         }
         /// Euclidean norm.
-        /// Euclidean norm of pixel values. <b>Beware of overflow</b>.
+        /// Euclidean norm of pixel values.
         /// \param I argument
         /// \return norm.
         /// 
@@ -286,35 +455,7 @@ namespace Imagine {
         /// \skipline Euclidean norm
         friend inline scalar_type norm(const Image& I) {
             assert( !std::numeric_limits<T>::is_integer );
-            return ::sqrt(norm2(I));
-        }
-        /// Opposite.
-        /// Oppsite of an image
-        /// \return opposite 
-        /// 
-        /// \dontinclude Images/test/test.cpp \skip images()
-        /// \skipline unary -
-        Image operator-() const {
-            Image C(this->sizes());
-            iterator it3 = C.begin();
-            for (const_iterator it1 = this->begin() ; it1 != this->end() ; ++it1, ++it3)
-                *it3 = - *it1;
-            return C;
-        }
-        /// Addition.
-        /// Addition of two images
-        /// \param B image to be added to myself
-        /// \return sum 
-        /// 
-        /// \dontinclude Images/test/test.cpp \skip images()
-        /// \skipline image +
-        Image operator+(const Image& B) const {
-            assert(this->sizes()==B.sizes());
-            Image C(this->sizes());
-            iterator it3 = C.begin();
-            for (const_iterator it1 = this->begin(), it2 = B.begin() ; it1 != this->end() ; ++it1, ++it2, ++it3)
-                *it3 = *it1 + *it2;
-            return C;
+            return scalar_type(::sqrt(double(norm2(I))));
         }
         /// In place Addition.
         /// In place Addition of two images
@@ -324,26 +465,7 @@ namespace Imagine {
         /// \dontinclude Images/test/test.cpp \skip images()
         /// \skipline image +=
         Image& operator+=(const Image& B) {
-            assert(this->sizes()==B.sizes());
-            iterator it1 = this->begin();
-            for (const_iterator it2 = B.begin() ; it2 != B.end() ; ++it1, ++it2)
-                *it1+=*it2;
-            return *this;
-        }
-        /// Substraction.
-        /// Substraction of two images
-        /// \param B image to be substracted from myself
-        /// \return difference 
-        /// 
-        /// \dontinclude Images/test/test.cpp \skip images()
-        /// \skipline image -
-        Image operator-(const Image& B) const {
-            assert(this->sizes()==B.sizes());
-            Image C(this->sizes());
-            iterator it3 = C.begin();
-            for (const_iterator it1 = this->begin(), it2 = B.begin() ; it1 != this->end() ; ++it1, ++it2, ++it3)
-                *it3 = *it1 - *it2;
-            return C;
+            return apply(B,[](T& a, const T& b) { a+=b; });
         }
         /// In place substraction.
         /// In place substraction of two images
@@ -353,35 +475,8 @@ namespace Imagine {
         /// \dontinclude Images/test/test.cpp \skip images()
         /// \skipline image -=
         Image& operator-=(const Image& B) {
-            assert(this->sizes()==B.sizes());
-            iterator it1 = this->begin();
-            for (const_iterator it2 = B.begin() ; it2 != B.end() ; ++it1, ++it2)
-                *it1-=*it2;
-            return *this;
-        }
-        /// Constant addition.
-        /// Addition of a constant
-        /// \param v constant to be added to myself
-        /// \return result 
-        /// 
-        /// \dontinclude Images/test/test.cpp \skip images()
-        /// \skipline constant +
-        Image operator+(T v) const {
-            Image C(this->sizes());
-            iterator it3 = C.begin();
-            for (const_iterator it1 = this->begin() ; it1 != this->end() ; ++it1, ++it3)
-                *it3 = *it1 + v;
-            return C;
+            return apply(B,[](T& a, const T& b) { a-=b; });
         }
-        /// Constant addition.
-        /// Addition of a constant
-        /// \param v constant to be added to I
-        /// \param I image
-        /// \return result 
-        /// 
-        /// \dontinclude Images/test/test.cpp \skip images()
-        /// \skipline constant + image
-        friend inline Image operator+(T v, const Image& I) { return I+v; }
         /// In place constant addition.
         /// In place addition of a constant
         /// \param v constant to be added to myself
@@ -390,33 +485,8 @@ namespace Imagine {
         /// \dontinclude Images/test/test.cpp \skip images()
         /// \skipline constant +=
         Image& operator+=(T v){
-            for (iterator it = this->begin() ; it != this->end() ; ++it)
-                *it+=v;
-            return *this;
+            return apply([&](T& a) { a+=v; });
         }
-        /// Constant substraction.
-        /// Substraction of a constant
-        /// \param v constant to be substracted from myself
-        /// \return result 
-        /// 
-        /// \dontinclude Images/test/test.cpp \skip images()
-        /// \skipline constant -
-        Image operator-(T v) const {
-            Image C(this->sizes());
-            iterator it3 = C.begin();
-            for (const_iterator it1 = this->begin() ; it1 != this->end() ; ++it1, ++it3)
-                *it3 = *it1 - v;
-            return C;
-        }
-        /// Constant substraction.
-        /// Substraction of a constant
-        /// \param v constant from which I is to be substracted
-        /// \param I image
-        /// \return result 
-        /// 
-        /// \dontinclude Images/test/test.cpp \skip images()
-        /// \skipline constant - image
-        friend inline Image operator-(T v, const Image& I) { return (-I)+v; }
         /// In place constant substraction.
         /// In place substraction of a constant
         /// \param v constant to be substracted from myself
@@ -425,33 +495,8 @@ namespace Imagine {
         /// \dontinclude Images/test/test.cpp \skip images()
         /// \skipline constant -=
         Image& operator-=(T v){
-            for (iterator it = this->begin() ; it != this->end() ; ++it)
-                *it-=v;
-            return *this;
-        }
-        /// Scalar multiplication.
-        /// Multiplication by a scalar
-        /// \param s scalar factor
-        /// \return result 
-        /// 
-        /// \dontinclude Images/test/test.cpp \skip images()
-        /// \skipline scalar *
-        Image operator*(scalar_type s) const {
-            Image C(this->sizes());
-            iterator it3 = C.begin();
-            for (const_iterator it1 = this->begin() ; it1 != this->end() ; ++it1, ++it3)
-                *it3 = *it1 * s;
-            return C;
+            return apply([&](T& a) { a-=v; });
         }
-        /// Scalar multiplication.
-        /// Multiplication by a scalar
-        /// \param s scalar factor
-        /// \param I image
-        /// \return result 
-        /// 
-        /// \dontinclude Images/test/test.cpp \skip images()
-        /// \skipline scalar * image
-        friend inline Image operator*(scalar_type s, const Image& I) { return I*s; }
         /// In place scalar multiplication.
         /// In place multiplication by a scalar
         /// \param s scalar factor
@@ -460,23 +505,7 @@ namespace Imagine {
         /// \dontinclude Images/test/test.cpp \skip images()
         /// \skipline scalar *=
         Image& operator*=(scalar_type s){
-            for (iterator it = this->begin() ; it != this->end() ; ++it)
-                *it*=s;
-            return *this;
-        }
-        /// Scalar division.
-        /// Division by a scalar
-        /// \param s scalar factor
-        /// \return result 
-        /// 
-        /// \dontinclude Images/test/test.cpp \skip images()
-        /// \skipline scalar /
-        Image operator/(scalar_type s) const {
-            Image C(this->sizes());
-            iterator it3 = C.begin();
-            for (const_iterator it1 = this->begin() ; it1 != this->end() ; ++it1, ++it3)
-                *it3 = *it1 / s;
-            return C;
+            return apply([&](T& a) { a*=s; });
         }
         /// In place scalar division.
         /// In place division by a scalar
@@ -486,25 +515,7 @@ namespace Imagine {
         /// \dontinclude Images/test/test.cpp \skip images()
         /// \skipline scalar /=
         Image& operator/=(scalar_type s){
-            for (iterator it = this->begin() ; it != this->end() ; ++it)
-                *it/=s;
-            return *this;
-        }
-        /// Pointwise scalar multiplication.
-        /// Pointwise multiplication by a scalar image
-        /// \param B scalar image
-        /// \return result 
-        /// 
-        /// \dontinclude Images/test/test.cpp \skip images()
-        /// \skipline pointwise scalar *
-        Image operator*(const Image<scalar_type,dim>& B) const {
-            assert(this->sizes()==B.sizes());
-            Image C(this->sizes());
-            iterator it3 = C.begin();
-            typename Image<scalar_type,dim>::const_iterator it2 = B.begin();
-            for (const_iterator it1 = this->begin() ; it1 != this->end() ; ++it1, ++it2, ++it3)
-                *it3 = *it1 * *it2;
-            return C;
+            return apply([&](T& a) { a/=s; });
         }
         /// In place pointwise scalar multiplication.
         /// In place pointwise multiplication by a scalar image
@@ -514,27 +525,7 @@ namespace Imagine {
         /// \dontinclude Images/test/test.cpp \skip images()
         /// \skipline pointwise scalar *=
         Image& operator*=(const Image<scalar_type,dim>& B) {
-            assert(this->sizes()==B.sizes());
-            iterator it1 = this->begin();
-            for (typename Image<scalar_type,dim>::const_iterator it2 = B.begin() ; it2 != B.end() ; ++it1, ++it2)
-                *it1*=*it2;
-            return *this;
-        }
-        /// Pointwise scalar division.
-        /// Pointwise division by a scalar image
-        /// \param B scalar image
-        /// \return result 
-        /// 
-        /// \dontinclude Images/test/test.cpp \skip images()
-        /// \skipline pointwise scalar /
-        Image operator/(const Image<scalar_type,dim>& B) const {
-            assert(this->sizes()==B.sizes());
-            Image C(this->sizes());
-            iterator it3 = C.begin();
-            typename Image<scalar_type,dim>::const_iterator it2 = B.begin();
-            for (const_iterator it1 = this->begin() ; it1 != this->end() ; ++it1, ++it2, ++it3)
-                *it3 = *it1 / *it2;
-            return C;
+            return apply(B,[](T& a, const scalar_type& b) { a*=b; });
         }
         /// In place pointwise scalar division.
         /// In place pointwise division by a scalar image
@@ -544,11 +535,7 @@ namespace Imagine {
         /// \dontinclude Images/test/test.cpp \skip images()
         /// \skipline pointwise scalar /=
         Image& operator/=(const Image<scalar_type,dim>& B) {
-            assert(this->sizes()==B.sizes());
-            iterator it1 = this->begin();
-            for (typename Image<scalar_type,dim>::const_iterator it2 = B.begin() ; it2 != B.end() ; ++it1, ++it2)
-                *it1/=*it2;
-            return *this;
+            return apply(B,[](T& a, const scalar_type& b) { a/=b; });
         }
     };
 
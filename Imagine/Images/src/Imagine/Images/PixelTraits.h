@@ -10,11 +10,17 @@
 
 namespace Imagine {
 
-
+    // Floating point type for computations on scalars of type T: T itself, or float (double for integers of more than
+    // 16 bits) for integer types
+    template <typename T> struct RealScalar {
+        typedef typename std::conditional<!std::is_integral<T>::value, T,
+            typename std::conditional<(sizeof(T)<=2), float, double>::type>::type type;
+    };
 
     template <typename T> class PixelTraits {
     public:
         typedef T scalar_type;
+        typedef typename RealScalar<T>::type real_type;
 
         template <typename U>
         struct CastPixel
@@ -26,6 +32,7 @@ namespace Imagine {
     template <typename T, int dim> class PixelTraits< FVector<T,dim> > {
     public:
         typedef T scalar_type;
+        typedef typename RealScalar<T>::type real_type;
 
         template <typename U>
         struct CastPixel
@@ -37,6 +44,7 @@ namespace Imagine {
     template <typename T> class PixelTraits< RGB<T> > {
     public:
         typedef T scalar_type;
+        typedef typename RealScalar<T>::type real_type;
 
         template <typename U>
         struct CastPixel
@@ -48,6 +56,7 @@ namespace Imagine {
     template <typename T> class PixelTraits< RGBA<T> > {
     public:
         typedef T scalar_type;
+        typedef typename RealScalar<T>::type real_type;
 
         template <typename U>
         struct CastPixel
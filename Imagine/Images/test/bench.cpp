@@ -0,0 +1,479 @@
+// ===========================================================================
+// Imagine++ Libraries
+// Copyright (C) Imagine
+// For detailed information: http://imagine.enpc.fr/software
+// ===========================================================================
+
+// Micro benchmarks of Images functions.
+// Not a test for correctness: prints timings (and a few sanity checks) to compare implementations.
+
+#include <Imagine/Images.h>
+
+#include <iostream>
+
+using namespace std;
+using namespace Imagine;
+
+// Former image arithmetic, kept here as a reference: each operation computes a full temporary image.
+template <typename T, int dim, typename F>
+Image<T,dim> eager(const Image<T,dim>& A, const Image<T,dim>& B, F f) {
+    Image<T,dim> C(A.sizes());
+    for (size_t i=0;i<A.totalSize();i++)
+        C[i]=f(A[i],B[i]);
+    return C;
+}
+template <typename T, int dim>
+Image<T,dim> eagerScale(const Image<T,dim>& A, T s) {
+    Image<T,dim> C(A.sizes());
+    for (size_t i=0;i<A.totalSize();i++)
+        C[i]=A[i]*s;
+    return C;
+}
+
+void expressions() {
+    cout << "Chained arithmetic D=A*s+B-C on 8 megapixel float images" << endl;
+    const int w=3264, h=2448, n=20;
+    Image<float> A(w,h), B(w,h), C(w,h), D;
+    for (size_t i=0;i<A.totalSize();i++) {
+        A[i]=float(i%255);
+        B[i]=float(i%127);
+        C[i]=float(i%63);
+    }
+    const float s=0.5f;
+    auto add=[](float a, float b) { return a+b; };
+    auto sub=[](float a, float b) { return a-b; };
+    Timer t;
+    for (int i=0;i<n;i++)
+        D=eager(eager(eagerScale(A,s),B,add),C,sub);
+    double t0=t.lap();
+    float c0=D(w-1,h-1);
+    t.reset();
+    D=Image<float>();
+    for (int i=0;i<n;i++)
+        D=A*s+B-C;
+    double t1=t.lap();
+    float c1=D(w-1,h-1);
+    cout << "  temporaries " << t0/n << "s, single pass " << t1/n << "s (checksums " << c0 << ' ' << c1 << ")" << endl;
+}
+
+// Former algorithms, kept here as a reference: CoordsIterator traversal and one offset computation per pixel.
+template <typename T, int dim>
+Image<T,dim> scaleUpCoords(const Image<T,dim>&I,int fact) {
+    Image<T,dim> I1(I.sizes() * fact);
+    for (CoordsIterator<dim> r = I.coordsBegin() ; r != I.coordsEnd() ; ++r) {
+        Coords<dim> o=*r;
+        T b=I(o);
+        for (CoordsIterator<dim> zr(o * fact, o * fact + Coords<dim>(fact-1));zr!=I.coordsEnd();++zr)
+            I1(*zr)=b;
+    }
+    return I1;
+}
+template <typename T, int dim>
+Image<T,dim> scaleDownCoords(const Image<T,dim>&I,int fact) {
+    Image<T,dim> I1(I.sizes()/fact);
+    for (CoordsIterator<dim> r = I1.coordsBegin() ; r != I1.coordsEnd() ; ++r)
+        I1(*r)=I((*r)*fact);
+    return I1;
+}
+template <typename T, int dim>
+Image<T,dim> reduceCoords(const Image<T,dim>&I, int fact) {
+    typedef typename PixelTraits<T>::template CastPixel<double>::value_type doubleT;
+    Coords<dim> d=I.sizes()/fact;
+    double nb=pow(double(fact),dim);
+    Image<T,dim> Ir(d);
+    for (CoordsIterator<dim> r = Ir.coordsBegin() ; r != Ir.coordsEnd() ; ++r) {
+        doubleT p(0.);
+        for (CoordsIterator<dim> r2((*r)*fact,((*r)*fact+Coords<dim>(fact-1))); r2!=CoordsIterator<dim>(); ++r2)
+            p+=doubleT(I(*r2));
+        Ir(*r)=T(p/nb);
+    }
+    return Ir;
+}
+template <typename T, int dim>
+Image<T,dim> enlargeCoords(const Image<T,dim>&I,Coords<dim> nd) {
+    FVector<double,dim> f=div(FVector<double,dim>(I.sizes()),FVector<double,dim>(nd));
+    Image<T,dim> nI(nd);
+    for (CoordsIterator<dim> r = nI.coordsBegin() ; r != nI.coordsEnd() ; ++r) {
+        FVector<double,dim> x=mult(FVector<double,dim>(*r),f);
+        nI(*r)=T(I.interpolate(x));
+    }
+    return nI;
+}
+
+// Times n calls of former and current versions of an algorithm
+template <typename F, typename G>
+void compare(const char* name, F former, G current, int n) {
+    Timer t;
+    for (int i=0;i<n;i++)
+        former();
+    double t0=t.lap();
+    t.reset();
+    for (int i=0;i<n;i++)
+        current();
+    double t1=t.lap();
+    cout << "  " << name << ": CoordsIterator " << t0/n << "s, rows " << t1/n << "s (x" << t0/t1 << ")"
+         << (former()==current() ? "" : " MISMATCH") << endl;
+}
+
+template <typename T, int dim>
+void traversals(const Image<T,dim>& I, int n) {
+    cout << "Scalings of a " << I.sizes() << " image" << endl;
+    compare("scaleUp",   [&]() { return scaleUpCoords(I,2);   }, [&]() { return scaleUp(I,2);   }, n);
+    compare("scaleDown", [&]() { return scaleDownCoords(I,2); }, [&]() { return scaleDown(I,2); }, 20*n);
+    compare("reduce",    [&]() { return reduceCoords(I,2);    }, [&]() { return reduce(I,2);    }, n);
+    Coords<dim> nd=I.sizes()*3/2;
+    compare("enlarge",   [&]() { return enlargeCoords(I,nd);  }, [&]() { return enlarge(I,nd);  }, n);
+}
+
+long long fileSize(const char* name) {
+    ifstream in(name,ios::in|ios::binary|ios::ate);
+    return (long long)in.tellg();
+}
+
+// Ratio and throughput of saveBinary() compression (n saves and loads in each mode)
+template <typename T>
+void compression(const char* name, const Image<T>& I, int n) {
+    const char* file[2]={"bench.bin","bench.z.bin"};
+    double save[2], load[2];
+    bool same=true;
+    for (int c=0;c<2;c++) {
+        Timer t;
+        for (int i=0;i<n;i++)
+            saveBinary(I,file[c],false,c==1);
+        save[c]=t.lap()/n;
+        Image<T> J;
+        t.reset();
+        for (int i=0;i<n;i++)
+            loadBinary(J,file[c]);
+        load[c]=t.lap()/n;
+        same = same && J==I;
+    }
+    const double mb=I.totalSize()*sizeof(T)/1e6;
+    const long long raw=fileSize(file[0]), packed=fileSize(file[1]);
+    cout << "  " << name << ": " << raw << " -> " << packed << " bytes (ratio " << double(raw)/packed << "), save "
+         << mb/save[0] << " -> " << mb/save[1] << " MB/s, load " << mb/load[0] << " -> " << mb/load[1] << " MB/s"
+         << (same ? "" : " MISMATCH") << endl;
+    remove(file[0]);
+    remove(file[1]);
+}
+
+void compressions(const char* image, int n) {
+    Image<Color> C;
+    Image<byte> G;
+    if (!load(C,image) || !load(G,image)) {
+        cout << "Cannot load " << image << endl;
+        return;
+    }
+    cout << "Compressed saveBinary of " << image << " " << C.sizes() << endl;
+    Image<float> F(G.sizes());  // typical intermediate result
+    Image<short> L(G.sizes());  // label map
+    for (size_t i=0;i<G.totalSize();i++) {
+        F[i]=G[i]/255.f;
+        L[i]=short(G[i]/32);
+    }
+    compression("color",C,n);
+    compression("float",F,n);
+    compression("labels",L,n);
+}
+
+// Former reductions, kept here as a reference: one accumulator of the pixel type, single thread.
+template <typename T, int dim>
+T sumSerial(const Image<T,dim>& I) {
+    return std::accumulate(I.begin(),I.end(),T(0));
+}
+template <typename T, int dim>
+double norm2Serial(const Image<T,dim>& I) {
+    T n=0;
+    for (size_t i=0;i<I.totalSize();i++)
+        n+=I[i]*I[i];
+    return double(n);
+}
+template <typename T, int dim>
+pair<T,T> rangeSerial(const Image<T,dim>& I) {
+    pair<T,T> r(I[0],I[0]);
+    for (size_t i=1;i<I.totalSize();i++) {
+        r.first=std::min(r.first,I[i]);
+        r.second=std::max(r.second,I[i]);
+    }
+    return r;
+}
+
+// Times n calls of f, returns time per call
+template <typename F>
+double timeOf(F f, int n) {
+    Timer t;
+    for (int i=0;i<n;i++)
+        f();
+    return t.lap()/n;
+}
+
+template <typename T>
+void reduction(const char* name, const Image<T>& I, int n) {
+    volatile double sink=0;
+    const double s0=timeOf([&]() { sink=sink+double(sumSerial(I)); },n),
+        s1=timeOf([&]() { sink=sink+double(sum(I)); },n),
+        n0=timeOf([&]() { sink=sink+norm2Serial(I); },n),
+        n1=timeOf([&]() { sink=sink+double(norm2(I)); },n),
+        r0=timeOf([&]() { sink=sink+double(rangeSerial(I).second); },n),
+        r1=timeOf([&]() { sink=sink+double(range(I).second); },n);
+    cout << "  " << name << ": sum " << s0 << "s -> " << s1 << "s (x" << s0/s1 << "), norm2 " << n0 << "s -> " << n1
+         << "s (x" << n0/n1 << "), range " << r0 << "s -> " << r1 << "s (x" << r0/r1 << ")"
+         << (rangeSerial(I)==range(I) ? "" : " MISMATCH") << endl;
+}
+
+void reductions() {
+    cout << "Reductions of 8 megapixel images (" << Parallel::threads() << " threads)" << endl;
+    Image<byte> B(3264,2448);
+    Image<float> F(B.sizes());
+    for (size_t i=0;i<B.totalSize();i++) {
+        B[i]=byte(i%251);
+        F[i]=float(i%251)/251;
+    }
+    reduction("byte",B,20);
+    reduction("float",F,20);
+    cout << "  byte sum: former " << int(sumSerial(B)) << ", wide " << sum(B) << endl;
+}
+
+// Dispatched kernels at each CPU level supported here, single thread. Results must not depend on the level.
+void levels() {
+    cout << "CPU levels (supported: " << Cpu::name(Cpu::supported()) << ", single thread)" << endl;
+    Parallel::setThreads(1);
+    Image<byte> B(3264,2448);
+    Image<float> F(1920,1080), S(960,540);
+    for (size_t i=0;i<B.totalSize();i++)
+        B[i]=byte(i%251);
+    for (size_t i=0;i<F.totalSize();i++)
+        F[i]=float(i%251)/251;
+    for (size_t i=0;i<S.totalSize();i++)
+        S[i]=float(i%253);
+    Image<float> blur0, large0;
+    double sum0=0, norm0=0;
+    for (int l=CPU_BASELINE;l<=Cpu::supported();l++) {
+        Cpu::setLevel(CpuLevel(l));
+        volatile double sink=0;
+        Image<float> G, L;
+        const double ts=timeOf([&]() { sink=sink+double(sum(B)); },20),
+            tn=timeOf([&]() { sink=sink+norm2(F); },20),
+            tr=timeOf([&]() { sink=sink+range(F).second; },20),
+            tb=timeOf([&]() { G=blur(F,2.f); },5),
+            te=timeOf([&]() { L=enlarge(S,1920,1080); },5);
+        const double s=double(sum(B)), n=norm2(F);
+        if (l==CPU_BASELINE) {
+            sum0=s;
+            norm0=n;
+            blur0=G;
+            large0=L;
+        }
+        cout << "  " << Cpu::name(Cpu::level()) << ": byte sum " << ts*1000 << "ms, float norm2 " << tn*1000
+             << "ms, float range " << tr*1000 << "ms, blur " << tb*1000 << "ms, enlarge " << te*1000 << "ms"
+             << (s==sum0 && n==norm0 && G==blur0 && L==large0 ? "" : " MISMATCH") << endl;
+    }
+    Cpu::setLevel(Cpu::supported());
+    Parallel::setThreads(0);
+}
+
+// Former color conversions, kept here as a reference: one pixel at a time, in double precision
+void yuvSerial(const Image<Color>& I, Image<float>& Y, Image<float>& U, Image<float>& V) {
+    for (size_t i=0;i<I.totalSize();i++) {
+        const FVector<double,3> c=RGB2YUV(I[i]);
+        Y[i]=float(c[0]);
+        U[i]=float(c[1]);
+        V[i]=float(c[2]);
+    }
+}
+void greySerial(const Image<Color>& I, Image<byte>& G) {
+    for (size_t i=0;i<I.totalSize();i++)
+        G[i]=byte(I[i]);
+}
+
+void colorConversions() {
+    cout << "Color conversions of a 1920x1080 Color image (" << Parallel::threads() << " threads), Mpixel/s" << endl;
+    Image<Color> I(1920,1080);
+    for (size_t i=0;i<I.totalSize();i++)
+        I[i]=Color(byte(i%251),byte(i%241),byte(i*7%256));
+    const double mp=double(I.totalSize())/1e6;
+    Image<float> F0(I.sizes()), F1(I.sizes()), F2(I.sizes());
+    Image<byte> B0(I.sizes()), B1(I.sizes()), B2(I.sizes());
+    const double g0=timeOf([&]() { greySerial(I,B0); },20), g1=timeOf([&]() { convertColors(I,B0); },20),
+        y0=timeOf([&]() { yuvSerial(I,F0,F1,F2); },20), y1=timeOf([&]() { convertColors(I,COLOR_YUV,F0,F1,F2); },20);
+    cout << "  grey (byte): " << mp/g0 << " -> " << mp/g1 << " (x" << g0/g1 << ")" << endl;
+    cout << "  YUV (float): " << mp/y0 << " -> " << mp/y1 << " (x" << y0/y1 << ")" << endl;
+    const char* names[]={"grey","YUV","YCbCr","HSV","Lab"};
+    for (int s=COLOR_GREY;s<=COLOR_LAB;s++) {
+        Image<Color> J;
+        const double tf=timeOf([&]() { convertColors(I,ColorSpace(s),F0,F1,F2); },10),
+            tb=timeOf([&]() { convertColors(I,ColorSpace(s),B0,B1,B2); },10),
+            ti=timeOf([&]() { convertColors(F0,F1,F2,ColorSpace(s),J); },10);
+        cout << "  " << names[s] << ": to float " << mp/tf << ", to byte " << mp/tb << ", back from float " << mp/ti
+             << endl;
+    }
+}
+
+// Blur for 1, 2, 4... threads (up to the number of cores, at least 4)
+template <int dim>
+void blurScaling(const Image<float,dim>& I, int n) {
+    cout << "Blur of a " << I.sizes() << " image, by number of threads" << endl;
+    const int cores=int(std::thread::hardware_concurrency());
+    Image<float,dim> B0;
+    double t0=0;
+    for (int t=1;t<=std::max(4,cores);t*=2) {
+        Parallel::setThreads(t);
+        Image<float,dim> B;
+        const double tb=timeOf([&]() { B=blur(I,2.f); },n);
+        if (t==1) {
+            t0=tb;
+            B0=B;
+        }
+        cout << "  " << t << " threads: " << tb*1000 << "ms (x" << t0/tb << ")" << (B==B0 ? "" : " MISMATCH") << endl;
+    }
+    Parallel::setThreads(0);
+}
+
+// Deriche filter along the last axis (z for 3D images) for 1, 2, 4... threads: lines are shared by ranges of y, bands
+// along x being too few to occupy many cores
+template <int dim>
+void lastAxisScaling(const Image<float,dim>& I, int n) {
+    cout << "Deriche filter of a " << I.sizes() << " image along axis " << dim-1 << ", by number of threads" << endl;
+    const int cores=int(std::thread::hardware_concurrency());
+    Image<float,dim> J0;
+    double t0=0;
+    for (int t=1;t<=std::max(4,cores);t*=2) {
+        Parallel::setThreads(t);
+        Image<float,dim> J;
+        const double tb=timeOf([&]() { J=deriche(I,2.f,0,dim-1); },n);
+        if (t==1) {
+            t0=tb;
+            J0=J;
+        }
+        cout << "  " << t << " threads: " << tb*1000 << "ms (x" << t0/tb << ")" << (J==J0 ? "" : " MISMATCH") << endl;
+    }
+    Parallel::setThreads(0);
+}
+
+// Deriche filter along each axis, single thread: lines along y and z are filtered by bands of adjacent ones
+template <int dim>
+void dericheAxes(const Image<float,dim>& I, int n) {
+    cout << "Deriche filter of a " << I.sizes() << " image, by axis (single thread)" << endl;
+    Parallel::setThreads(1);
+    Image<float,dim> J=I.clone();
+    const double mp=double(I.totalSize())/1e6;
+    double t0=0;
+    for (int d=0;d<dim;d++) {
+        const double t=timeOf([&]() { inPlaceDeriche(J,2.f,0,d); },n);
+        if (d==0)
+            t0=t;
+        cout << "  axis " << d << ": " << t*1000 << "ms, " << mp/t << " Mpixel/s (x" << t0/t << " of axis 0)" << endl;
+    }
+    Parallel::setThreads(0);
+}
+
+// Former way of blurring byte images: through a float image
+Image<byte> blurThroughFloat(const Image<byte>& I, float sigma) {
+    Image<float> F(I.sizes());
+    for (size_t i=0;i<I.totalSize();i++)
+        F[i]=I[i];
+    inPlaceBlur(F,sigma);
+    Image<byte> J(I.sizes());
+    for (size_t i=0;i<I.totalSize();i++)
+        J[i]=byte(std::min(std::max(F[i],0.f),255.f)+.5f);
+    return J;
+}
+
+void byteBlur() {
+    cout << "Blur of a 1920x1080 byte image (" << Parallel::threads() << " threads)" << endl;
+    Image<byte> I(1920,1080);
+    for (size_t i=0;i<I.totalSize();i++)
+        I[i]=byte(i%251);
+    Image<byte> J0, J1;
+    const double t0=timeOf([&]() { J0=blurThroughFloat(I,2.f); },10), t1=timeOf([&]() { J1=blur(I,2.f); },10);
+    int e=0;
+    for (size_t i=0;i<I.totalSize();i++)
+        e=std::max(e,std::abs(int(J0[i])-int(J1[i])));
+    cout << "  through float " << t0*1000 << "ms, direct " << t1*1000 << "ms (x" << t0/t1 << "), max difference "
+         << e << endl;
+}
+
+// Former way of convolving: border condition evaluated for every tap
+template <typename K>
+Image<float> convolveSerial(const Image<float>& I, const K& k, int d) {
+    Image<float> J(I.sizes());
+    const int n=int(k.size());
+    for (int y=0;y<I.height();y++)
+        for (int x=0;x<I.width();x++) {
+            float s=0;
+            for (int j=0;j<n;j++) {
+                Coords<2> q(x,y);
+                q[d]+=n/2-j;
+                s+=k[j]*border(I,q,NeumannBorder<float,2>());
+            }
+            J(x,y)=s;
+        }
+    return J;
+}
+
+// Separable Gaussian FIR (13 taps, sigma=2) against the Deriche blur, and non separable 5x5 kernel
+void convolutions(const Image<float>& I, int n) {
+    cout << "Convolutions of a " << I.sizes() << " image (" << Parallel::threads() << " threads)" << endl;
+    const double mp=double(I.totalSize())/1e6;
+    Array<float> g(13);
+    float s=0;
+    for (int j=0;j<13;j++)
+        s+=g[j]=std::exp(-float((j-6)*(j-6))/8);
+    for (int j=0;j<13;j++)
+        g[j]/=s;
+    Image<float> J;
+    const double t0=timeOf([&]() { J=convolveSerial(convolveSerial(I,g,0),g,1); },2),
+        t1=timeOf([&]() { J=separableConvolve(I,g); },n), tb=timeOf([&]() { J=blur(I,2.f); },n);
+    cout << "  13 taps separable: per tap border " << mp/t0 << ", hoisted borders " << mp/t1 << " Mpixel/s (x" << t0/t1
+         << "), Deriche blur " << mp/tb << " Mpixel/s" << endl;
+    Parallel::setThreads(1);
+    for (int d=0;d<2;d++) {
+        J=I.clone();
+        const double t=timeOf([&]() { inPlaceConvolve(J,g,d); },n);
+        cout << "  13 taps along axis " << d << " (single thread): " << mp/t << " Mpixel/s" << endl;
+    }
+    Parallel::setThreads(0);
+    FArray<float,5> k;
+    k[0]=k[4]=.1f;
+    k[1]=k[3]=.2f;
+    k[2]=.4f;
+    Image<float> K(5,5);
+    for (int y=0;y<5;y++)
+        for (int x=0;x<5;x++)
+            K(x,y)=k[x]*k[y];
+    Image<float> J5;
+    const double ts=timeOf([&]() { J5=separableConvolve(I,k); },n), tn=timeOf([&]() { J=convolve(I,K); },n);
+    float e=0;
+    for (size_t i=0;i<J.totalSize();i++)
+        e=std::max(e,std::abs(J[i]-J5[i]));
+    cout << "  5x5: separable " << mp/ts << ", non separable " << mp/tn << " Mpixel/s, max difference " << e << endl;
+}
+
+int main() {
+    expressions();  // Expression templates
+    Image<float> I(1920,1080);
+    for (size_t i=0;i<I.totalSize();i++)
+        I[i]=float(i%251);
+    traversals(I,20);   // Row traversals
+    Image<float,3> V(128,128,128);
+    for (size_t i=0;i<V.totalSize();i++)
+        V[i]=float(i%251);
+    traversals(V,4);
+    compressions(srcPath("test.jpg"),50);   // Binary compression
+    compressions(srcPath("sup.png"),50);
+    compressions(srcPath("ryu.gif"),10);
+    reductions();   // Sums, norms, ranges
+    levels();       // Runtime CPU dispatch
+    colorConversions();     // Batched color conversions
+    blurScaling(I,10);      // Multithreaded blur
+    Image<float,3> W(256,256,256);
+    for (size_t i=0;i<W.totalSize();i++)
+        W[i]=float(i%251);
+    blurScaling(W,2);
+    dericheAxes(I,10);      // Deriche filter along y and z
+    dericheAxes(W,2);
+    lastAxisScaling(W,2);   // Deriche filter along z, multithreaded
+    byteBlur();             // Blur of byte images
+    convolutions(I,10);     // FIR convolutions
+    return 0;
+}
@@ -25,6 +25,7 @@ void images() {
     Image<byte> F(t2,Coords<2>(2,3),true);  // ...
     Image<byte> G(t1,2,3);                  // pre-allocated, 2D
     Image<byte,3> H(t1,2,3,1);              // pre-allocated, 3D
+    Image<float> Pd(Coords<2>(10,10),64);   // padded rows
     Image<byte>I(E);                        // copy constructor
     Image<byte>Jb(20,20);                   // from different type
     for(int i=0; i<Jb.height(); i++)
@@ -38,12 +39,17 @@ void images() {
     Image<RGB<double> >Jcd(Jcb);            // ...
     A=E;                                    // assignment
     A=E.clone();                            // cloning (fresh memory)
+    Image<byte>Im(std::move(A));            // move constructor
+    A=std::move(Im);                        // move assignment
     Jd=Jb;                                  // different type assignment
     Jcd=Jcb;                                // ...
     A.fill(12);                             // filling with constant value
     A=C.getSubImage(Coords<2>(1,1),Coords<2>(10,10));   // sub image
     A=C.getSubImage(1,1,10,10);                         // sub image 2D
     H=D.getSubImage(1,1,1,10,10,10);                    // sub image 3D
+    A=C.getSubImageView(Coords<2>(1,1),Coords<2>(10,10));   // sub image view (shared memory)
+    A=C.getSubImageView(1,1,10,10);                         // sub image view 2D
+    H=D.getSubImageView(1,1,1,10,10,10);                    // sub image view 3D
 
     float v1=Jb.interpolate(1.2f,3.7f);                         // interpolation
     RGB<double> v2=Jcb.interpolate(FVector<double,2>(1.2,3.7)); // ...
@@ -57,6 +63,13 @@ void images() {
     cout << sum(Jd) << ' ' << sum(Jcd) << endl;         // sum of pixels
     cout << norm2(Jd) << ' ' << norm2(Jcd) <<  endl;    // squared Euclidean norm
     cout << norm(Jd) <<  ' ' << norm(Jcd) << endl;      // Euclidean norm
+    Image<byte> Wb(1000,1000);                          // wide accumulators (no byte overflow)
+    Wb.fill(255);                                       // ...
+    assert(sum(Wb)==255000000ULL && norm2(Wb)==65025000000ULL);             // ...
+    Image<float> Wf(1000,1000);                         // compensated sum
+    Wf.fill(0.1f);                                      // ...
+    cout << sum(Wf) << ' ' << sum(Wf,true) << endl;     // ...
+    assert(range(Wb.getSubImageView(1,1,500,500))==make_pair(byte(255),byte(255)));   // range of view
 
     Image< RGB<double> >O(20,20),P(20,20);
     O.fill(RGB<double>(1.,3.,5.));
@@ -83,6 +96,11 @@ void images() {
     O*=Q;                           // pointwise scalar *=
     O=P/Q;                          // pointwise scalar /
     O/=Q;                           // pointwise scalar /=
+    Image< RGB<double> >R(P*2.+O-P/Q);  // from expression
+    R=O*2.+P-R;                     // expression assignment
+    const Image<double> Q2=eval(Q*2.);  // evaluation (for function templates taking images)
+    const Image< RGB<double> > S=blur(O-P,1.);  // functions of Imagine++ evaluate expressions
+    assert(Q2==(Q*2.).eval() && S==blur(Image< RGB<double> >(O-P),1.) && grey(Q2-Q)==grey(Q));
 }
 void io_transparency() {
     cout << "Testing IO transparency functions!" << endl;
@@ -205,10 +223,129 @@ void algos() {
     display(color(J),2*w,3*h);
     inPlaceBlur(J,FVector<double,2>(3,.01));                // in place anisotropic blur
     display(color(J),3*w,3*h);
+    Image<float,3> V(37,23,19);
+    for (size_t i=0;i<V.totalSize();i++)
+        V[i]=float(i%97);
+    Parallel::setThreads(4);
+    const Image<float,3> B=blur(V,2.f);
+    const Image< RGB<double> > K=blur(J,2.);
+    Parallel::setThreads(1);
+    assert(blur(V,2.f)==B && blur(J,2.)==K);    // same result whatever the number of threads
+    Parallel::setThreads(0);
+    Image<float> F(70,23), Ft(23,70);
+    for (int y=0;y<F.height();y++)
+        for (int x=0;x<F.width();x++)
+            F(x,y)=Ft(y,x)=float((x*y)%13);
+    const Image<float> Fy=deriche(F,2.f,1,1), Fx=deriche(Ft,2.f,1,0);
+    for (int y=0;y<F.height();y++)
+        for (int x=0;x<F.width();x++)
+            assert(Fy(x,y)==Fx(y,x));           // along y (by bands of columns) as along x
+    Image<byte> Bt(F.sizes());
+    for (size_t i=0;i<Bt.totalSize();i++)
+        Bt[i]=byte(F[i]*19);
+    const Image<byte> By=deriche(Bt,1.5f,0,1);  // byte image, filtered in float
+    const Image<float> Ry=deriche(Image<float>(Bt),1.5f,0,1);
+    for (size_t i=0;i<By.totalSize();i++)
+        assert(By[i]==byte(std::min(Ry[i],255.f)+.5f));
+    Image<long long> Ll(8,8);
+    Ll.fill(numeric_limits<long long>::max());
+    const Image<long long> Ly=deriche(Ll,1.5,0,1);   // 64 bit integers, saturated (at 2^63 in double)
+    assert(Ly(4,4)==numeric_limits<long long>::max());
+    FArray<float,3> k3;
+    k3[0]=k3[2]=.25f;
+    k3[1]=.5f;
+    Image<float> C=F.clone();
+    inPlaceConvolve(C,k3,0);                            // in place convolution
+    inPlaceConvolve(C,k3,1,NeumannBorder<float,2>());   // ...
+    const DirichletBorder<float,2> one(1.f);
+    const Image<float> Cx=convolve(F,k3,0,one);         // convolution along a dimension
+    const Image<float> Cs=separableConvolve(F,k3,MirrorBorder<float,2>());  // separable convolution
+    Image<float> K3(3,3);                               // non separable convolution
+    for (int y=0;y<3;y++)
+        for (int x=0;x<3;x++)
+            K3(x,y)=k3[x]*k3[y];
+    const Image<float> Cn=convolve(F,K3,MirrorBorder<float,2>());          // ...
+    for (int y=0;y<F.height();y++)
+        for (int x=0;x<F.width();x++) {
+            const float cx=.25f*border(F,x-1,y,one)+.5f*F(x,y)+.25f*border(F,x+1,y,one);
+            assert(std::abs(Cx(x,y)-cx)<1e-4f && std::abs(Cn(x,y)-Cs(x,y))<1e-4f);
+            if (x>0 && y>0 && x<F.width()-1 && y<F.height()-1)
+                assert(std::abs(C(x,y)-Cs(x,y))<1e-4f);     // borders aside, same result
+        }
+    Image<float> L(21,21);                              // correlation (e.g. template matching)
+    for (size_t i=0;i<L.totalSize();i++)                // ...
+        L[i]=float(i%5)/100;                            // ...
+    const MirrorBorder<float,2> mirror;                 // ...
+    const Image<float> Cr=correlate(F,L,mirror);        // ... (by FFT for large kernels)
+    for (int y=0;y<F.height();y++)
+        for (int x=0;x<F.width();x++) {
+            float cr=0;
+            for (int j=0;j<21;j++)
+                for (int i=0;i<21;i++)
+                    cr+=L(i,j)*border(F,x+i-10,y+j-10,mirror);
+            assert(std::abs(Cr(x,y)-cr)<1e-3f*(1+cr));
+        }
+    Image< RGB<double> > Fc(F.sizes());
+    Image<Color> Bc(F.sizes());
+    for (size_t i=0;i<F.totalSize();i++) {
+        Fc[i]=RGB<double>(F[i],2*F[i],1);
+        Bc[i]=Color(byte(F[i]),byte(20-F[i]),byte(3*F[i]));
+    }
+    const Image< RGB<double> > Cc=convolve(Fc,K3,MirrorBorder<RGB<double>,2>());   // color pixels
+    const Image<Color> Rc=correlate(Bc,L);                                          // ...
+    const Image<float> Rf=correlate(F,L);
+    for (size_t i=0;i<F.totalSize();i++)
+        assert(std::abs(Cc[i].r()-Cn[i])<1e-4 && std::abs(Cc[i].g()-2*Cn[i])<1e-4 && std::abs(Cc[i].b()-1)<1e-9 &&
+               std::abs(Rc[i].r()-Rf[i])<=.5f+1e-3f);
     anyClick();
     closeWindow(W);
 }
 
+void colors() {
+    cout << "Testing color conversions!" << endl;
+    Image<Color> I(256,256);
+    for (int y=0;y<256;y++)
+        for (int x=0;x<256;x++)
+            I(x,y)=Color(byte(x),byte(y),byte(x^y));
+    Image<byte> G;
+    convertColors(I,G);                                 // conversion to grey
+    Image<float> Y,U,V;
+    convertColors(I,COLOR_YUV,Y,U,V);                   // conversion to planes (float)
+    Image<byte> H,S,B;                                  // ...
+    convertColors(I,COLOR_HSV,H,S,B);                   // ... (byte)
+    Image<Color> J;
+    convertColors(Y,U,V,COLOR_YUV,J);                   // conversion from planes
+    assert(J==I);
+    for (int y=0;y<256;y++)
+        for (int x=0;x<256;x++) {
+            const Color c=I(x,y);
+            const FVector<double,3> yuv=RGB2YUV(c);
+            assert(std::abs(G(x,y)-(0.3*c.r()+0.59*c.g()+0.11*c.b()))<=0.5001);
+            assert(std::abs(Y(x,y)-yuv[0])<1e-3 && std::abs(U(x,y)-yuv[1])<1e-3 && std::abs(V(x,y)-yuv[2])<1e-3);
+            assert(B(x,y)==std::max(c.r(),std::max(c.g(),c.b())));
+        }
+    Image<AlphaColor> A(I.sizes());
+    for (size_t i=0;i<A.totalSize();i++)
+        A[i]=AlphaColor(I[i].r(),I[i].g(),I[i].b());
+    Image<float> L,a,b;
+    convertColors(A,COLOR_LAB,L,a,b);
+    Image<AlphaColor> A2;
+    convertColors(L,a,b,COLOR_LAB,A2);
+    assert(A2==A && std::abs(L(0,0))<1e-3);
+    Image< RGBA<float> > F(I.sizes()), F2;
+    for (size_t i=0;i<F.totalSize();i++)
+        F[i]=RGBA<float>(I[i].r(),I[i].g(),I[i].b());
+    convertColors(F,COLOR_YUV,Y,U,V);
+    convertColors(Y,U,V,COLOR_YUV,F2);                  // ... (float, opaque alpha 255)
+    Y(1,0)=1e6f;
+    Image< RGB<short> > Is;
+    convertColors(Y,U,V,COLOR_YUV,Is);                  // ... (short, rounded and saturated)
+    for (size_t i=0;i<F.totalSize();i++) {
+        assert(F2[i].a()==255 && std::abs(F2[i].r()-F[i].r())<1e-3f && std::abs(F2[i].b()-F[i].b())<1e-3f);
+        assert(i==1 ? Is[i].g()==32767 : Is[i].r()==I[i].r() && Is[i].g()==I[i].g() && Is[i].b()==I[i].b());
+    }
+}
+
 void schemes(){
     cout << "Testing PDE schemes" << endl;
     Image<double,3> u(64,64,64);
@@ -252,6 +389,7 @@ int main() {
     images();       // images
     io();           // files / display
     algos();        // algos
+    colors();       // color conversions
     schemes();      // PDE schemes (used by level set methods, ...)
     io_transparency(); //Images with alpha channel
     endGraphics();
@@ -19,6 +19,7 @@
 /// @}
 
 #include "LinAlg/MyEigen.h"
+#include "LinAlg/Fixed.h"       // fixed size solvers
 #include "LinAlg/Vector.h"      // Vector
 #include "LinAlg/Matrix.h"      // Matrix
 #include "LinAlg/SymMatrix.h"   // SymMatrix
@@ -0,0 +1,310 @@
+// ===========================================================================
+// Imagine++ Libraries
+// Copyright (C) Imagine
+// For detailed information: http://imagine.enpc.fr/software
+// ===========================================================================
+
+
+namespace Imagine {
+    /// \addtogroup LinAlg
+    /// @{
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    // Fixed size factorizations used by FMatrix functions (inverseFMatrix, linSolve, svd, QR, cholesky...).
+    // Column major storage as in FMatrix: element (i,j) of an MxN matrix is a[i+M*j]. Sizes being template
+    // parameters, loops have constant bounds (unrolled by the compiler for small sizes) and work arrays are on the
+    // stack: no heap allocation, no call to the Eigen wrappers.
+
+    // In place LU factorization with partial pivoting: PA=LU, L with unit diagonal. Row k was swapped with row p[k]
+    // at step k. Returns the sign of the permutation, 0 if singular.
+    template <typename T,int N>
+    inline int fixedLU(T* a, int* p) {
+        int sign=1;
+        for (int k=0;k<N;k++) {
+            int m=k;
+            T big=std::abs(a[k+N*k]);
+            for (int i=k+1;i<N;i++)
+                if (std::abs(a[i+N*k])>big) {
+                    big=std::abs(a[i+N*k]);
+                    m=i;
+                }
+            p[k]=m;
+            if (big==T(0))
+                return 0;
+            if (m!=k) {
+                sign=-sign;
+                for (int j=0;j<N;j++)
+                    std::swap(a[k+N*j],a[m+N*j]);
+            }
+            const T inv=T(1)/a[k+N*k];
+            for (int i=k+1;i<N;i++)
+                a[i+N*k]*=inv;
+            for (int j=k+1;j<N;j++) {
+                const T f=a[k+N*j];
+                for (int i=k+1;i<N;i++)
+                    a[i+N*j]-=a[i+N*k]*f;
+            }
+        }
+        return sign;
+    }
+
+    // Solves Ax=b in place, given fixedLU() of A
+    template <typename T,int N>
+    inline void fixedLUSolve(const T* a, const int* p, T* b) {
+        for (int k=0;k<N;k++)
+            std::swap(b[k],b[p[k]]);
+        for (int j=0;j<N;j++) {
+            const T f=b[j];
+            for (int i=j+1;i<N;i++)
+                b[i]-=a[i+N*j]*f;
+        }
+        for (int j=N-1;j>=0;j--) {
+            const T f=(b[j]/=a[j+N*j]);
+            for (int i=0;i<j;i++)
+                b[i]-=a[i+N*j]*f;
+        }
+    }
+
+    // 4x4 determinant and inverse by expansion in 2x2 minors of the first two and last two rows. fixedInverse4()
+    // returns the determinant, inv being left unchanged if 0.
+    template <typename T>
+    inline void fixedMinors4(const T* a, T* s, T* c) {
+        s[0]=a[0]*a[5]-a[1]*a[4];   s[1]=a[0]*a[9]-a[1]*a[8];   s[2]=a[0]*a[13]-a[1]*a[12];
+        s[3]=a[4]*a[9]-a[5]*a[8];   s[4]=a[4]*a[13]-a[5]*a[12]; s[5]=a[8]*a[13]-a[9]*a[12];
+        c[0]=a[2]*a[7]-a[3]*a[6];   c[1]=a[2]*a[11]-a[3]*a[10]; c[2]=a[2]*a[15]-a[3]*a[14];
+        c[3]=a[6]*a[11]-a[7]*a[10]; c[4]=a[6]*a[15]-a[7]*a[14]; c[5]=a[10]*a[15]-a[11]*a[14];
+    }
+    template <typename T>
+    inline T fixedDet4(const T* a) {
+        T s[6],c[6];
+        fixedMinors4(a,s,c);
+        return s[0]*c[5]-s[1]*c[4]+s[2]*c[3]+s[3]*c[2]-s[4]*c[1]+s[5]*c[0];
+    }
+    template <typename T>
+    inline T fixedInverse4(const T* a, T* inv) {
+        T s[6],c[6];
+        fixedMinors4(a,s,c);
+        const T d=s[0]*c[5]-s[1]*c[4]+s[2]*c[3]+s[3]*c[2]-s[4]*c[1]+s[5]*c[0];
+        if (d==T(0))
+            return d;
+        const T id=T(1)/d;
+        inv[0] =( a[5]*c[5]-a[9]*c[4]+a[13]*c[3])*id;
+        inv[4] =(-a[4]*c[5]+a[8]*c[4]-a[12]*c[3])*id;
+        inv[8] =( a[7]*s[5]-a[11]*s[4]+a[15]*s[3])*id;
+        inv[12]=(-a[6]*s[5]+a[10]*s[4]-a[14]*s[3])*id;
+        inv[1] =(-a[1]*c[5]+a[9]*c[2]-a[13]*c[1])*id;
+        inv[5] =( a[0]*c[5]-a[8]*c[2]+a[12]*c[1])*id;
+        inv[9] =(-a[3]*s[5]+a[11]*s[2]-a[15]*s[1])*id;
+        inv[13]=( a[2]*s[5]-a[10]*s[2]+a[14]*s[1])*id;
+        inv[2] =( a[1]*c[4]-a[5]*c[2]+a[13]*c[0])*id;
+        inv[6] =(-a[0]*c[4]+a[4]*c[2]-a[12]*c[0])*id;
+        inv[10]=( a[3]*s[4]-a[7]*s[2]+a[15]*s[0])*id;
+        inv[14]=(-a[2]*s[4]+a[6]*s[2]-a[14]*s[0])*id;
+        inv[3] =(-a[1]*c[3]+a[5]*c[1]-a[9]*c[0])*id;
+        inv[7] =( a[0]*c[3]-a[4]*c[1]+a[8]*c[0])*id;
+        inv[11]=(-a[3]*s[3]+a[7]*s[1]-a[11]*s[0])*id;
+        inv[15]=( a[2]*s[3]-a[6]*s[1]+a[10]*s[0])*id;
+        return d;
+    }
+
+    // In place LDL^T factorization of a symmetric positive definite matrix (only lower part is read): L (unit
+    // diagonal) in strictly lower part, D on diagonal. Returns false if not positive definite.
+    template <typename T,int N>
+    inline bool fixedLDLT(T* a) {
+        for (int j=0;j<N;j++) {
+            T d=a[j+N*j];
+            for (int k=0;k<j;k++)
+                d-=a[j+N*k]*a[j+N*k]*a[k+N*k];
+            if (!(d>T(0)))
+                return false;
+            a[j+N*j]=d;
+            for (int i=j+1;i<N;i++) {
+                T s=a[i+N*j];
+                for (int k=0;k<j;k++)
+                    s-=a[i+N*k]*a[j+N*k]*a[k+N*k];
+                a[i+N*j]=s/d;
+            }
+        }
+        return true;
+    }
+
+    // In place Householder QR of MxN matrix, M>=N: R in upper part, k-th reflector I-beta[k]*v*v^T with v=(1,v1..)
+    // stored under the diagonal of column k
+    template <typename T,int M,int N>
+    inline void fixedHouseholder(T* a, T* beta) {
+        for (int k=0;k<N;k++) {
+            T s=0;
+            for (int i=k+1;i<M;i++)
+                s+=a[i+M*k]*a[i+M*k];
+            const T x=a[k+M*k];
+            if (s==T(0)) {          // nothing to eliminate
+                beta[k]=0;
+                continue;
+            }
+            const T n=std::sqrt(x*x+s), alpha=(x>T(0)) ? -n : n, v=x-alpha;
+            beta[k]=2*v*v/(v*v+s);
+            a[k+M*k]=alpha;
+            for (int i=k+1;i<M;i++)
+                a[i+M*k]/=v;
+            for (int j=k+1;j<N;j++) {
+                T w=a[k+M*j];
+                for (int i=k+1;i<M;i++)
+                    w+=a[i+M*k]*a[i+M*j];
+                w*=beta[k];
+                a[k+M*j]-=w;
+                for (int i=k+1;i<M;i++)
+                    a[i+M*j]-=w*a[i+M*k];
+            }
+        }
+    }
+
+    // Applies k-th reflector of fixedHouseholder() to vector b of size M
+    template <typename T,int M>
+    inline void fixedReflect(const T* a, T beta, int k, T* b) {
+        if (beta==T(0))
+            return;
+        T w=b[k];
+        for (int i=k+1;i<M;i++)
+            w+=a[i+M*k]*b[i];
+        w*=beta;
+        b[k]-=w;
+        for (int i=k+1;i<M;i++)
+            b[i]-=w*a[i+M*k];
+    }
+
+    // First K columns of Q from fixedHouseholder()
+    template <typename T,int M,int N,int K>
+    inline void fixedHouseholderQ(const T* a, const T* beta, T* q) {
+        for (int j=0;j<K;j++) {
+            T* c=q+M*j;
+            for (int i=0;i<M;i++)
+                c[i]=T(i==j);
+            for (int k=N-1;k>=0;k--)
+                fixedReflect<T,M>(a,beta[k],k,c);
+        }
+    }
+
+    // One sided Jacobi SVD of MxN matrix, M>=N: A=U*diag(s)*Vt, U MxM, Vt NxN, s of size N decreasing. Columns of
+    // A*V are orthogonalized by plane rotations (accumulated in V) until their dot products are negligible; column
+    // norms are then the singular values.
+    template <typename T,int M,int N>
+    inline void fixedJacobiSVD(const T* a, T* u, T* s, T* vt) {
+        T w[M*N],v[N*N];
+        for (int k=0;k<M*N;k++)
+            w[k]=a[k];
+        for (int j=0;j<N;j++)
+            for (int i=0;i<N;i++)
+                v[i+N*j]=T(i==j);
+        const T eps=std::numeric_limits<T>::epsilon();
+        for (int sweep=0;sweep<64;sweep++) {
+            bool rotated=false;
+            for (int p=0;p<N-1;p++)
+                for (int q=p+1;q<N;q++) {
+                    T alpha=0,beta=0,gamma=0;
+                    for (int i=0;i<M;i++) {
+                        alpha+=w[i+M*p]*w[i+M*p];
+                        beta+=w[i+M*q]*w[i+M*q];
+                        gamma+=w[i+M*p]*w[i+M*q];
+                    }
+                    if (std::abs(gamma)<=eps*std::sqrt(alpha*beta))
+                        continue;
+                    rotated=true;
+                    const T zeta=(beta-alpha)/(2*gamma);
+                    const T t=((zeta<T(0)) ? T(-1) : T(1))/(std::abs(zeta)+std::hypot(T(1),zeta));
+                    const T c=T(1)/std::sqrt(1+t*t), sn=c*t;
+                    for (int i=0;i<M;i++) {
+                        const T wp=w[i+M*p], wq=w[i+M*q];
+                        w[i+M*p]=c*wp-sn*wq;
+                        w[i+M*q]=sn*wp+c*wq;
+                    }
+                    for (int i=0;i<N;i++) {
+                        const T vp=v[i+N*p], vq=v[i+N*q];
+                        v[i+N*p]=c*vp-sn*vq;
+                        v[i+N*q]=sn*vp+c*vq;
+                    }
+                }
+            if (!rotated)
+                break;
+        }
+        // Sort by decreasing norm
+        T norms[N];
+        int order[N];
+        for (int j=0;j<N;j++) {
+            T n2=0;
+            for (int i=0;i<M;i++)
+                n2+=w[i+M*j]*w[i+M*j];
+            norms[j]=std::sqrt(n2);
+            order[j]=j;
+        }
+        for (int j=0;j<N;j++)
+            for (int k=j+1;k<N;k++)
+                if (norms[order[k]]>norms[order[j]])
+                    std::swap(order[j],order[k]);
+        const T tiny=norms[order[0]]*eps*M;
+        int r=0;                    // numerical rank: first r columns of U are normalized columns of A*V
+        for (int j=0;j<N;j++) {
+            const int o=order[j];
+            s[j]=norms[o];
+            for (int i=0;i<N;i++)
+                vt[j+N*i]=v[i+N*o];
+            if (norms[o]>tiny && norms[o]>T(0)) {
+                for (int i=0;i<M;i++)
+                    u[i+M*j]=w[i+M*o]/norms[o];
+                r=j+1;
+            }
+        }
+        // Complete U with the canonical vectors least aligned with previous columns (Gram-Schmidt, twice)
+        for (int j=r;j<M;j++) {
+            T* c=u+M*j;
+            T best=-1;
+            for (int e=0;e<M;e++) {
+                T x[M];
+                for (int i=0;i<M;i++)
+                    x[i]=T(i==e);
+                for (int pass=0;pass<2;pass++)
+                    for (int k=0;k<j;k++) {
+                        T d=0;
+                        for (int i=0;i<M;i++)
+                            d+=u[i+M*k]*x[i];
+                        for (int i=0;i<M;i++)
+                            x[i]-=d*u[i+M*k];
+                    }
+                T n2=0;
+                for (int i=0;i<M;i++)
+                    n2+=x[i]*x[i];
+                if (n2>best) {
+                    best=n2;
+                    for (int i=0;i<M;i++)
+                        c[i]=x[i];
+                }
+            }
+            const T n=std::sqrt(best);
+            for (int i=0;i<M;i++)
+                c[i]/=n;
+        }
+    }
+
+    // SVD of MxN matrix for any M,N: U MxM, s of size min(M,N), Vt NxN. Wide matrices are decomposed through their
+    // transpose.
+    template <typename T,int M,int N>
+    inline void fixedSVD(const T* a, T* u, T* s, T* vt) {
+        if (M>=N) {
+            fixedJacobiSVD<T,M,N>(a,u,s,vt);
+            return;
+        }
+        T at[N*M],ut[N*N],vtt[M*M];
+        for (int j=0;j<N;j++)
+            for (int i=0;i<M;i++)
+                at[j+N*i]=a[i+M*j];
+        fixedJacobiSVD<T,N,M>(at,ut,s,vtt);     // A^T=U'*S*V'^T, thus A=V'*S*U'^T
+        for (int j=0;j<M;j++)
+            for (int i=0;i<M;i++)
+                u[i+M*j]=vtt[j+M*i];
+        for (int j=0;j<N;j++)
+            for (int i=0;i<N;i++)
+                vt[i+N*j]=ut[j+N*i];
+    }
+#endif
+
+    ///@}
+}
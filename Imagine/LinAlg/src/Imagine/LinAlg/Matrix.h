@@ -56,12 +56,28 @@ namespace Imagine {
         /// \until ...
         Matrix(T* t,int M,int N,bool handleDelete=false) : Base(t,M,N,handleDelete) {}
         /// Copy constructor.
-        /// Constructs a matrix from another one (sharing memory!)
+        /// Constructs a matrix from another one (sharing memory! Unless A is not contiguous, e.g. has padded rows, in
+        /// which case values are copied to fresh contiguous memory)
         /// \param A matrix to copy
         /// 
         /// \dontinclude LinAlg/test/test.cpp \skip matrices()
         /// \skipline copy constructor
-        Matrix(const Base& A) : Base(A) {}
+        Matrix(const Base& A) : Base(A.isContiguous() ? A : A.clone()) {}
+        /// Copy constructor.
+        /// Constructs a matrix from another one (sharing memory!)
+        /// \param A matrix to copy
+        Matrix(const Matrix& A) : Base(A) {}
+        /// Move constructor.
+        /// Constructs a matrix taking over memory of another one, which becomes empty
+        /// \param A matrix to move from
+        /// 
+        /// \dontinclude LinAlg/test/test.cpp \skip matrices()
+        /// \skipline move constructor
+        Matrix(Base&& A) : Base(A.isContiguous() ? std::move(A) : A.clone()) {}
+        /// Move constructor.
+        /// Constructs a matrix taking over memory of another one, which becomes empty
+        /// \param A matrix to move from
+        Matrix(Matrix&& A) : Base(std::move(static_cast<Base&>(A))) {}
         /// Conversion from SymMatrix.
         /// Constructs a matrix from a symmetric one
         /// \param A matrix to copy
@@ -80,6 +96,14 @@ namespace Imagine {
         /// \dontinclude LinAlg/test/test.cpp \skip matrices()
         /// \skipline assignment 
         Matrix& operator=(const Matrix& A) { Base::operator=(A); return *this; }
+        /// Move assignment.
+        /// Takes over memory of another matrix, which becomes empty
+        /// \param A matrix to move from
+        /// \return self reference
+        /// 
+        /// \dontinclude LinAlg/test/test.cpp \skip matrices()
+        /// \skipline move assignment
+        Matrix& operator=(Matrix&& A) { Base::operator=(std::move(static_cast<Base&>(A))); return *this; }
         /// Cloning.
         /// Clones: creates a new matrix, with fresh memory, copying values
         /// \return cloned matrix
@@ -322,6 +346,7 @@ namespace Imagine {
         /// \dontinclude LinAlg/test/test.cpp \skip matrices()
         /// \skipline inverse
         friend Matrix inverse(const Matrix& A) {
+            ScopedTimer timer("LinAlg::inverse");
             assert(A.nrow()==A.ncol());
             Matrix invA=A.clone();
             int *pivots=new int[A.nrow()];
@@ -417,7 +442,8 @@ namespace Imagine {
         /// \skipline +
         Matrix operator +(const Matrix& B) const {
             Matrix C=clone();
-            return (C+=B);
+            C+=B;
+            return C;
         }
         /// Substraction.
         /// Substraction of two Matrix
@@ -428,7 +454,8 @@ namespace Imagine {
         /// \skipline -
         Matrix operator -(const Matrix& B) const {
             Matrix C=clone();
-            return (C-=B);
+            C-=B;
+            return C;
         }
         /// In place Addition.
         /// In place Addition of Matrix
@@ -474,7 +501,8 @@ namespace Imagine {
         /// \skipline * scalar
         Matrix operator *(T x) const {
             Matrix C=clone();
-            return (C*=x);
+            C*=x;
+            return C;
         }
         /// Scalar division.
         /// Divides each element by a scalar
@@ -485,7 +513,8 @@ namespace Imagine {
         /// \skipline / scalar
         Matrix operator /(T x) const {
             Matrix C=clone();
-            return (C/=x);
+            C/=x;
+            return C;
         }
         /// Scalar in place multiplication.
         /// Multiplies each element by a scalar
@@ -582,6 +611,7 @@ namespace Imagine {
         /// \skipline Singular value decomposition
         /// \until ...
         friend void svd(const Matrix& A,Matrix &U,Vector<T> &S, Matrix &Vt,bool all=false) {
+            ScopedTimer timer("LinAlg::svd");
             Matrix cpy=A.clone();
             U=Matrix(A.nrow(),A.nrow());
             Vt=Matrix(A.ncol(),A.ncol());
@@ -609,6 +639,7 @@ namespace Imagine {
         /// \until ...
         friend Vector<T> linSolve(const Matrix& A,const Vector<T>& b)
         {
+            ScopedTimer timer("LinAlg::linSolve");
             assert(b.size() == (size_t)A.nrow());
             if(A.nrow()==A.ncol())
             {
@@ -653,6 +684,7 @@ namespace Imagine {
         /// \skipline pseudo-inverse
         /// \until ...
         friend Matrix pseudoInverse(const Matrix& A,T tolrel=0) {
+            ScopedTimer timer("LinAlg::pseudoInverse");
             int m=A.nrow(),n=A.ncol();
             if (n > m) 
                 return transpose(pseudoInverse(transpose(A)));
@@ -681,6 +713,7 @@ namespace Imagine {
         /// \skipline QR decomposition
         /// \until ...
         friend bool QR(const Matrix& A,Matrix& Q, Matrix& R, bool all=false){
+            ScopedTimer timer("LinAlg::QR");
             assert(A.nrow()>=A.ncol());
             int info,m=A.nrow(),n=A.ncol(),qn=(all?m:n);
             if(all) {
@@ -713,6 +746,7 @@ namespace Imagine {
         /// \skipline Cholesky decomposition
         /// \until ...
         friend Matrix cholesky(const Matrix& A,bool low=true)  {
+            ScopedTimer timer("LinAlg::cholesky");
             assert(A.nrow()==A.ncol());
             Matrix b=A.clone();
             int n=A.nrow(); 
@@ -745,6 +779,7 @@ namespace Imagine {
         /// \skipline Determinant
         /// \until ...
         friend T det(const Matrix& A) {
+            ScopedTimer timer("LinAlg::det");
             assert(A.nrow()==A.ncol());
             Matrix b=A.clone();
             // LU decomposition
@@ -796,6 +831,38 @@ namespace Imagine {
         }
     };
 
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    // Text files of matrices (see saveText()): format of operator<<(), one row per line
+    template <typename T, typename U>
+    bool loadTextFile(T& obj, Matrix<U>* A, const std::string& filename) {
+        if (!TextElement<U>::fast)
+            return loadTextFile(obj,(void*)A,filename);
+        TextBuffer b(filename);
+        if (!b.isOpen())
+            return false;
+        const char* p=b.begin();
+        int m,n;
+        if (!textParse(p,b.end(),m) || !textParse(p,b.end(),n) || m<0 || n<0)
+            return false;
+        A->setSize(m,n);
+        return textRead<U>(p,b.end(),size_t(m)*n,[&](size_t k, const U& v) { (*A)(int(k/n),int(k%n))=v; });
+    }
+    template <typename T, typename U>
+    bool saveTextFile(const T& obj, const Matrix<U>* A, const std::string& filename, int precision) {
+        if (!TextElement<U>::fast)
+            return saveTextFile(obj,(const void*)A,filename,precision);
+        std::ofstream out(filename.c_str(), std::ios::out);
+        if (!out.is_open()) {
+            std::cerr << "Error: failed to open file '" << filename << "' for writing" << std::endl;
+            return false;
+        }
+        const int n=A->ncol();
+        out << A->nrow() << " " << n << std::endl;
+        return textWrite<U>(out,size_t(A->nrow())*n,size_t(n),false,
+                            [&](size_t k) -> const U& { return (*A)(int(k/n),int(k%n)); },precision);
+    }
+#endif
+
     /// Diagonal.
     /// Diagonal matrix
     /// \param d diagonal vector
@@ -835,7 +902,8 @@ namespace Imagine {
     /// Inverse of an FMatrix. If non invertible, ouptuts a message to \c cerr
     /// and returns a matrix with zeroed elements.
     /// This works for any FMatrix size, on the contrary to inverse(), the
-    /// latter being limited to N<=3.
+    /// latter being limited to N<=3. Closed form up to 4x4, LU decomposition
+    /// with partial pivoting above, without heap allocation.
     /// \param A matrix to inverse
     /// \return the inverse matrix
     /// 
@@ -848,40 +916,47 @@ namespace Imagine {
     FMatrix<T,N,N> inverseFMatrix(const FMatrix<T,N,N>& A) {
         if (N<=3)
             return inverse(A); // Direct inversion
-        FMatrix<T,N,N> invA(A);
-        // LU
-        int *pivots=new int[N];
-        int info,n=N;
-        // Inverse
-        matrixInverse(&n,invA.data(),&n,pivots,&info);
-        if (info) {
+        FMatrix<T,N,N> invA;
+        if (N==4) {
+            if (fixedInverse4(A.data(),invA.data())==T(0)) {
+                std::cerr<<"Cannot invert matrix"<<std::endl;
+                invA.fill(T(0));
+            }
+            return invA;
+        }
+        FMatrix<T,N,N> lu(A);
+        int pivots[N];
+        if (!fixedLU<T,N>(lu.data(),pivots)) {
             std::cerr<<"Cannot invert matrix"<<std::endl;
             invA.fill(T(0));
+            return invA;
+        }
+        for (int j=0;j<N;j++) {
+            T* c=invA.data()+N*j;
+            for (int i=0;i<N;i++)
+                c[i]=T(i==j);
+            fixedLUSolve<T,N>(lu.data(),pivots,c);
         }
-        delete[] pivots;
         return invA;
     }
 
     /// SVD.
-    /// Singular value decomposition. A is MxN. S is of size min(M,N) with decreasing singular values. A=U*diag(S)*Vt where U (resp. Vt) is
-    /// MxM (resp NxN) orthonormal, diag(S) is MxN with S as diagonal. If M<N (resp. M>N) then Vt (resp. U) is incompletely filled, expect all is true.
+    /// Singular value decomposition. A is MxN. S has M entries: the min(M,N) singular values, decreasing, then zeros
+    /// (S[i]=0 for i>=N if M>N). A=U*diag(S)*Vt where U (resp. Vt) is MxM (resp NxN) orthonormal, diag(S) is MxN with S
+    /// as diagonal. One sided Jacobi method, without heap allocation. U and Vt are always complete: thin and full SVD
+    /// are the same for this fixed size solver, and the last parameter (all, for dynamic size matrices) is ignored.
     /// \param A matrix
     /// \param U,S,Vt SVD output
-    /// \param all complete U and V is true
     /// 
     /// \dontinclude LinAlg/test/test.cpp \skip fmatrices()
     /// \skipline Singular value decomposition
     /// \until ...
     template <typename T,int M,int N> 
-    void svd(const FMatrix<T,M,N>& A, FMatrix<T,M,M> &U, FVector<T,M> &S, FMatrix<T,N,N> &Vt, bool all=false) {
-        FMatrix<T,M,N> cpy(A);
-        int nr=M,nc=N;
-        int info;
-        singularValuesDecomposition(all?"A":"S",&nr,&nc,cpy.data(),S.data(),U.data(),Vt.data(),&info);
-        if (info) {
-            std::cerr<<"Cannot compute SVD"<<std::endl;
-            return;
-        }
+    void svd(const FMatrix<T,M,N>& A, FMatrix<T,M,M> &U, FVector<T,M> &S, FMatrix<T,N,N> &Vt, bool /*all*/=false) {
+        T s[M<N ? M : N];
+        fixedSVD<T,M,N>(A.data(),U.data(),s,Vt.data());
+        for (int i=0;i<M;i++)
+            S[i]=(i<N) ? s[i] : T(0);
     }
 
     /// Eigenvalues calculation
@@ -892,6 +967,7 @@ namespace Imagine {
     template <typename T>
     void eigenvalues(const Matrix<T>& A, Vector<T>& wr, Vector<T>& wi)
     {
+        ScopedTimer timer("LinAlg::eigenvalues");
         assert(A.ncol()==A.nrow());
         Matrix<T> cpy = A.clone();
         wr = Vector<T>(A.nrow());
@@ -912,6 +988,9 @@ namespace Imagine {
     /// - M>N, over determined system: x=argmin_y|Ay-b|
     /// - M<N, under determined system: x=argmin_{y,Ay=b}|y|
     ///
+    /// LU decomposition with partial pivoting in the square case, Householder QR of A (resp. A^T) in the over
+    /// (resp. under) determined one, without heap allocation.
+    ///
     /// \param A matrix
     /// \param b right term
     /// \return solution (zeroed vector if no solution)
@@ -922,50 +1001,56 @@ namespace Imagine {
     template <typename T,int M,int N>
     FVector<T,N> linSolve(const FMatrix<T,M,N>& A,const FVector<T,M>& b)
     {
-        if(M==N)
-            {
-                // Linear system is not over- or under- determined
-                FMatrix<T,M,N> tmpA(A);
-                FVector<T,M> tmpb(b);
-                // LU factorization
-                int *pivots=new int[M];
-                int info,n=M;
-                // Solve linear system using factorization
-                int nrhs=1;
-                LUSystemSolve(&n,tmpA.data(),pivots,tmpb.data(),&info);
-                if (info) {
+        if (M==N) {
+            // Linear system is not over- or under- determined
+            FMatrix<T,N,N> lu(A.data());    // Safe since M==N but necessary for instantiation if M!=N
+            FVector<T,N> x(b.data());
+            int pivots[N];
+            if (!fixedLU<T,N>(lu.data(),pivots)) {
+                std::cerr<<"Cannot solve linear system"<<std::endl;
+                return FVector<T,N>(T(0));
+            }
+            fixedLUSolve<T,N>(lu.data(),pivots,x.data());
+            return x;
+        }
+        FVector<T,N> x(T(0));
+        if (M > N) {
+            // Over-determined system, least squares solution: Rx=(Q^Tb)[0..N-1]
+            FMatrix<T,M,N> qr(A);
+            FVector<T,M> c(b);
+            T beta[N];
+            fixedHouseholder<T,M,N>(qr.data(),beta);
+            for (int k=0;k<N;k++)
+                fixedReflect<T,M>(qr.data(),beta[k],k,c.data());
+            for (int i=N-1;i>=0;i--) {
+                if (qr(i,i)==T(0)) {
                     std::cerr<<"Cannot solve linear system"<<std::endl;
-                    delete [] pivots;
                     return FVector<T,N>(T(0));
-                    tmpb.fill(T(0));
-                    std::cerr<<"Cannot solve linear system"<<std::endl;
                 }
-                delete[] pivots;
-                return FVector<T,N>(tmpb.data()); //Safe since M==N but necessary for instantiation if M!=N
+                T y=c[i];
+                for (int j=i+1;j<N;j++)
+                    y-=qr(i,j)*x[j];
+                x[i]=y/qr(i,i);
             }
-        // Least-squares solution in the over-determined case, minimum norm solution in the under-determined one
-        int info,m=M,n=N,o=std::max(m,n);
-        int nrhs = 1;
-        FMatrix<T,M,N> tmpA(A);
-        if(M > N) { // Over-determined system: least squares solution
-            FVector<T,M> tmpb;
-            for (int i=0;i<m;i++) tmpb[i] = b[i];
-            QRSystemSolve(&m,&n,tmpA.data(),tmpb.data(),&info);
-            if (info) {
-                tmpb.fill(T(0));
+            return x;
+        }
+        // Under-determined system, minimum norm solution: A^T=QR, x=Q*y with R^Ty=b
+        FMatrix<T,N,M> qr=transpose(A);
+        T beta[M];
+        fixedHouseholder<T,N,M>(qr.data(),beta);
+        for (int i=0;i<M;i++) {
+            if (qr(i,i)==T(0)) {
                 std::cerr<<"Cannot solve linear system"<<std::endl;
+                return FVector<T,N>(T(0));
             }
-            return FVector<T,N>( tmpb.data() );
-        }
-        // Under-determined system (M<N): minimum norm solution
-        FVector<T,N> tmpb;
-        for (int i=0;i<m;i++) tmpb[i] = b[i];
-        QRSystemSolve(&m,&n,tmpA.data(),tmpb.data(),&info);
-        if (info) {
-            tmpb.fill(T(0));
-            std::cerr<<"Cannot solve linear system"<<std::endl;
+            T y=b[i];
+            for (int j=0;j<i;j++)
+                y-=qr(j,i)*x[j];
+            x[i]=y/qr(i,i);
         }
-        return tmpb;
+        for (int k=M-1;k>=0;k--)
+            fixedReflect<T,N>(qr.data(),beta[k],k,x.data());
+        return x;
     }
     /// Pseudo inverse.
     /// Pseudo-inverse using SVD
@@ -1002,8 +1087,11 @@ namespace Imagine {
     /// QR decomposition. A is MxN with M>=N. A=QR where:
     /// - Q is MxN with orthogonal columns
     /// - R is NxN upper triangular
+    ///
+    /// Householder reflections, without heap allocation.
     /// \param A matrix
     /// \param Q,R: output
+    /// \return true
     ///
     /// \dontinclude LinAlg/test/test.cpp \skip fmatrices()
     /// \skipline QR decomposition
@@ -1011,21 +1099,24 @@ namespace Imagine {
     template <typename T,int M,int N>
     bool QR(const FMatrix<T,M,N>& A,FMatrix<T,M,N>& Q, FMatrix<T,N,N>& R){
         assert(M>=N);
-        int info,m=M,n=N;
-        Q = A;
-        QRFactorization(&m,&n,&n,Q.data(),R.data(),&info);
-        if(info!=1) {
-            std::cerr << "Failed QR" << std::endl;
-            return false;
-        }
+        FMatrix<T,M,N> qr(A);
+        T beta[N];
+        fixedHouseholder<T,M,N>(qr.data(),beta);
+        fixedHouseholderQ<T,M,N,N>(qr.data(),beta,Q.data());
+        for (int j=0;j<N;j++)
+            for (int i=0;i<N;i++)
+                R(i,j)=(i<=j) ? qr(i,j) : T(0);
         return true;
     }
     /// QR decomposition.
     /// QR decomposition. A is MxN with M>=N. A=QR where:
     /// - Q is MxM orthogonal
     /// - R is MxN with N first rows upper diagonal and M-N last rows nul.
+    ///
+    /// Householder reflections, without heap allocation.
     /// \param A matrix
     /// \param Q,R: output
+    /// \return true
     ///
     /// \dontinclude LinAlg/test/test.cpp \skip fmatrices()
     /// \skipline QR decomposition
@@ -1033,17 +1124,18 @@ namespace Imagine {
     template <typename T,int M,int N>
     bool QRAll(const FMatrix<T,M,N>& A,FMatrix<T,M,M>& Q, FMatrix<T,M,N>& R){
         assert(M>=N);
-        int info,m=M,n=N;
-        equalize(M*N,A.data(),1,Q.data(),1);
-        QRFactorization(&m,&m,&n,Q.data(),R.data(),&info);
-        if(info!=1) {
-            std::cerr << "Failed QR" << std::endl;
-            return false;
-        }
+        R = A;
+        T beta[N];
+        fixedHouseholder<T,M,N>(R.data(),beta);
+        fixedHouseholderQ<T,M,N,M>(R.data(),beta,Q.data());
+        for (int j=0;j<N;j++)
+            for (int i=j+1;i<M;i++)
+                R(i,j)=T(0);
         return true;
     }
     /// Cholesky decomposition.
-    /// Cholesky decomposition of symmetric positive-definite matrix.
+    /// Cholesky decomposition of symmetric positive-definite matrix, computed from its LDL^T decomposition
+    /// without heap allocation.
     /// \param A matrix
     /// \param low Choose lower (default) or upper
     /// - true: A=L*L^T with L lower
@@ -1056,28 +1148,25 @@ namespace Imagine {
     template <typename T,int N>
     FMatrix<T,N,N> cholesky(const FMatrix<T,N,N>& A,bool low=true) {
         FMatrix<T,N,N> b(A);
-        int n=N;
-        int info;
-        choleskyDecomposition(low?"L":"U",&n,b.data(),&info);
-        if (info) {
+        if (!fixedLDLT<T,N>(b.data())) {
             std::cerr << "Bad cholesky" << std::endl;
             b.fill(T(0));
             return b;
         }
-        if (low) {
-            for (int j=1; j<n; j++) 
-                for (int i=0; i<j; i++) 
-                    b(i,j)=0;
-        } else {
-            for (int j=1; j<n; j++) 
-                for (int i=0; i<j; i++) 
-                    b(j,i)=0;
+        // L*sqrt(D)
+        for (int j=0; j<N; j++) {
+            const T d=std::sqrt(b(j,j));
+            b(j,j)=d;
+            for (int i=j+1; i<N; i++) {
+                b(i,j)*=d;
+                b(j,i)=0;
+            }
         }
-        return b;
+        return low ? b : transpose(b);
     }
 
     /// Determinant.
-    /// Determinant. Try Cholesky decomposition just in case. If not sym def pos, uses SVD.
+    /// Determinant. Closed form up to 4x4, LU decomposition with partial pivoting above, without heap allocation.
     /// \param A matrix
     /// \return determinant
     ///
@@ -1087,22 +1176,15 @@ namespace Imagine {
     /// \until ...
     template <typename T,int N>
     T detFMatrix(const FMatrix<T,N,N>& A) {
-        int n=N; 
+        if (N<=3)
+            return det(A);
+        if (N==4)
+            return fixedDet4(A.data());
         FMatrix<T,N,N> b(A);
-        int info;
-        // Try cholesky factorization -> only for positive matrices!
-        choleskyDecomposition((char*)"L",&n,b.data(),&info);
-        if (!info) {
-            T d=T(1);
-            for (int i=0; i<n; i++) d*=b(i,i); 
-            return d*d;
-        }
-        // Try SVD
-        FMatrix<T,N,N> U,V;
-        FVector<T,N> s;
-        svd(A,U,s,V);
-        T d=T(1);
-        for (int i=0; i<N; i++) d*=s[i]; 
+        int pivots[N];
+        T d=T(fixedLU<T,N>(b.data(),pivots));
+        for (int i=0; i<N && d!=T(0); i++)
+            d*=b(i,i);
         return d;
     }
 
@@ -48,6 +48,13 @@ namespace Imagine {
         /// \dontinclude LinAlg/test/test.cpp \skip symMatrices()
         /// \skipline copy constructor
         SymMatrix(const SymMatrix& A) : Base(A), _n(A._n) {}
+        /// Move constructor.
+        /// Constructs a symmetric matrix taking over memory of another one, which becomes empty
+        /// \param A matrix to move from
+        /// 
+        /// \dontinclude LinAlg/test/test.cpp \skip symMatrices()
+        /// \skipline move constructor
+        SymMatrix(SymMatrix&& A) : Base(std::move(static_cast<Base&>(A))), _n(A._n) { A._n=0; }
         /// Constructor (pre-allocated).
         /// Constructs an symmetric matrix from variables type T stored at an already allocated memory. t contains partial rows (0,0), (1,0), (1,1), (2,0), ...
         /// Does not allocate fresh memory. Does not free given memory at object destruction unless handleDelete=true. This memory must indeed stay available 
@@ -82,6 +89,21 @@ namespace Imagine {
         /// \dontinclude LinAlg/test/test.cpp \skip symMatrices()
         /// \skipline assignment 
         SymMatrix& operator=(const SymMatrix& A) { Base::operator =(A); _n = A._n; return *this; }
+        /// Move assignment.
+        /// Takes over memory of another symmetric matrix, which becomes empty
+        /// \param A symmetric matrix to move from
+        /// \return self reference
+        /// 
+        /// \dontinclude LinAlg/test/test.cpp \skip symMatrices()
+        /// \skipline move assignment
+        SymMatrix& operator=(SymMatrix&& A) {
+            if (this!=&A) {
+                Base::operator =(std::move(static_cast<Base&>(A)));
+                _n = A._n;
+                A._n = 0;
+            }
+            return *this;
+        }
         /// Cloning.
         /// Clones: creates a new symmetric matrix, with fresh memory, copying values to it
         /// \return cloned symmetric matrix
@@ -371,7 +393,8 @@ namespace Imagine {
         /// \skipline +
         SymMatrix operator +(const SymMatrix& B) const {
             SymMatrix C=clone();
-            return (C+=B);
+            C+=B;
+            return C;
         }
         /// In place Addition.
         /// In place Addition of SymMatrix
@@ -394,7 +417,8 @@ namespace Imagine {
         /// \skipline -
         SymMatrix operator -(const SymMatrix& B) const {
             SymMatrix C=clone();
-            return (C-=B);
+            C-=B;
+            return C;
         }
         /// In place Substraction.
         /// In place Substraction of SymMatrix
@@ -426,7 +450,8 @@ namespace Imagine {
         /// \skipline * scalar
         SymMatrix operator *(T x) const {
             SymMatrix C=clone();
-            return (C*=x);
+            C*=x;
+            return C;
         }
         /// Scalar multiplication.
         /// Multiplies each element by a scalar
@@ -446,7 +471,8 @@ namespace Imagine {
         /// \skipline / scalar
         SymMatrix operator /(T x) const {
             SymMatrix C=clone();
-            return (C/=x);
+            C/=x;
+            return C;
         }
         /// Scalar in place multiplication.
         /// Multiplies each element by a scalar
@@ -563,6 +589,39 @@ namespace Imagine {
     };
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
+    // Text files of symmetric matrices (see saveText()): format of operator<<(), whole rows. Each value is read from
+    // the lower part, which comes last in the file, as operator>>() does.
+    template <typename T, typename U>
+    bool loadTextFile(T& obj, SymMatrix<U>* A, const std::string& filename) {
+        if (!TextElement<U>::fast)
+            return loadTextFile(obj,(void*)A,filename);
+        TextBuffer b(filename);
+        if (!b.isOpen())
+            return false;
+        const char* p=b.begin();
+        int m,n;
+        if (!textParse(p,b.end(),m) || !textParse(p,b.end(),n) || m!=n || n<0)
+            return false;
+        A->setSize(n);
+        return textRead<U>(p,b.end(),size_t(n)*n,[&](size_t k, const U& v) {
+            if (int(k%n)<=int(k/n))
+                (*A)(int(k/n),int(k%n))=v;
+        });
+    }
+    template <typename T, typename U>
+    bool saveTextFile(const T& obj, const SymMatrix<U>* A, const std::string& filename, int precision) {
+        if (!TextElement<U>::fast)
+            return saveTextFile(obj,(const void*)A,filename,precision);
+        std::ofstream out(filename.c_str(), std::ios::out);
+        if (!out.is_open()) {
+            std::cerr << "Error: failed to open file '" << filename << "' for writing" << std::endl;
+            return false;
+        }
+        const int n=A->ncol();
+        out << n << " " << n << std::endl;
+        return textWrite<U>(out,size_t(n)*n,size_t(n),false,
+                            [&](size_t k) -> const U& { return (*A)(int(k/n),int(k%n)); },precision);
+    }
     // Declaration in Matrix.h
     template <typename T> 
     Matrix<T>::Matrix(const SymMatrix<T>& A) : MultiArray<T,2>(A.nrow(),A.ncol()) {
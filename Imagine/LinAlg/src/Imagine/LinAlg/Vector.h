@@ -48,6 +48,21 @@ namespace Imagine {
         /// \dontinclude LinAlg/test/test.cpp \skip vectors()
         /// \skipline copy constructor
         Vector(const Base& v) : Base(v) {}
+        /// Copy constructor.
+        /// Constructs a vector from another one (sharing memory!)
+        /// \param v vector to copy
+        Vector(const Vector& v) : Base(v) {}
+        /// Move constructor.
+        /// Constructs a vector taking over memory of another one, which becomes empty
+        /// \param v vector to move from
+        /// 
+        /// \dontinclude LinAlg/test/test.cpp \skip vectors()
+        /// \skipline move constructor
+        Vector(Base&& v) : Base(std::move(v)) {}
+        /// Move constructor.
+        /// Constructs a vector taking over memory of another one, which becomes empty
+        /// \param v vector to move from
+        Vector(Vector&& v) : Base(std::move(static_cast<Base&>(v))) {}
         /// Constructor (pre-allocated).
         /// Constructs a vector of variables of type T stored at an already allocated memory.
         /// Does not allocate fresh memory. Does not free given memory at object destruction unless handleDelete=true. This memory must indeed stay available 
@@ -71,6 +86,14 @@ namespace Imagine {
         /// \dontinclude LinAlg/test/test.cpp \skip vectors()
         /// \skipline assignment 
         Vector& operator=(const Vector& v) { Base::operator=(v); return *this; }
+        /// Move assignment.
+        /// Takes over memory of another vector, which becomes empty
+        /// \param v vector to move from
+        /// \return self reference
+        /// 
+        /// \dontinclude LinAlg/test/test.cpp \skip vectors()
+        /// \skipline move assignment
+        Vector& operator=(Vector&& v) { Base::operator=(std::move(static_cast<Base&>(v))); return *this; }
         /// Cloning.
         /// Clones: creates a new vector, with fresh memory, copying values to it
         /// \return cloned vector
@@ -137,7 +160,8 @@ namespace Imagine {
         Vector operator+(const Vector& v) const {
             assert(this->size()==v.size());
             Vector p=this->clone();
-            return (p+=v);
+            p+=v;
+            return p;
         }
         /// In place Addition.
         /// In place Addition of Vectors
@@ -161,7 +185,8 @@ namespace Imagine {
         Vector operator-(const Vector& v) const {
             assert(this->size()==v.size());
             Vector p=this->clone();
-            return (p-=v);
+            p-=v;
+            return p;
         }
         /// In place Substraction.
         /// In place Substraction of Vectors
@@ -184,7 +209,8 @@ namespace Imagine {
         /// \skipline + scalar
         Vector operator+(T x) const {
             Vector p=this->clone();
-            return (p+=x);
+            p+=x;
+            return p;
         }
         /// Scalar in place Addition.
         /// Adds a scalar to each own coordinate
@@ -207,7 +233,8 @@ namespace Imagine {
         /// \skipline - scalar
         Vector operator-(T x) const {
             Vector p=this->clone();
-            return (p-=x);
+            p-=x;
+            return p;
         }
         /// Scalar in place substractrion.
         /// Subtracts a scalar to each own coordinate
@@ -239,7 +266,8 @@ namespace Imagine {
         /// \skipline * scalar
         Vector operator*(T x) const {
             Vector p=this->clone();
-            return (p*=x);
+            p*=x;
+            return p;
         }
         /// Scalar in place multiplication.
         /// Multiplies each coordinate by a scalar
@@ -393,7 +421,8 @@ namespace Imagine {
             return sum(v)/v.size();
         }
         /// Convolution.
-        /// Convolution. Returns a vector which size if sum of sizes minus 1
+        /// Convolution. Returns a vector which size if sum of sizes minus 1. Computed by FFT for large float or double
+        /// vectors, when faster (see fftConvolve()).
         /// \param K kernel
         /// \param v vector to convolution with K
         /// \return Result
@@ -403,6 +432,8 @@ namespace Imagine {
         friend Vector convolution(const Vector& K,const Vector& v)  {
             if (v.size()<K.size()) return convolution(v,K);
             Vector p(K.size()+v.size()-1);
+            if (fftConvolve(K.data(),K.size(),v.data(),v.size(),p.data(),0,p.size()))
+                return p;
             p.fill(T(0));
             for (size_t i=0; i<v.size(); i++) {
                 combine((int)K.size(), v[i], K.data(), p.data()+i);
@@ -410,7 +441,8 @@ namespace Imagine {
             return p;
         }
         /// Truncated Convolution.
-        /// Truncated convolution. Returns a vector of the same size than v.
+        /// Truncated convolution. Returns a vector of the same size than v: values n to n+v.size()-1 of the full
+        /// convolution (see convolution()). Computed by FFT for large float or double vectors, when faster.
         /// \param K kernel
         /// \param v vector to convolution with K
         /// \param n shift
@@ -421,6 +453,8 @@ namespace Imagine {
         friend Vector truncConvolution(const Vector& K,const Vector& v, size_t n=0)  {
             assert(n<K.size());
             Vector p(v.size());
+            if (fftConvolve(K.data(),K.size(),v.data(),v.size(),p.data(),n,p.size()))
+                return p;
             p.fill(T(0));
             for (size_t i=0; i<v.size(); i++) {
                 int start = std::max((int)(0),(int)(n)-(int)(i));
@@ -429,6 +463,21 @@ namespace Imagine {
             }
             return p;
         }
+        /// Full correlation.
+        /// Correlation of v with kernel K for all overlapping shifts: value i is the sum of K[j]*v[i+j-(K.size()-1)],
+        /// i.e. the convolution by K reversed (see convolution(), computed by FFT when faster). Returns a vector which
+        /// size is sum of sizes minus 1.
+        /// \param K kernel
+        /// \param v vector to correlate with K
+        /// \return Result
+        /// 
+        /// \dontinclude LinAlg/test/test.cpp \skip vectors()
+        /// \skipline Full correlation
+        friend Vector correlate(const Vector& K,const Vector& v)  {
+            Vector R(K.size());
+            std::reverse_copy(K.begin(),K.end(),R.begin());
+            return convolution(R,v);
+        }
         /// Correlation.
         /// Correlation between 2 vectors
         /// \param V1,V2 vectors
@@ -0,0 +1,106 @@
+// ===========================================================================
+// Imagine++ Libraries
+// Copyright (C) Imagine
+// For detailed information: http://imagine.enpc.fr/software
+// ===========================================================================
+
+// Allocation counts of chained arithmetic expressions.
+// Every operator returns a fresh temporary: each one should cost exactly one heap allocation,
+// returned values being moved (not shared) along the way.
+// Fixed size solvers on FMatrix should not allocate at all.
+
+#include <Imagine/Common.h>
+#include <Imagine/LinAlg.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+using namespace Imagine;
+using namespace std;
+
+static size_t nbAllocs=0;
+
+void* operator new(size_t n) {
+    nbAllocs++;
+    void* p=malloc(n ? n : 1);
+    if (!p)
+        throw bad_alloc();
+    return p;
+}
+void operator delete(void* p) noexcept { free(p); }
+
+static int nbErrors=0;
+
+void check(const char* what, size_t allocs, size_t expected, int users) {
+    cout << what << ": " << allocs << " allocations (expected " << expected << "), "
+         << users << " user(s)" << endl;
+    if (allocs!=expected || users!=1) {
+        cout << "  -> FAILED" << endl;
+        nbErrors++;
+    }
+}
+
+void matrices() {
+    Matrix<double> A(20,20),B(20,20),C(20,20);
+    A.fill(1.); B.fill(2.); C.fill(3.);
+    size_t n0=nbAllocs;
+    Matrix<double> D=A*B;                       // one product
+    check("A*B",nbAllocs-n0,1,D.useCount());
+    n0=nbAllocs;
+    Matrix<double> E=A*B+C-A*2.;                // four temporaries
+    check("A*B+C-A*2",nbAllocs-n0,4,E.useCount());
+    n0=nbAllocs;
+    E=(-A)+B/2.;                                // three temporaries, moved into E
+    check("(-A)+B/2",nbAllocs-n0,3,E.useCount());
+}
+
+void vectors() {
+    Vector<double> a(100),b(100);
+    a.fill(1.); b.fill(2.);
+    size_t n0=nbAllocs;
+    Vector<double> c=a+b*3.-a;                  // three temporaries
+    check("a+b*3-a",nbAllocs-n0,3,c.useCount());
+    n0=nbAllocs;
+    c=-(a+b);                                   // two temporaries, moved into c
+    check("-(a+b)",nbAllocs-n0,2,c.useCount());
+}
+
+void symMatrices() {
+    SymMatrix<double> A(10),B(10);
+    A.fill(1.); B.fill(2.);
+    size_t n0=nbAllocs;
+    SymMatrix<double> C=A+B*2.;                 // two temporaries
+    check("S+S*2",nbAllocs-n0,2,C.useCount());
+}
+
+void fmatrices() {
+    FMatrix<double,6,6> A;
+    FVector<double,6> b;
+    for (int i=0;i<6;i++) {
+        b[i]=i+1;
+        for (int j=0;j<6;j++)
+            A(i,j)=(i==j) ? 10. : 1./(i+j+1);
+    }
+    FMatrix<double,4,4> A4(A.data());
+    FMatrix<double,6,4> C(A.data());
+    FMatrix<double,6,6> U,Vt;
+    FVector<double,6> S;
+    size_t n0=nbAllocs;
+    FVector<double,6> x=linSolve(A,b);
+    x+=linSolve(C,b)[0]+linSolve(transpose(C),FVector<double,4>(b.data()))[0];
+    FMatrix<double,6,6> B=inverseFMatrix(A)+cholesky(A);
+    svd(A,U,S,Vt);
+    double d=detFMatrix(A)+detFMatrix(A4)+inverseFMatrix(A4)(0,0);
+    check("FMatrix solvers",nbAllocs-n0,0,1);
+    cout << "  " << x[0]+B(0,0)+S[0]+d << endl;
+}
+
+int main() {
+    matrices();
+    vectors();
+    symMatrices();
+    fmatrices();
+    cout << (nbErrors ? "Some checks failed" : "All checks passed") << endl;
+    return nbErrors;
+}
@@ -31,6 +31,8 @@ void vectors() {
     b.fill(1.);                      // filling with constant value
     c=b;                             // assignment
     a=b.clone();                     // cloning (fresh memory)
+    Vector<T> m(std::move(a));       // move constructor
+    a=std::move(m);                  // move assignment
     c=b.getSubVect(1,2);             // sub vector
     c=b.getSubVectRef(1,2);          // sub vector ref (beware of restrictions!)
     c=a+b;                           // +
@@ -69,6 +71,19 @@ void vectors() {
     x=correlation(a,b);              // correlation
     x=normalizedCorrelation(a,b);    // normalized correlation
     double y=dist(a,b);              // distance*/
+    c=correlate(K,a);                // Full correlation
+    Vector<T> u(3000), h(300);
+    for (size_t i=0;i<u.size();i++)
+        u[i]=T(i%7);
+    for (size_t i=0;i<h.size();i++)
+        h[i]=T(1)/T(i+1);
+    c=convolution(h,u);              // (by FFT)
+    T c1=0;
+    for (size_t i=0;i<h.size();i++)
+        c1+=h[i]*u[1000-i];
+    assert(c.size()==3299 && abs(c[1000]-c1)<1e-3*abs(c1));
+    c=truncConvolution(h,u,100);
+    assert(c.size()==3000 && abs(c[900]-c1)<1e-3*abs(c1));
 }
 
 template <typename T>
@@ -89,6 +104,8 @@ void matrices() {
     Matrix<T> C(B);                      // copy constructor
     A=B;                                 // assignment
     A=B.clone();                         // cloning (fresh memory)
+    Matrix<T> M(std::move(A));           // move constructor
+    A=std::move(M);                      // move assignment
     int m=A.nrow(),n=A.ncol();           // Dimensions
     A=Matrix<T>::Zero(3,4);              // Matrix with constant 0 value
     A.fill(1);                           // filling with constant value
@@ -207,6 +224,10 @@ void matrices() {
     ifstream in("tmp.txt");  // ASCII read
     in >> A;                 // ...
     in.close(); 
+    Matrix<T> A2;
+    saveText(A,"tmp.txt");   // text file (exact)
+    loadText(A2,"tmp.txt");  // ...
+    assert(A2==A);
 
 }
 
@@ -225,6 +246,8 @@ void symMatrices() {
     SymMatrix<T> F(E);                  // conversion Matrix -> SymMatrix
     F=B;                                // assignment
     F=B.clone();                        // cloning (fresh memory)
+    SymMatrix<T> M(std::move(F));       // move constructor
+    F=std::move(M);                     // move assignment
     F.setSize(5);                       // setSize
     int nr=F.nrow(),nc=F.ncol();        // numbers of rows and columns (both equal to specified size!)
     F.fill(2);                          // filling with constant value